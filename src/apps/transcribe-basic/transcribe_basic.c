@@ -38,7 +38,8 @@ bus_callback (GstBus* bus, GstMessage* msg, gpointer data)
 
 static void
 on_transcript (GstElement* sink, gchar* transcript, gboolean is_final,
-               gdouble start_time, gdouble end_time, gpointer user_data)
+               gdouble start_time, gdouble end_time, guint channel,
+               gpointer user_data)
 {
   g_print ("[APP] %s transcript: [%.2f - %.2f] %s\n",
            is_final ? "Final" : "Partial", start_time, end_time, transcript);
@@ -48,7 +49,7 @@ on_transcript (GstElement* sink, gchar* transcript, gboolean is_final,
 
 static void
 on_word (GstElement* sink, gchar* word_text, gdouble start_time,
-         gdouble end_time, gpointer user_data)
+         gdouble end_time, guint channel, gpointer user_data)
 {
   g_print ("[APP] Word='%s'  start=%.2f  end=%.2f\n", word_text, start_time,
            end_time);
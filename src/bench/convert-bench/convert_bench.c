@@ -0,0 +1,207 @@
+#include <glib.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include "deepgramconvert.h"
+
+/* Compares deepgramsink's in-element conversion with the
+ * "audioconvert ! audioresample" chain it replaces. Every run pushes the
+ * same audiotestsrc output into a fakesink; the chain run converts in
+ * between, the converter run calls DeepgramConverter from a probe on the
+ * fakesink pad. The cost of a run without any conversion is subtracted from
+ * both, leaving CPU time per second of audio for the conversion alone. */
+
+#define BENCH_OUT_RATE          16000
+#define BENCH_SAMPLES_PER_BUFFER_MS 10
+
+typedef struct
+{
+  const gchar* format;
+  gint         rate;
+  gint         channels;
+} BenchConfig;
+
+static const BenchConfig bench_configs[] = {
+  { "F32LE", 48000, 2 },
+  { "F32LE", 48000, 1 },
+  { "S16LE", 44100, 2 },
+  { "S16LE", 48000, 1 },
+  { "S16LE", 8000, 1 },
+  { "F32LE", 16000, 1 },
+};
+
+typedef struct
+{
+  DeepgramConverter* converter;
+  guint              in_bpf;
+  gint16*            out;
+  gsize              out_cap;
+  guint64            out_frames;
+} BenchProbe;
+
+static gdouble
+bench_cpu_seconds (void)
+{
+  struct rusage ru;
+  getrusage (RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec
+         + ru.ru_stime.tv_usec / 1e6;
+}
+
+static GstPadProbeReturn
+bench_convert_probe (GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+  BenchProbe* probe  = user_data;
+  GstBuffer*  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstMapInfo  map;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return GST_PAD_PROBE_OK;
+
+  gsize in_frames = map.size / probe->in_bpf;
+  gsize max_out
+      = deepgram_converter_get_max_output (probe->converter, in_frames);
+  if (max_out > probe->out_cap)
+    {
+      probe->out_cap = max_out;
+      probe->out     = g_renew (gint16, probe->out, max_out);
+    }
+  probe->out_frames += deepgram_converter_process (probe->converter, map.data,
+                                                   in_frames, probe->out);
+  gst_buffer_unmap (buffer, &map);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Runs the pipeline to EOS and returns the CPU seconds it used. */
+static gdouble
+bench_run (const BenchConfig* config, guint seconds, gboolean chain,
+           BenchProbe* probe)
+{
+  guint samples = config->rate * BENCH_SAMPLES_PER_BUFFER_MS / 1000;
+  gchar* desc   = g_strdup_printf (
+      "audiotestsrc wave=white-noise samplesperbuffer=%u num-buffers=%u ! "
+        "audio/x-raw,format=%s,rate=%d,channels=%d,layout=interleaved ! "
+        "%s fakesink name=sink sync=false",
+      samples, seconds * 1000 / BENCH_SAMPLES_PER_BUFFER_MS, config->format,
+      config->rate, config->channels,
+      chain ? "audioconvert ! audioresample ! "
+                "audio/x-raw,format=S16LE,rate=16000,channels=1 !"
+            : "");
+
+  GError*     error    = NULL;
+  GstElement* pipeline = gst_parse_launch (desc, &error);
+  g_free (desc);
+  if (!pipeline)
+    {
+      g_printerr ("Failed to build pipeline: %s\n", error->message);
+      g_error_free (error);
+      return -1.0;
+    }
+
+  if (probe)
+    {
+      GstElement* sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+      GstPad*     pad  = gst_element_get_static_pad (sink, "sink");
+      gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, bench_convert_probe,
+                         probe, NULL);
+      gst_object_unref (pad);
+      gst_object_unref (sink);
+    }
+
+  gdouble cpu_start = bench_cpu_seconds ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  GstBus*     bus = gst_element_get_bus (pipeline);
+  GstMessage* msg = gst_bus_timed_pop_filtered (
+      bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  gdouble cpu = bench_cpu_seconds () - cpu_start;
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    {
+      gst_message_parse_error (msg, &error, NULL);
+      g_printerr ("Pipeline error: %s\n", error->message);
+      g_error_free (error);
+      cpu = -1.0;
+    }
+
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return cpu;
+}
+
+static void
+bench_config (const BenchConfig* config, guint seconds)
+{
+  BenchProbe probe = { 0 };
+
+  probe.converter = deepgram_converter_new (
+      g_str_equal (config->format, "F32LE") ? DEEPGRAM_SAMPLE_F32LE
+                                            : DEEPGRAM_SAMPLE_S16LE,
+      config->rate, config->channels, BENCH_OUT_RATE);
+  probe.in_bpf
+      = config->channels * (g_str_equal (config->format, "F32LE") ? 4 : 2);
+
+  gdouble base      = bench_run (config, seconds, FALSE, NULL);
+  gdouble chain     = bench_run (config, seconds, TRUE, NULL);
+  gdouble converter = bench_run (config, seconds, FALSE, &probe);
+
+  deepgram_converter_free (probe.converter);
+  g_free (probe.out);
+
+  if (base < 0 || chain < 0 || converter < 0)
+    return;
+
+  /* CPU ms spent converting each second of audio. */
+  gdouble chain_ms     = MAX (chain - base, 0.0) * 1000.0 / seconds;
+  gdouble converter_ms = MAX (converter - base, 0.0) * 1000.0 / seconds;
+
+  printf ("%-5s %5d Hz x%d  chain=%7.3f ms/s  deepgram=%7.3f ms/s  "
+          "speedup=%5.1fx  out=%" G_GUINT64_FORMAT " frames\n",
+          config->format, config->rate, config->channels, chain_ms,
+          converter_ms, converter_ms > 0 ? chain_ms / converter_ms : 0.0,
+          probe.out_frames);
+}
+
+int
+main (int argc, char* argv[])
+{
+  gint    seconds = 600;
+  GError* error   = NULL;
+
+  GOptionEntry entries[] = {
+    { "seconds", 's', 0, G_OPTION_ARG_INT, &seconds,
+      "Seconds of audio per run", "SECS" },
+    { NULL },
+  };
+
+  GOptionContext* ctx
+      = g_option_context_new ("- deepgramsink input conversion benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (ctx);
+      return -1;
+    }
+  g_option_context_free (ctx);
+
+  if (seconds <= 0)
+    {
+      g_printerr ("--seconds must be positive\n");
+      return -1;
+    }
+
+  printf ("simd=%s seconds=%d\n", deepgram_converter_get_simd (), seconds);
+
+  for (guint i = 0; i < G_N_ELEMENTS (bench_configs); i++)
+    bench_config (&bench_configs[i], (guint)seconds);
+
+  return 0;
+}
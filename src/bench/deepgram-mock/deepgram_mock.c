@@ -0,0 +1,932 @@
+#include "deepgram_mock.h"
+#include "deepgramsession.h"
+
+#include <libsoup/soup.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define DEEPGRAM_MOCK_DEFAULT_INTERVAL_MS 1000
+#define DEEPGRAM_MOCK_WORDS_PER_RESULT    4
+
+static const gchar* mock_words[]
+    = { "the", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog" };
+
+struct _DeepgramMock
+{
+  GThread*      thread;
+  GMainContext* context;
+  GMainLoop*    loop;
+  SoupServer*   server;
+
+  guint      requested_port;
+  guint      port;
+  guint      result_interval_ms;
+  guint      drop_after_ms;
+  guint      http_delay_ms;
+  GPtrArray* responses;
+
+  /* A recorded session to play back instead: one DeepgramMockReplay array
+   * per connection it made, handed out in turn to the connections we get.
+   * replay_speed scales the recorded timing; 0 ignores it. */
+  GPtrArray* sessions;
+  guint      next_session;
+  gdouble    replay_speed;
+
+  GMutex   lock;
+  GCond    cond;
+  gboolean started;
+  GError*  error;
+
+  /* Totals over all connections, read from other threads. */
+  _Atomic guint64 frames_received;
+  _Atomic guint64 bytes_received;
+  _Atomic guint64 results_sent;
+};
+
+/* A message the recorded connection received time ns after it opened, once
+ * it had sent audio bytes. */
+typedef struct
+{
+  guint64 time;
+  guint64 audio;
+  gchar*  text;
+} DeepgramMockReplay;
+
+typedef enum
+{
+  DEEPGRAM_MOCK_LINEAR16,
+  DEEPGRAM_MOCK_OPUS,
+  DEEPGRAM_MOCK_FLAC,
+} DeepgramMockEncoding;
+
+typedef struct
+{
+  DeepgramMock*            mock;
+  SoupWebsocketConnection* conn;
+
+  guint    rate;
+  guint    bytes_per_second;
+  gboolean interim;
+
+  /* Results are sent once per channel with multichannel=true. */
+  guint result_channels;
+
+  /* Compressed streams are not decoded; the audio they carry is read off
+   * the Ogg granule positions or the FLAC frame headers. */
+  DeepgramMockEncoding encoding;
+  guint                opus_pre_skip;
+  guint64              flac_next_frame;
+  guint64              flac_samples;
+
+  guint64 audio_bytes;
+  guint64 result_bytes;
+  guint64 interim_bytes;
+  guint   response_index;
+
+  /* Playing back a recorded session: replay_index is the next message of
+   * replay, received_bytes the binary payload received so far. */
+  GArray*  replay;
+  guint    replay_index;
+  gint64   replay_start;
+  guint64  received_bytes;
+  GSource* replay_timer;
+} DeepgramMockStream;
+
+DeepgramMock*
+deepgram_mock_new (void)
+{
+  DeepgramMock* mock = g_new0 (DeepgramMock, 1);
+
+  mock->context            = g_main_context_new ();
+  mock->loop               = g_main_loop_new (mock->context, FALSE);
+  mock->result_interval_ms = DEEPGRAM_MOCK_DEFAULT_INTERVAL_MS;
+  mock->responses          = g_ptr_array_new_with_free_func (g_free);
+  mock->sessions           = g_ptr_array_new_with_free_func (
+      (GDestroyNotify)g_array_unref);
+  mock->replay_speed = 1.0;
+
+  g_mutex_init (&mock->lock);
+  g_cond_init (&mock->cond);
+
+  return mock;
+}
+
+void
+deepgram_mock_free (DeepgramMock* mock)
+{
+  if (!mock)
+    return;
+
+  if (mock->thread)
+    {
+      g_main_loop_quit (mock->loop);
+      g_thread_join (mock->thread);
+    }
+
+  g_main_loop_unref (mock->loop);
+  g_main_context_unref (mock->context);
+  g_ptr_array_unref (mock->responses);
+  g_ptr_array_unref (mock->sessions);
+  g_clear_error (&mock->error);
+  g_mutex_clear (&mock->lock);
+  g_cond_clear (&mock->cond);
+  g_free (mock);
+}
+
+void
+deepgram_mock_set_result_interval (DeepgramMock* mock, guint interval_ms)
+{
+  mock->result_interval_ms = MAX (interval_ms, 1);
+}
+
+/* Simulates network trouble: every connection is aborted (close code 1011)
+ * once it has received drop_after_ms of audio. 0 disables. */
+void
+deepgram_mock_set_drop_after (DeepgramMock* mock, guint drop_after_ms)
+{
+  mock->drop_after_ms = drop_after_ms;
+}
+
+/* Simulates the prerecorded API's processing time: every POST is answered
+ * delay_ms after its body has arrived. */
+void
+deepgram_mock_set_http_delay (DeepgramMock* mock, guint delay_ms)
+{
+  mock->http_delay_ms = delay_ms;
+}
+
+gboolean
+deepgram_mock_load_responses (DeepgramMock* mock, const gchar* path,
+                              GError** error)
+{
+  gchar* contents = NULL;
+  if (!g_file_get_contents (path, &contents, NULL, error))
+    return FALSE;
+
+  gchar** lines = g_strsplit (contents, "\n", -1);
+  for (gchar** line = lines; *line; line++)
+    {
+      g_strstrip (*line);
+      if (**line)
+        g_ptr_array_add (mock->responses, g_strdup (*line));
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return TRUE;
+}
+
+static void
+deepgram_mock_replay_clear (gpointer data)
+{
+  g_free (((DeepgramMockReplay*)data)->text);
+}
+
+/* Loads a session log written by record-to. The messages each recorded
+ * connection received are played back on a connection of ours, each one as
+ * soon as the client has sent as much audio as had been sent when it was
+ * received and, unless speed is 0, its recorded time has come (scaled by
+ * speed, e.g. 2.0 plays back twice as fast). */
+gboolean
+deepgram_mock_load_session (DeepgramMock* mock, const gchar* path,
+                            gdouble speed, GError** error)
+{
+  DeepgramSessionReader* reader = deepgram_session_reader_new (path, error);
+  if (!reader)
+    return FALSE;
+
+  GArray*               session = NULL;
+  guint64               opened  = 0;
+  guint64               audio   = 0;
+  DeepgramSessionRecord record;
+
+  while (deepgram_session_reader_next (reader, &record))
+    {
+      if (record.event == DEEPGRAM_SESSION_CONNECTED || !session)
+        {
+          session = g_array_new (FALSE, FALSE, sizeof (DeepgramMockReplay));
+          g_array_set_clear_func (session, deepgram_mock_replay_clear);
+          g_ptr_array_add (mock->sessions, session);
+          opened = record.time;
+          audio  = 0;
+        }
+
+      if (record.event == DEEPGRAM_SESSION_SENT_AUDIO)
+        {
+          audio += record.size;
+        }
+      else if (record.event == DEEPGRAM_SESSION_RECEIVED && record.data)
+        {
+          DeepgramMockReplay message
+              = { record.time - opened, audio,
+                  g_strndup ((const gchar*)record.data, record.size) };
+          g_array_append_val (session, message);
+        }
+    }
+
+  deepgram_session_reader_free (reader);
+
+  if (mock->sessions->len == 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s holds no connection", path);
+      return FALSE;
+    }
+
+  mock->replay_speed = MAX (speed, 0.0);
+
+  return TRUE;
+}
+
+/* Appends the words of the index-th result, spread evenly over
+ * [start, end), to the words array and transcript being built. */
+static void
+deepgram_mock_append_words (GString* words, GString* transcript, guint index,
+                            gdouble start, gdouble end)
+{
+  gdouble step = (end - start) / DEEPGRAM_MOCK_WORDS_PER_RESULT;
+
+  for (guint i = 0; i < DEEPGRAM_MOCK_WORDS_PER_RESULT; i++)
+    {
+      const gchar* word
+          = mock_words[(index * DEEPGRAM_MOCK_WORDS_PER_RESULT + i)
+                       % G_N_ELEMENTS (mock_words)];
+
+      g_string_append_printf (
+          words,
+          "%s{\"word\":\"%s\",\"start\":%.3f,\"end\":%.3f,"
+          "\"confidence\":0.98,\"punctuated_word\":\"%s\"}",
+          words->len > 0 ? "," : "", word, start + i * step,
+          start + (i + 1) * step, word);
+      g_string_append_printf (transcript, "%s%s",
+                              transcript->len > 0 ? " " : "", word);
+    }
+}
+
+static gchar*
+deepgram_mock_build_result (DeepgramMockStream* stream, gdouble start,
+                            gdouble end, gboolean is_final,
+                            gboolean from_finalize, guint channel)
+{
+  GString* words      = g_string_new (NULL);
+  GString* transcript = g_string_new (NULL);
+
+  deepgram_mock_append_words (words, transcript, stream->response_index,
+                              start, end);
+
+  gchar* result = g_strdup_printf (
+      "{\"type\":\"Results\",\"channel_index\":[%u,%u],\"duration\":%.3f,"
+      "\"start\":%.3f,\"is_final\":%s,\"speech_final\":%s,"
+      "\"from_finalize\":%s,\"channel\":{\"alternatives\":[{\"transcript\":"
+      "\"%s\",\"confidence\":0.98,\"words\":[%s]}]},\"metadata\":{"
+      "\"request_id\":\"mock\",\"model_info\":{\"name\":\"mock\"}}}",
+      channel, stream->result_channels, end - start, start,
+      is_final ? "true" : "false",
+      is_final ? "true" : "false", from_finalize ? "true" : "false",
+      transcript->str, words->str);
+
+  g_string_free (words, TRUE);
+  g_string_free (transcript, TRUE);
+
+  return result;
+}
+
+static void
+deepgram_mock_send_result (DeepgramMockStream* stream, guint64 from_bytes,
+                           guint64 to_bytes, gboolean is_final,
+                           gboolean from_finalize)
+{
+  DeepgramMock* mock = stream->mock;
+
+  /* Canned responses carry their own channel_index. */
+  guint n_channels = mock->responses->len > 0 ? 1 : stream->result_channels;
+
+  for (guint channel = 0; channel < n_channels; channel++)
+    {
+      gchar* text;
+
+      if (mock->responses->len > 0)
+        {
+          text = g_strdup (g_ptr_array_index (
+              mock->responses, stream->response_index % mock->responses->len));
+        }
+      else
+        {
+          text = deepgram_mock_build_result (
+              stream, (gdouble)from_bytes / stream->bytes_per_second,
+              (gdouble)to_bytes / stream->bytes_per_second, is_final,
+              from_finalize, channel);
+        }
+
+      atomic_fetch_add_explicit (&mock->results_sent, 1, memory_order_relaxed);
+
+      soup_websocket_connection_send_text (stream->conn, text);
+      g_free (text);
+    }
+
+  if (is_final)
+    stream->response_index++;
+}
+
+static guint32
+deepgram_mock_le32 (const guint8* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32)p[3] << 24);
+}
+
+/* Audio position of an Ogg Opus stream after the pages in data. */
+static guint64
+deepgram_mock_opus_position (DeepgramMockStream* stream, const guint8* data,
+                             gsize size, guint64 position)
+{
+  while (size >= 27 && memcmp (data, "OggS", 4) == 0)
+    {
+      guint   n_segments = data[26];
+      gsize   header     = 27 + n_segments;
+      gsize   body       = 0;
+      guint64 granule    = deepgram_mock_le32 (data + 6)
+                        | (guint64)deepgram_mock_le32 (data + 10) << 32;
+
+      if (size < header)
+        break;
+      for (guint i = 0; i < n_segments; i++)
+        body += data[27 + i];
+      if (size < header + body)
+        break;
+
+      if (body >= 12 && memcmp (data + header, "OpusHead", 8) == 0)
+        stream->opus_pre_skip = data[header + 10] | (data[header + 11] << 8);
+      else if (granule != G_MAXUINT64 && granule > stream->opus_pre_skip)
+        position = (granule - stream->opus_pre_skip) * stream->rate / 48000;
+
+      data += header + body;
+      size -= header + body;
+    }
+
+  return position;
+}
+
+static guint8
+deepgram_mock_crc8 (const guint8* data, gsize size)
+{
+  guint8 crc = 0;
+  for (gsize i = 0; i < size; i++)
+    {
+      crc ^= data[i];
+      for (guint j = 0; j < 8; j++)
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  return crc;
+}
+
+/* Samples in the FLAC frame whose header starts at data, or 0 if this is
+ * not the next frame's header. Fixed-blocksize streams number their frames,
+ * which together with the header CRC rules out false syncs. */
+static guint
+deepgram_mock_flac_frame (DeepgramMockStream* stream, const guint8* data,
+                          gsize size)
+{
+  if (size < 6 || data[0] != 0xff || data[1] != 0xf8)
+    return 0;
+
+  guint   code = data[2] >> 4;
+  gsize   pos  = 4;
+  guint   len  = 0;
+  guint64 number;
+
+  /* The frame number is coded like UTF-8. */
+  if (data[pos] < 0x80)
+    number = data[pos];
+  else if ((data[pos] & 0xe0) == 0xc0)
+    number = data[pos] & 0x1f, len = 1;
+  else if ((data[pos] & 0xf0) == 0xe0)
+    number = data[pos] & 0x0f, len = 2;
+  else if ((data[pos] & 0xf8) == 0xf0)
+    number = data[pos] & 0x07, len = 3;
+  else
+    return 0;
+  if (size < pos + 1 + len + 3)
+    return 0;
+  for (guint i = 0; i < len; i++)
+    number = (number << 6) | (data[pos + 1 + i] & 0x3f);
+  pos += 1 + len;
+
+  guint blocksize;
+  if (code == 1)
+    blocksize = 192;
+  else if (code >= 2 && code <= 5)
+    blocksize = 576 << (code - 2);
+  else if (code == 6)
+    blocksize = data[pos++] + 1;
+  else if (code == 7)
+    {
+      blocksize = ((data[pos] << 8) | data[pos + 1]) + 1;
+      pos += 2;
+    }
+  else if (code >= 8)
+    blocksize = 256 << (code - 8);
+  else
+    return 0;
+
+  guint rate_code = data[2] & 0x0f;
+  if (rate_code == 12)
+    pos += 1;
+  else if (rate_code == 13 || rate_code == 14)
+    pos += 2;
+
+  if (size <= pos || deepgram_mock_crc8 (data, pos) != data[pos]
+      || number != stream->flac_next_frame)
+    return 0;
+
+  return blocksize;
+}
+
+static guint64
+deepgram_mock_flac_position (DeepgramMockStream* stream, const guint8* data,
+                             gsize size)
+{
+  for (gsize i = 0; i + 1 < size; i++)
+    {
+      guint samples = deepgram_mock_flac_frame (stream, data + i, size - i);
+      if (samples > 0)
+        {
+          stream->flac_samples += samples;
+          stream->flac_next_frame++;
+        }
+    }
+
+  return stream->flac_samples;
+}
+
+/* How far into the stream's audio, in linear16 bytes, a binary message
+ * takes us. */
+static guint64
+deepgram_mock_audio_bytes (DeepgramMockStream* stream, const guint8* data,
+                           gsize size)
+{
+  guint block_align = stream->bytes_per_second / MAX (stream->rate, 1);
+
+  switch (stream->encoding)
+    {
+    case DEEPGRAM_MOCK_OPUS:
+      return deepgram_mock_opus_position (
+                 stream, data, size,
+                 stream->audio_bytes / MAX (block_align, 1))
+             * block_align;
+    case DEEPGRAM_MOCK_FLAC:
+      return deepgram_mock_flac_position (stream, data, size) * block_align;
+    case DEEPGRAM_MOCK_LINEAR16:
+    default:
+      return stream->audio_bytes + size;
+    }
+}
+
+static gboolean deepgram_mock_replay_timeout (gpointer user_data);
+
+/* Sends the recorded messages that are due (all of them if flush), and
+ * sets a timer for the next one if only its time is missing. */
+static void
+deepgram_mock_replay (DeepgramMockStream* stream, gboolean flush)
+{
+  DeepgramMock* mock    = stream->mock;
+  guint64       elapsed = (g_get_monotonic_time () - stream->replay_start)
+                    * 1000;
+
+  if (stream->replay_timer)
+    {
+      g_source_destroy (stream->replay_timer);
+      g_clear_pointer (&stream->replay_timer, g_source_unref);
+    }
+
+  while (stream->replay_index < stream->replay->len)
+    {
+      DeepgramMockReplay* message = &g_array_index (
+          stream->replay, DeepgramMockReplay, stream->replay_index);
+
+      if (!flush && message->audio > stream->received_bytes)
+        break;
+
+      if (!flush && mock->replay_speed > 0)
+        {
+          guint64 due = (guint64)(message->time / mock->replay_speed);
+          if (due > elapsed)
+            {
+              stream->replay_timer = g_timeout_source_new (
+                  (guint)MIN ((due - elapsed + 999999) / 1000000, G_MAXUINT));
+              g_source_set_callback (stream->replay_timer,
+                                     deepgram_mock_replay_timeout, stream,
+                                     NULL);
+              g_source_attach (stream->replay_timer,
+                               g_main_context_get_thread_default ());
+              break;
+            }
+        }
+
+      atomic_fetch_add_explicit (&mock->results_sent, 1, memory_order_relaxed);
+      soup_websocket_connection_send_text (stream->conn, message->text);
+      stream->replay_index++;
+    }
+}
+
+static gboolean
+deepgram_mock_replay_timeout (gpointer user_data)
+{
+  DeepgramMockStream* stream = user_data;
+
+  g_clear_pointer (&stream->replay_timer, g_source_unref);
+  deepgram_mock_replay (stream, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+deepgram_mock_on_binary (DeepgramMockStream* stream, const guint8* data,
+                         gsize size)
+{
+  guint64 interval = MAX ((guint64)stream->bytes_per_second
+                              * stream->mock->result_interval_ms / 1000,
+                          1);
+
+  stream->audio_bytes
+      = MAX (stream->audio_bytes, deepgram_mock_audio_bytes (stream, data, size));
+
+  if (stream->mock->drop_after_ms > 0
+      && stream->audio_bytes * 1000 / stream->bytes_per_second
+             >= stream->mock->drop_after_ms)
+    {
+      soup_websocket_connection_close (stream->conn,
+                                       SOUP_WEBSOCKET_CLOSE_SERVER_ERROR,
+                                       "mock drop");
+      return;
+    }
+
+  if (stream->replay)
+    {
+      stream->received_bytes += size;
+      deepgram_mock_replay (stream, FALSE);
+      return;
+    }
+
+  while (stream->audio_bytes - stream->result_bytes >= interval)
+    {
+      deepgram_mock_send_result (stream, stream->result_bytes,
+                                 stream->result_bytes + interval, TRUE, FALSE);
+      stream->result_bytes += interval;
+    }
+
+  if (stream->interim
+      && stream->audio_bytes - stream->result_bytes >= interval / 2
+      && stream->interim_bytes <= stream->result_bytes)
+    {
+      deepgram_mock_send_result (stream, stream->result_bytes,
+                                 stream->audio_bytes, FALSE, FALSE);
+      stream->interim_bytes = stream->audio_bytes;
+    }
+}
+
+/* Sends a final result for audio not covered by one yet. */
+static void
+deepgram_mock_flush (DeepgramMockStream* stream, gboolean from_finalize)
+{
+  if (stream->audio_bytes > stream->result_bytes)
+    {
+      deepgram_mock_send_result (stream, stream->result_bytes,
+                                 stream->audio_bytes, TRUE, from_finalize);
+      stream->result_bytes = stream->audio_bytes;
+    }
+}
+
+static void
+deepgram_mock_on_text (DeepgramMockStream* stream, const gchar* text,
+                       gsize size)
+{
+  if (stream->replay)
+    {
+      /* The recording has the answers, Metadata included; only the end of
+       * the stream changes what is sent. */
+      if (g_strstr_len (text, size, "\"CloseStream\""))
+        {
+          deepgram_mock_replay (stream, TRUE);
+          soup_websocket_connection_close (stream->conn,
+                                           SOUP_WEBSOCKET_CLOSE_NORMAL, NULL);
+        }
+    }
+  else if (g_strstr_len (text, size, "\"CloseStream\""))
+    {
+      deepgram_mock_flush (stream, FALSE);
+      soup_websocket_connection_send_text (
+          stream->conn, "{\"type\":\"Metadata\",\"request_id\":\"mock\"}");
+      soup_websocket_connection_close (stream->conn,
+                                       SOUP_WEBSOCKET_CLOSE_NORMAL, NULL);
+    }
+  else if (g_strstr_len (text, size, "\"Finalize\""))
+    {
+      deepgram_mock_flush (stream, TRUE);
+    }
+}
+
+static void
+deepgram_mock_on_message (SoupWebsocketConnection* conn, gint type,
+                          GBytes* message, gpointer user_data)
+{
+  DeepgramMockStream* stream = user_data;
+  gsize               size   = 0;
+  gconstpointer       data   = g_bytes_get_data (message, &size);
+
+  if (type == SOUP_WEBSOCKET_DATA_BINARY)
+    {
+      atomic_fetch_add_explicit (&stream->mock->frames_received, 1,
+                                 memory_order_relaxed);
+      atomic_fetch_add_explicit (&stream->mock->bytes_received, size,
+                                 memory_order_relaxed);
+      deepgram_mock_on_binary (stream, data, size);
+    }
+  else
+    deepgram_mock_on_text (stream, data, size);
+}
+
+static void
+deepgram_mock_on_closed (SoupWebsocketConnection* conn, gpointer user_data)
+{
+  DeepgramMockStream* stream = user_data;
+
+  if (stream->replay_timer)
+    {
+      g_source_destroy (stream->replay_timer);
+      g_source_unref (stream->replay_timer);
+    }
+  g_clear_pointer (&stream->replay, g_array_unref);
+
+  g_signal_handlers_disconnect_by_data (conn, stream);
+  g_object_unref (stream->conn);
+  g_free (stream);
+}
+
+static guint
+deepgram_mock_param_uint (GHashTable* params, const gchar* name,
+                          guint default_value)
+{
+  const gchar* value = params ? g_hash_table_lookup (params, name) : NULL;
+  return value ? (guint)g_ascii_strtoull (value, NULL, 10) : default_value;
+}
+
+/* Sets the stream up for the audio format and options in the request's
+ * query string, and returns its parameters (NULL if there are none). */
+static GHashTable*
+deepgram_mock_configure (DeepgramMockStream* stream, SoupServerMessage* msg)
+{
+  GUri*        uri    = soup_server_message_get_uri (msg);
+  const gchar* query  = g_uri_get_query (uri);
+  GHashTable*  params = NULL;
+
+  if (query)
+    params = g_uri_parse_params (query, -1, "&", G_URI_PARAMS_NONE, NULL);
+
+  stream->rate = MAX (deepgram_mock_param_uint (params, "sample_rate", 16000), 1);
+  stream->bytes_per_second
+      = MAX (stream->rate * deepgram_mock_param_uint (params, "channels", 1)
+                 * 2,
+             1);
+
+  const gchar* encoding
+      = params ? g_hash_table_lookup (params, "encoding") : NULL;
+  if (g_strcmp0 (encoding, "opus") == 0)
+    stream->encoding = DEEPGRAM_MOCK_OPUS;
+  else if (g_strcmp0 (encoding, "flac") == 0)
+    stream->encoding = DEEPGRAM_MOCK_FLAC;
+  stream->interim = params
+                    && g_strcmp0 (g_hash_table_lookup (params,
+                                                       "interim_results"),
+                                  "true")
+                           == 0;
+
+  stream->result_channels = 1;
+  if (params
+      && g_strcmp0 (g_hash_table_lookup (params, "multichannel"), "true") == 0)
+    stream->result_channels
+        = MAX (deepgram_mock_param_uint (params, "channels", 1), 1);
+
+  return params;
+}
+
+/* A prerecorded response for duration seconds of audio: per channel, the
+ * words of one generated result per result-interval. */
+static gchar*
+deepgram_mock_build_prerecorded (DeepgramMock* mock, gdouble duration,
+                                 guint n_channels)
+{
+  gdouble  interval = mock->result_interval_ms / 1000.0;
+  GString* channels = g_string_new (NULL);
+  GString* words    = g_string_new (NULL);
+  GString* text     = g_string_new (NULL);
+
+  for (guint channel = 0; channel < n_channels; channel++)
+    {
+      g_string_truncate (words, 0);
+      g_string_truncate (text, 0);
+      for (guint i = 0; i * interval < duration; i++)
+        deepgram_mock_append_words (words, text, i, i * interval,
+                                    MIN ((i + 1) * interval, duration));
+
+      g_string_append_printf (
+          channels,
+          "%s{\"alternatives\":[{\"transcript\":\"%s\","
+          "\"confidence\":0.98,\"words\":[%s]}]}",
+          channel > 0 ? "," : "", text->str, words->str);
+    }
+
+  gchar* response = g_strdup_printf (
+      "{\"metadata\":{\"request_id\":\"mock\",\"duration\":%.3f,"
+      "\"channels\":%u,\"models\":[\"mock\"]},\"results\":{"
+      "\"channels\":[%s]}}",
+      duration, n_channels, channels->str);
+
+  g_string_free (channels, TRUE);
+  g_string_free (words, TRUE);
+  g_string_free (text, TRUE);
+
+  return response;
+}
+
+static gboolean
+deepgram_mock_http_unpause (gpointer user_data)
+{
+  soup_server_message_unpause (SOUP_SERVER_MESSAGE (user_data));
+  return G_SOURCE_REMOVE;
+}
+
+/* Stand-in for the prerecorded API: a POST of a whole file to /v1/listen.
+ * Anything else is left to the WebSocket handler on the same path. */
+static void
+deepgram_mock_http_cb (SoupServer* server, SoupServerMessage* msg,
+                       const char* path, GHashTable* query,
+                       gpointer user_data)
+{
+  DeepgramMock* mock = user_data;
+
+  if (strcmp (soup_server_message_get_method (msg), SOUP_METHOD_POST) != 0)
+    return;
+
+  /* Only for the format and options; the stream is not kept. */
+  DeepgramMockStream stream = { 0 };
+  GHashTable*        params = deepgram_mock_configure (&stream, msg);
+  if (params)
+    g_hash_table_unref (params);
+
+  GBytes* body
+      = soup_message_body_flatten (soup_server_message_get_request_body (msg));
+  gsize         size;
+  const guint8* data = g_bytes_get_data (body, &size);
+
+  /* Compressed files are measured like a stream sent in one message. */
+  gdouble duration = (gdouble)deepgram_mock_audio_bytes (&stream, data, size)
+                     / stream.bytes_per_second;
+  g_bytes_unref (body);
+
+  atomic_fetch_add_explicit (&mock->frames_received, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit (&mock->bytes_received, size,
+                             memory_order_relaxed);
+  atomic_fetch_add_explicit (&mock->results_sent, stream.result_channels,
+                             memory_order_relaxed);
+
+  gchar* response = deepgram_mock_build_prerecorded (mock, duration,
+                                                     stream.result_channels);
+  soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+  soup_server_message_set_response (msg, "application/json",
+                                    SOUP_MEMORY_TAKE, response,
+                                    strlen (response));
+
+  if (mock->http_delay_ms > 0)
+    {
+      GSource* timer = g_timeout_source_new (mock->http_delay_ms);
+
+      soup_server_message_pause (msg);
+      g_source_set_callback (timer, deepgram_mock_http_unpause,
+                             g_object_ref (msg), g_object_unref);
+      g_source_attach (timer, g_main_context_get_thread_default ());
+      g_source_unref (timer);
+    }
+}
+
+static void
+deepgram_mock_websocket_cb (SoupServer* server, SoupServerMessage* msg,
+                            const char* path, SoupWebsocketConnection* conn,
+                            gpointer user_data)
+{
+  DeepgramMock*       mock   = user_data;
+  DeepgramMockStream* stream = g_new0 (DeepgramMockStream, 1);
+  GHashTable*         params = deepgram_mock_configure (stream, msg);
+
+  stream->mock = mock;
+  stream->conn = g_object_ref (conn);
+
+  if (mock->sessions->len > 0)
+    {
+      stream->replay = g_array_ref (g_ptr_array_index (
+          mock->sessions, mock->next_session++ % mock->sessions->len));
+      stream->replay_start = g_get_monotonic_time ();
+    }
+
+  soup_websocket_connection_set_max_incoming_payload_size (conn, 0);
+
+  g_signal_connect (conn, "message", G_CALLBACK (deepgram_mock_on_message),
+                    stream);
+  g_signal_connect (conn, "closed", G_CALLBACK (deepgram_mock_on_closed),
+                    stream);
+
+  if (stream->replay)
+    deepgram_mock_replay (stream, FALSE);
+
+  if (params)
+    g_hash_table_unref (params);
+}
+
+static gpointer
+deepgram_mock_thread_func (gpointer user_data)
+{
+  DeepgramMock* mock  = user_data;
+  GError*       error = NULL;
+
+  g_main_context_push_thread_default (mock->context);
+
+  mock->server = soup_server_new ("server-header", "deepgram-mock", NULL);
+  soup_server_add_handler (mock->server, "/v1/listen", deepgram_mock_http_cb,
+                           mock, NULL);
+  soup_server_add_websocket_handler (mock->server, "/v1/listen", NULL, NULL,
+                                     deepgram_mock_websocket_cb, mock, NULL);
+
+  if (soup_server_listen_local (mock->server, mock->requested_port,
+                                SOUP_SERVER_LISTEN_IPV4_ONLY, &error))
+    {
+      GSList* uris = soup_server_get_uris (mock->server);
+      if (uris)
+        mock->port = g_uri_get_port (uris->data);
+      g_slist_free_full (uris, (GDestroyNotify)g_uri_unref);
+    }
+
+  g_mutex_lock (&mock->lock);
+  mock->started = TRUE;
+  mock->error   = error;
+  g_cond_signal (&mock->cond);
+  g_mutex_unlock (&mock->lock);
+
+  if (!error)
+    g_main_loop_run (mock->loop);
+
+  soup_server_disconnect (mock->server);
+  g_clear_object (&mock->server);
+
+  g_main_context_pop_thread_default (mock->context);
+  return NULL;
+}
+
+gboolean
+deepgram_mock_start (DeepgramMock* mock, guint port, GError** error)
+{
+  g_return_val_if_fail (mock->thread == NULL, FALSE);
+
+  mock->requested_port = port;
+  mock->thread
+      = g_thread_new ("deepgram-mock", deepgram_mock_thread_func, mock);
+
+  g_mutex_lock (&mock->lock);
+  while (!mock->started)
+    g_cond_wait (&mock->cond, &mock->lock);
+  g_mutex_unlock (&mock->lock);
+
+  if (mock->error)
+    {
+      g_thread_join (mock->thread);
+      mock->thread = NULL;
+      g_propagate_error (error, mock->error);
+      mock->error = NULL;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+guint
+deepgram_mock_get_port (DeepgramMock* mock)
+{
+  return mock->port;
+}
+
+gchar*
+deepgram_mock_get_url (DeepgramMock* mock)
+{
+  return g_strdup_printf ("ws://127.0.0.1:%u/v1/listen", mock->port);
+}
+
+void
+deepgram_mock_get_counters (DeepgramMock* mock, guint64* frames,
+                            guint64* bytes, guint64* results)
+{
+  if (frames)
+    *frames = atomic_load (&mock->frames_received);
+  if (bytes)
+    *bytes = atomic_load (&mock->bytes_received);
+  if (results)
+    *results = atomic_load (&mock->results_sent);
+}
@@ -0,0 +1,44 @@
+#ifndef __DEEPGRAM_MOCK_H__
+#define __DEEPGRAM_MOCK_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Local stand-in for Deepgram's streaming endpoint, served by libsoup on
+ * 127.0.0.1 from a thread of its own. For every result-interval of audio it
+ * receives it sends back a Results message, either generated (with start/end
+ * matching the audio received so far) or replayed from a file of canned
+ * JSON messages, one per line, or played back from a session log recorded
+ * with record-to. A POST to the same path is answered like the prerecorded
+ * API, with generated words for the audio in the body. */
+typedef struct _DeepgramMock DeepgramMock;
+
+DeepgramMock * deepgram_mock_new(void);
+
+void deepgram_mock_free(DeepgramMock *mock);
+
+void deepgram_mock_set_result_interval(DeepgramMock *mock, guint interval_ms);
+
+void deepgram_mock_set_drop_after(DeepgramMock *mock, guint drop_after_ms);
+
+void deepgram_mock_set_http_delay(DeepgramMock *mock, guint delay_ms);
+
+gboolean deepgram_mock_load_responses(DeepgramMock *mock, const gchar *path,
+                                      GError **error);
+
+gboolean deepgram_mock_load_session(DeepgramMock *mock, const gchar *path,
+                                    gdouble speed, GError **error);
+
+gboolean deepgram_mock_start(DeepgramMock *mock, guint port, GError **error);
+
+guint deepgram_mock_get_port(DeepgramMock *mock);
+
+gchar * deepgram_mock_get_url(DeepgramMock *mock);
+
+void deepgram_mock_get_counters(DeepgramMock *mock, guint64 *frames,
+                                guint64 *bytes, guint64 *results);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_MOCK_H__ */
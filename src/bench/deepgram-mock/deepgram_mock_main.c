@@ -0,0 +1,96 @@
+#include <glib.h>
+#include <stdio.h>
+
+#include "deepgram_mock.h"
+
+int
+main (int argc, char* argv[])
+{
+  gint    port        = 8765;
+  gint    interval_ms = 1000;
+  gint    drop_after  = 0;
+  gint    http_delay  = 0;
+  gchar*  responses   = NULL;
+  gchar*  session     = NULL;
+  gdouble speed       = 1.0;
+  GError* error       = NULL;
+
+  GOptionEntry entries[] = {
+    { "port", 'p', 0, G_OPTION_ARG_INT, &port, "Port to listen on (0 = any)",
+      "PORT" },
+    { "interval", 'i', 0, G_OPTION_ARG_INT, &interval_ms,
+      "Audio (ms) covered by each result", "MS" },
+    { "drop-after", 'd', 0, G_OPTION_ARG_INT, &drop_after,
+      "Abort each connection after this much audio (ms), to exercise "
+      "reconnects",
+      "MS" },
+    { "http-delay", 0, 0, G_OPTION_ARG_INT, &http_delay,
+      "Answer each prerecorded (POST) request after this long (ms)", "MS" },
+    { "responses", 'r', 0, G_OPTION_ARG_FILENAME, &responses,
+      "Replay these JSON messages (one per line) instead of generated ones",
+      "FILE" },
+    { "session", 's', 0, G_OPTION_ARG_FILENAME, &session,
+      "Play back the messages received in this record-to session log",
+      "FILE" },
+    { "speed", 0, 0, G_OPTION_ARG_DOUBLE, &speed,
+      "Session playback speed relative to the recording (0 = as fast as "
+      "the audio arrives)",
+      "X" },
+    { NULL },
+  };
+
+  GOptionContext* ctx = g_option_context_new ("- Deepgram streaming mock");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  if (!g_option_context_parse (ctx, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (ctx);
+      return -1;
+    }
+  g_option_context_free (ctx);
+
+  DeepgramMock* mock = deepgram_mock_new ();
+  deepgram_mock_set_result_interval (mock, (guint)MAX (interval_ms, 1));
+  deepgram_mock_set_drop_after (mock, (guint)MAX (drop_after, 0));
+  deepgram_mock_set_http_delay (mock, (guint)MAX (http_delay, 0));
+
+  if (responses && !deepgram_mock_load_responses (mock, responses, &error))
+    {
+      g_printerr ("Failed to load responses: %s\n", error->message);
+      g_error_free (error);
+      deepgram_mock_free (mock);
+      return -2;
+    }
+
+  if (session && !deepgram_mock_load_session (mock, session, speed, &error))
+    {
+      g_printerr ("Failed to load session: %s\n", error->message);
+      g_error_free (error);
+      deepgram_mock_free (mock);
+      return -2;
+    }
+
+  if (!deepgram_mock_start (mock, (guint)MAX (port, 0), &error))
+    {
+      g_printerr ("Failed to start mock server: %s\n", error->message);
+      g_error_free (error);
+      deepgram_mock_free (mock);
+      return -3;
+    }
+
+  gchar* url = deepgram_mock_get_url (mock);
+  printf ("Listening on %s\n", url);
+  fflush (stdout);
+  g_free (url);
+
+  GMainLoop* loop = g_main_loop_new (NULL, FALSE);
+  g_main_loop_run (loop);
+
+  g_main_loop_unref (loop);
+  deepgram_mock_free (mock);
+  g_free (responses);
+  g_free (session);
+
+  return 0;
+}
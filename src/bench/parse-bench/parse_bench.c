@@ -0,0 +1,223 @@
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deepgramresult.h"
+
+/* Result parsing microbenchmark: runs a corpus of streaming responses, one
+ * JSON message per line, through the streaming parser DeepgramWS uses and
+ * through the json-glib one it falls back to, checks that both agree, and
+ * reports messages/s and time per message for each. Without a corpus file a
+ * mix of interim and final results like the mock server's is generated. */
+
+#define PARSE_BENCH_MESSAGES 1000
+
+static const gchar* parse_bench_words[]
+    = { "the",   "quick", "brown", "fox",  "jumps",  "over",
+        "lazy",  "dog",   "while", "café", "\\\"ok\\\"", "naïve" };
+
+static GPtrArray*
+parse_bench_generate (void)
+{
+  GPtrArray* corpus = g_ptr_array_new_with_free_func (g_free);
+  gdouble    start  = 0.0;
+
+  for (guint i = 0; i < PARSE_BENCH_MESSAGES; i++)
+    {
+      gboolean is_final = i % 4 == 3;
+      guint    n_words  = 1 + i % 24;
+      gdouble  duration = 0.25 * n_words;
+      GString* words    = g_string_new (NULL);
+      GString* text     = g_string_new (NULL);
+
+      for (guint w = 0; w < n_words; w++)
+        {
+          const gchar* word
+              = parse_bench_words[(i + w) % G_N_ELEMENTS (parse_bench_words)];
+          gdouble word_start = start + 0.25 * w;
+
+          g_string_append_printf (
+              words,
+              "%s{\"word\":\"%s\",\"start\":%.3f,\"end\":%.3f,"
+              "\"confidence\":0.%03u,\"punctuated_word\":\"%s\"}",
+              w ? "," : "", word, word_start, word_start + 0.2,
+              900 + (i + w) % 100, word);
+          g_string_append_printf (text, "%s%s", w ? " " : "", word);
+        }
+
+      g_ptr_array_add (
+          corpus,
+          g_strdup_printf (
+              "{\"type\":\"Results\",\"channel_index\":[0,1],"
+              "\"duration\":%.3f,\"start\":%.3f,\"is_final\":%s,"
+              "\"speech_final\":%s,\"channel\":{\"alternatives\":[{"
+              "\"transcript\":\"%s\",\"confidence\":0.98,\"words\":[%s]}]},"
+              "\"metadata\":{\"request_id\":\"bench\",\"model_info\":{"
+              "\"name\":\"general\",\"version\":\"bench\",\"arch\":\"bench\"},"
+              "\"model_uuid\":\"00000000-0000-0000-0000-000000000000\"},"
+              "\"from_finalize\":false}",
+              duration, start, is_final ? "true" : "false",
+              is_final ? "true" : "false", text->str, words->str));
+
+      if (is_final)
+        start += duration;
+
+      g_string_free (words, TRUE);
+      g_string_free (text, TRUE);
+    }
+
+  g_ptr_array_add (
+      corpus,
+      g_strdup ("{\"type\":\"Metadata\",\"transaction_key\":\"deprecated\","
+                "\"request_id\":\"bench\",\"created\":\"2025-01-01T00:00:00Z\","
+                "\"duration\":60.0,\"channels\":1}"));
+
+  return corpus;
+}
+
+static GPtrArray*
+parse_bench_load (const gchar* path)
+{
+  gchar*  contents = NULL;
+  GError* error    = NULL;
+
+  if (!g_file_get_contents (path, &contents, NULL, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  GPtrArray* corpus = g_ptr_array_new_with_free_func (g_free);
+  gchar**    lines  = g_strsplit (contents, "\n", -1);
+  for (gchar** line = lines; *line; line++)
+    {
+      if (**line)
+        g_ptr_array_add (corpus, g_strdup (*line));
+    }
+  g_strfreev (lines);
+  g_free (contents);
+
+  return corpus;
+}
+
+static gboolean
+parse_bench_same (const DeepgramResult* a, const DeepgramResult* b)
+{
+  if (a->type != b->type || a->is_final != b->is_final
+      || a->channel != b->channel
+      || a->has_range != b->has_range
+      || (a->has_range
+          && (a->start != b->start || a->duration != b->duration))
+      || g_strcmp0 (a->transcript, b->transcript) != 0
+      || a->words->len != b->words->len)
+    return FALSE;
+
+  for (guint i = 0; i < a->words->len; i++)
+    {
+      DeepgramWord* wa = &g_array_index (a->words, DeepgramWord, i);
+      DeepgramWord* wb = &g_array_index (b->words, DeepgramWord, i);
+
+      if (g_strcmp0 (wa->text, wb->text) != 0 || wa->start != wb->start
+          || wa->end != wb->end || wa->confidence != wb->confidence)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+parse_bench_run (const gchar* name, GPtrArray* corpus, guint iterations,
+                 gboolean json_glib)
+{
+  DeepgramResult* result = deepgram_result_new ();
+  guint64         words  = 0;
+
+  gint64 start = g_get_monotonic_time ();
+  for (guint it = 0; it < iterations; it++)
+    {
+      for (guint i = 0; i < corpus->len; i++)
+        {
+          const gchar* msg = g_ptr_array_index (corpus, i);
+          gboolean     ok;
+
+          if (json_glib)
+            ok = deepgram_result_parse_json_glib (result, msg, strlen (msg),
+                                                  NULL);
+          else
+            ok = deepgram_result_parse (result, msg, strlen (msg));
+
+          if (ok)
+            words += result->words->len;
+        }
+    }
+  gdouble elapsed = (g_get_monotonic_time () - start) / 1e6;
+
+  guint64 messages = (guint64)iterations * corpus->len;
+  printf ("%-10s messages=%-10" G_GUINT64_FORMAT " words=%-10" G_GUINT64_FORMAT
+          " time=%8.3fs msgs/s=%12.0f us/msg=%8.3f\n",
+          name, messages, words, elapsed, messages / elapsed,
+          elapsed * 1e6 / messages);
+
+  deepgram_result_free (result);
+}
+
+int
+main (int argc, char* argv[])
+{
+  const gchar* path       = argc > 1 && strcmp (argv[1], "-") != 0 ? argv[1]
+                                                                   : NULL;
+  guint        iterations = argc > 2 ? (guint)atoi (argv[2]) : 100;
+
+  if (iterations == 0)
+    {
+      g_printerr ("Usage: %s [corpus.jsonl|-] [iterations]\n", argv[0]);
+      return -1;
+    }
+
+  GPtrArray* corpus = path ? parse_bench_load (path) : parse_bench_generate ();
+  if (!corpus || corpus->len == 0)
+    {
+      g_printerr ("No messages to parse\n");
+      return -1;
+    }
+
+  /* Both parsers must see the same results before timing means anything. */
+  DeepgramResult* fast       = deepgram_result_new ();
+  DeepgramResult* reference  = deepgram_result_new ();
+  guint           mismatches = 0;
+  guint           fallbacks  = 0;
+
+  for (guint i = 0; i < corpus->len; i++)
+    {
+      const gchar* msg = g_ptr_array_index (corpus, i);
+      gboolean     ref_ok
+          = deepgram_result_parse_json_glib (reference, msg, strlen (msg),
+                                             NULL);
+
+      if (!deepgram_result_parse (fast, msg, strlen (msg)))
+        {
+          fallbacks++;
+          continue;
+        }
+      if (!ref_ok || !parse_bench_same (fast, reference))
+        {
+          if (mismatches++ < 5)
+            g_printerr ("Mismatch on message %u: %s\n", i + 1, msg);
+        }
+    }
+
+  deepgram_result_free (fast);
+  deepgram_result_free (reference);
+
+  printf ("corpus=%u messages fallbacks=%u mismatches=%u\n", corpus->len,
+          fallbacks, mismatches);
+
+  parse_bench_run ("json-glib", corpus, iterations, TRUE);
+  parse_bench_run ("streaming", corpus, iterations, FALSE);
+
+  g_ptr_array_unref (corpus);
+
+  return mismatches ? 1 : 0;
+}
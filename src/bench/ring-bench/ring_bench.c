@@ -0,0 +1,197 @@
+#include <glib.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "deepgramring.h"
+
+/* Push/pop microbenchmark: n producer/consumer pairs, one per simulated
+ * deepgramsink, each moving items through either the old GQueue + GMutex +
+ * GCond scheme or a DeepgramRing with the sleep/wake-up handshake used by
+ * DeepgramWS. Lock contention is counted as failed g_mutex_trylock() calls. */
+
+#define RING_BENCH_SLOTS 4096
+
+typedef struct
+{
+  GMutex lock;
+  GCond  cond;
+  guint  items;
+
+  GQueue*       queue;
+  DeepgramRing* ring;
+
+  _Atomic gboolean consumer_waiting;
+  guint64          contended;
+  guint64          full_stalls;
+} BenchPair;
+
+static void
+bench_lock (BenchPair* pair, guint64* contended)
+{
+  if (!g_mutex_trylock (&pair->lock))
+    {
+      (*contended)++;
+      g_mutex_lock (&pair->lock);
+    }
+}
+
+static gpointer
+gqueue_producer (gpointer user_data)
+{
+  BenchPair* pair      = user_data;
+  guint64    contended = 0;
+
+  for (guint i = 1; i <= pair->items; i++)
+    {
+      bench_lock (pair, &contended);
+      g_queue_push_tail (pair->queue, GUINT_TO_POINTER (i));
+      g_cond_signal (&pair->cond);
+      g_mutex_unlock (&pair->lock);
+    }
+
+  return GSIZE_TO_POINTER (contended);
+}
+
+static gpointer
+gqueue_consumer (gpointer user_data)
+{
+  BenchPair* pair      = user_data;
+  guint64    contended = 0;
+
+  for (guint received = 0; received < pair->items; received++)
+    {
+      bench_lock (pair, &contended);
+      while (g_queue_is_empty (pair->queue))
+        g_cond_wait (&pair->cond, &pair->lock);
+      g_queue_pop_head (pair->queue);
+      g_mutex_unlock (&pair->lock);
+    }
+
+  return GSIZE_TO_POINTER (contended);
+}
+
+static gpointer
+ring_producer (gpointer user_data)
+{
+  BenchPair* pair      = user_data;
+  guint64    contended = 0;
+
+  for (guint i = 1; i <= pair->items; i++)
+    {
+      while (!deepgram_ring_push (pair->ring, GUINT_TO_POINTER (i)))
+        {
+          pair->full_stalls++;
+          g_thread_yield ();
+        }
+
+      atomic_thread_fence (memory_order_seq_cst);
+      if (atomic_load_explicit (&pair->consumer_waiting, memory_order_relaxed))
+        {
+          bench_lock (pair, &contended);
+          g_cond_signal (&pair->cond);
+          g_mutex_unlock (&pair->lock);
+        }
+    }
+
+  return GSIZE_TO_POINTER (contended);
+}
+
+static gpointer
+ring_consumer (gpointer user_data)
+{
+  BenchPair* pair      = user_data;
+  guint64    contended = 0;
+  guint      received  = 0;
+
+  while (received < pair->items)
+    {
+      if (deepgram_ring_pop (pair->ring))
+        {
+          received++;
+          continue;
+        }
+
+      bench_lock (pair, &contended);
+      atomic_store (&pair->consumer_waiting, TRUE);
+      atomic_thread_fence (memory_order_seq_cst);
+      while (deepgram_ring_length (pair->ring) == 0)
+        g_cond_wait (&pair->cond, &pair->lock);
+      atomic_store (&pair->consumer_waiting, FALSE);
+      g_mutex_unlock (&pair->lock);
+    }
+
+  return GSIZE_TO_POINTER (contended);
+}
+
+static void
+run_bench (const gchar* name, GThreadFunc producer, GThreadFunc consumer,
+           guint n_pairs, guint items)
+{
+  BenchPair* pairs   = g_new0 (BenchPair, n_pairs);
+  GThread**  threads = g_new0 (GThread*, n_pairs * 2);
+
+  for (guint i = 0; i < n_pairs; i++)
+    {
+      g_mutex_init (&pairs[i].lock);
+      g_cond_init (&pairs[i].cond);
+      pairs[i].items = items;
+      pairs[i].queue = g_queue_new ();
+      pairs[i].ring  = deepgram_ring_new (RING_BENCH_SLOTS);
+      atomic_init (&pairs[i].consumer_waiting, FALSE);
+    }
+
+  gint64 start = g_get_monotonic_time ();
+
+  for (guint i = 0; i < n_pairs; i++)
+    {
+      threads[2 * i]     = g_thread_new ("consumer", consumer, &pairs[i]);
+      threads[2 * i + 1] = g_thread_new ("producer", producer, &pairs[i]);
+    }
+
+  guint64 contended = 0;
+  for (guint i = 0; i < n_pairs * 2; i++)
+    contended += GPOINTER_TO_SIZE (g_thread_join (threads[i]));
+
+  gint64 elapsed = g_get_monotonic_time () - start;
+
+  guint64 full_stalls = 0;
+  for (guint i = 0; i < n_pairs; i++)
+    {
+      full_stalls += pairs[i].full_stalls;
+      g_queue_free (pairs[i].queue);
+      deepgram_ring_free (pairs[i].ring, NULL);
+      g_mutex_clear (&pairs[i].lock);
+      g_cond_clear (&pairs[i].cond);
+    }
+
+  guint64 total = (guint64)n_pairs * items;
+  gdouble secs  = elapsed / (gdouble)G_USEC_PER_SEC;
+
+  printf ("%-8s pairs=%-4u items=%-10" G_GUINT64_FORMAT " time=%8.3fs "
+          "throughput=%8.2f Mops/s contended-locks=%-10" G_GUINT64_FORMAT
+          " full-stalls=%" G_GUINT64_FORMAT "\n",
+          name, n_pairs, total, secs, total / secs / 1e6, contended,
+          full_stalls);
+
+  g_free (threads);
+  g_free (pairs);
+}
+
+int
+main (int argc, char* argv[])
+{
+  guint n_pairs = argc > 1 ? (guint)atoi (argv[1]) : 64;
+  guint items   = argc > 2 ? (guint)atoi (argv[2]) : 200000;
+
+  if (n_pairs == 0 || items == 0)
+    {
+      g_printerr ("Usage: %s [n-pairs] [items-per-pair]\n", argv[0]);
+      return -1;
+    }
+
+  run_bench ("gqueue", gqueue_producer, gqueue_consumer, n_pairs, items);
+  run_bench ("ring", ring_producer, ring_consumer, n_pairs, items);
+
+  return 0;
+}
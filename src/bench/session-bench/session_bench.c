@@ -0,0 +1,284 @@
+#include <glib.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deepgram_mock.h"
+#include "deepgramsession.h"
+#include "deepgramws.h"
+
+/* Plays a session recorded with record-to back through DeepgramWS: the
+ * first connection's audio messages are pushed with their recorded sizes
+ * (and payloads, if they were recorded; silence otherwise) at their
+ * recorded times or as fast as possible, against an in-process mock server
+ * that answers with the messages that connection received. Reports the
+ * receive path's cost per message from the connection's statistics, so
+ * parsing and signal emission can be profiled on production traffic
+ * without the live service. */
+
+#define SESSION_BENCH_DRAIN_TIMEOUT (30 * GST_SECOND)
+
+typedef struct
+{
+  guint64 transcripts;
+  guint64 finals;
+  guint64 words;
+} SessionBenchCounters;
+
+static void
+session_bench_on_words (DeepgramWS* ws, GArray* words, gboolean is_final,
+                        guint channel, gpointer user_data)
+{
+  SessionBenchCounters* counters = user_data;
+
+  counters->words += words->len;
+}
+
+static void
+session_bench_on_transcript (DeepgramWS* ws, const gchar* transcript,
+                             gboolean is_final, gdouble start, gdouble end,
+                             guint channel, gpointer user_data)
+{
+  SessionBenchCounters* counters = user_data;
+
+  counters->transcripts++;
+  if (is_final)
+    counters->finals++;
+}
+
+/* The recorded URL's parameters, so the format and options are those of
+ * the recording; the numeric ones DeepgramWS reads itself become ints. */
+static GstStructure*
+session_bench_query_params (const gchar* url, gint* channels)
+{
+  const gchar*  query  = strchr (url, '?');
+  GstStructure* params = gst_structure_new_empty ("params");
+  GHashTable*   table
+      = query ? g_uri_parse_params (query + 1, -1, "&", G_URI_PARAMS_NONE,
+                                    NULL)
+              : NULL;
+
+  if (table)
+    {
+      GHashTableIter iter;
+      gpointer       key, value;
+
+      g_hash_table_iter_init (&iter, table);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          if (strcmp (key, "sample_rate") == 0
+              || strcmp (key, "channels") == 0)
+            gst_structure_set (params, key, G_TYPE_INT, atoi (value), NULL);
+          else
+            gst_structure_set (params, key, G_TYPE_STRING, value, NULL);
+        }
+      g_hash_table_unref (table);
+    }
+
+  *channels = 1;
+  gst_structure_get_int (params, "channels", channels);
+
+  return params;
+}
+
+int
+main (int argc, char* argv[])
+{
+  gdouble speed    = 0.0;
+  gchar*  endpoint = NULL;
+  GError* error    = NULL;
+  gchar** files    = NULL;
+
+  GOptionEntry entries[] = {
+    { "speed", 's', 0, G_OPTION_ARG_DOUBLE, &speed,
+      "Playback speed relative to the recording (0 = as fast as possible)",
+      "X" },
+    { "endpoint", 'e', 0, G_OPTION_ARG_STRING, &endpoint,
+      "Send to this server (with $DEEPGRAM_API_KEY) instead of the "
+      "in-process mock",
+      "URL" },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &files, NULL,
+      "SESSION" },
+    { NULL },
+  };
+
+  GOptionContext* ctx = g_option_context_new ("- replay a recorded session");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (ctx);
+      return -1;
+    }
+  g_option_context_free (ctx);
+
+  if (!files || !files[0])
+    {
+      g_printerr ("Usage: %s [--speed X] [--endpoint URL] SESSION\n",
+                  argv[0]);
+      return -1;
+    }
+
+  DeepgramSessionReader* reader
+      = deepgram_session_reader_new (files[0], &error);
+  if (!reader)
+    {
+      g_printerr ("Failed to open session: %s\n", error->message);
+      g_error_free (error);
+      return -1;
+    }
+
+  /* Everything the first connection sent, in order. */
+  GArray* sent
+      = g_array_new (FALSE, FALSE, sizeof (DeepgramSessionRecord));
+  gchar*                url    = NULL;
+  guint64               opened = 0;
+  DeepgramSessionRecord record;
+
+  while (deepgram_session_reader_next (reader, &record))
+    {
+      if (record.event == DEEPGRAM_SESSION_CONNECTED)
+        {
+          if (url)
+            break;
+          url    = g_strndup ((const gchar*)record.data, record.size);
+          opened = record.time;
+        }
+      else if (record.event == DEEPGRAM_SESSION_SENT_AUDIO
+               || record.event == DEEPGRAM_SESSION_SENT_TEXT)
+        {
+          record.time -= opened;
+          g_array_append_val (sent, record);
+        }
+    }
+
+  if (!url)
+    {
+      g_printerr ("%s holds no connection\n", files[0]);
+      return -1;
+    }
+
+  DeepgramMock* mock = NULL;
+  if (!endpoint)
+    {
+      mock = deepgram_mock_new ();
+      if (!deepgram_mock_load_session (mock, files[0], speed, &error)
+          || !deepgram_mock_start (mock, 0, &error))
+        {
+          g_printerr ("Failed to start mock server: %s\n", error->message);
+          return -1;
+        }
+      endpoint = deepgram_mock_get_url (mock);
+    }
+
+  gint          channels;
+  GstStructure* params = session_bench_query_params (url, &channels);
+  const gchar*  key    = g_getenv ("DEEPGRAM_API_KEY");
+  DeepgramWS*   ws     = deepgram_ws_new ();
+
+  g_object_set (ws, "api-key", mock || !key ? "mock" : key, "endpoint",
+                endpoint, "query-params", params, "channels", channels,
+                "silent", TRUE, NULL);
+  gst_structure_free (params);
+
+  SessionBenchCounters counters = { 0 };
+  g_signal_connect (ws, "transcript",
+                    G_CALLBACK (session_bench_on_transcript), &counters);
+  g_signal_connect (ws, "words", G_CALLBACK (session_bench_on_words),
+                    &counters);
+
+  if (!deepgram_ws_start (ws))
+    {
+      g_printerr ("Failed to start DeepgramWS\n");
+      return -1;
+    }
+
+  guint64 audio_bytes = 0;
+  guint64 frames      = 0;
+  guint8* silence     = NULL;
+  gsize   silence_len = 0;
+  gint64  start       = g_get_monotonic_time ();
+
+  for (guint i = 0; i < sent->len; i++)
+    {
+      DeepgramSessionRecord* r
+          = &g_array_index (sent, DeepgramSessionRecord, i);
+
+      if (speed > 0)
+        {
+          gint64 due = start + (gint64)(r->time / 1000 / speed);
+          gint64 now = g_get_monotonic_time ();
+          if (due > now)
+            g_usleep (due - now);
+        }
+
+      if (r->event == DEEPGRAM_SESSION_SENT_AUDIO)
+        {
+          const guint8* data = r->data;
+          if (!data)
+            {
+              if (r->size > silence_len)
+                {
+                  silence     = g_realloc (silence, r->size);
+                  silence_len = r->size;
+                  memset (silence, 0, silence_len);
+                }
+              data = silence;
+            }
+          deepgram_ws_push_audio (ws, data, r->size);
+          audio_bytes += r->size;
+          frames++;
+        }
+      else if (r->data
+               && g_strstr_len ((const gchar*)r->data, r->size,
+                                "\"Finalize\""))
+        {
+          deepgram_ws_finalize (ws);
+        }
+      else if (r->data
+               && g_strstr_len ((const gchar*)r->data, r->size,
+                                "\"CloseStream\""))
+        {
+          break;
+        }
+    }
+
+  gboolean drained = deepgram_ws_drain (ws, SESSION_BENCH_DRAIN_TIMEOUT);
+  gdouble  wall
+      = (g_get_monotonic_time () - start) / (gdouble)G_USEC_PER_SEC;
+
+  GstStructure* stats = deepgram_ws_get_stats (ws);
+  guint64       messages, parse_avg, lag_max;
+  gst_structure_get_uint64 (stats, "messages-received", &messages);
+  gst_structure_get_uint64 (stats, "parse-time-avg", &parse_avg);
+  gst_structure_get_uint64 (stats, "result-lag-max", &lag_max);
+  gst_structure_free (stats);
+
+  deepgram_ws_stop (ws);
+  g_object_unref (ws);
+
+  printf ("session=%s speed=%.2f wall=%.2fs%s\n", files[0], speed, wall,
+          drained ? "" : " (drain timed out)");
+  printf ("sent: frames=%" G_GUINT64_FORMAT " bytes=%" G_GUINT64_FORMAT "\n",
+          frames, audio_bytes);
+  printf ("received: messages=%" G_GUINT64_FORMAT " messages/s=%.1f "
+          "transcripts=%" G_GUINT64_FORMAT " finals=%" G_GUINT64_FORMAT
+          " words=%" G_GUINT64_FORMAT "\n",
+          messages, messages / MAX (wall, 1e-9), counters.transcripts,
+          counters.finals, counters.words);
+  printf ("parse us/message=%.2f result-lag-max ms=%.1f\n", parse_avg / 1e3,
+          lag_max / 1e6);
+
+  deepgram_mock_free (mock);
+  g_free (silence);
+  g_free (url);
+  g_free (endpoint);
+  g_array_unref (sent);
+  deepgram_session_reader_free (reader);
+  g_strfreev (files);
+
+  return drained ? 0 : 1;
+}
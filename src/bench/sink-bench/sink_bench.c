@@ -0,0 +1,454 @@
+#include <glib.h>
+#include <gst/gst.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "deepgram_mock.h"
+
+/* Runs N "source ! deepgramsink" pipelines against the loopback mock server
+ * and reports throughput, CPU and RSS per stream, and audio-in to
+ * transcript-out latency percentiles. Latency is measured from the moment the
+ * buffer that completes a result's end offset reaches the sink pad until the
+ * transcript signal for that result fires, so it is dominated by the mock's
+ * result interval; the sink's own share, from queueing a buffer to handing
+ * it to the socket, is reported separately from its stats at EOS. */
+
+#define BENCH_BYTES_PER_SECOND (16000 * 2)
+#define BENCH_SAMPLES_PER_BUF  320
+
+typedef struct
+{
+  gdouble audio_end;
+  gint64  time_us;
+} BenchMark;
+
+typedef struct _BenchState BenchState;
+
+typedef struct
+{
+  BenchState* state;
+  GstElement* pipeline;
+
+  GMutex  lock;
+  GArray* marks;
+  gdouble pushed_seconds;
+
+  /* The sink's wire-latency-p50/-p99 at EOS. */
+  guint64 wire_p50;
+  guint64 wire_p99;
+} BenchStream;
+
+struct _BenchState
+{
+  BenchStream* streams;
+  guint        n_streams;
+  guint        n_done;
+  guint        n_errors;
+  GMainLoop*   loop;
+
+  GMutex  lock;
+  GArray* latencies_ms;
+};
+
+static GstPadProbeReturn
+bench_buffer_probe (GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+  BenchStream* stream = user_data;
+  GstBuffer*   buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  BenchMark    mark;
+
+  g_mutex_lock (&stream->lock);
+  stream->pushed_seconds
+      += gst_buffer_get_size (buffer) / (gdouble)BENCH_BYTES_PER_SECOND;
+  mark.audio_end = stream->pushed_seconds;
+  mark.time_us   = g_get_monotonic_time ();
+  g_array_append_val (stream->marks, mark);
+  g_mutex_unlock (&stream->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+bench_on_transcript (GstElement* sink, gchar* transcript, gboolean is_final,
+                     gdouble start_time, gdouble end_time, guint channel,
+                     gpointer user_data)
+{
+  BenchStream* stream  = user_data;
+  gint64       now     = g_get_monotonic_time ();
+  gdouble      latency = -1.0;
+
+  g_mutex_lock (&stream->lock);
+  guint lo = 0, hi = stream->marks->len;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      if (g_array_index (stream->marks, BenchMark, mid).audio_end
+          < end_time - 1e-6)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  if (lo < stream->marks->len)
+    latency = (now - g_array_index (stream->marks, BenchMark, lo).time_us)
+              / 1000.0;
+  g_mutex_unlock (&stream->lock);
+
+  if (latency < 0)
+    return;
+
+  g_mutex_lock (&stream->state->lock);
+  g_array_append_val (stream->state->latencies_ms, latency);
+  g_mutex_unlock (&stream->state->lock);
+}
+
+static gboolean
+bench_bus_cb (GstBus* bus, GstMessage* msg, gpointer user_data)
+{
+  BenchStream* stream = user_data;
+  BenchState*  state  = stream->state;
+
+  switch (GST_MESSAGE_TYPE (msg))
+    {
+    case GST_MESSAGE_ERROR:
+      {
+        GError* err = NULL;
+        gst_message_parse_error (msg, &err, NULL);
+        g_printerr ("Error: %s\n", err->message);
+        g_error_free (err);
+        state->n_errors++;
+      }
+      /* fall through */
+    case GST_MESSAGE_EOS:
+      {
+        GstElement*   sink  = gst_bin_get_by_name (GST_BIN (stream->pipeline),
+                                                   "sink");
+        GstStructure* stats = NULL;
+        g_object_get (sink, "stats", &stats, NULL);
+        if (stats)
+          {
+            gst_structure_get_uint64 (stats, "wire-latency-p50",
+                                      &stream->wire_p50);
+            gst_structure_get_uint64 (stats, "wire-latency-p99",
+                                      &stream->wire_p99);
+            gst_structure_free (stats);
+          }
+        gst_object_unref (sink);
+      }
+      if (++state->n_done == state->n_streams)
+        g_main_loop_quit (state->loop);
+      return FALSE;
+    default:
+      break;
+    }
+  return TRUE;
+}
+
+static gboolean
+bench_timeout_cb (gpointer user_data)
+{
+  BenchState* state = user_data;
+
+  g_printerr ("Timed out waiting for %u of %u streams\n",
+              state->n_streams - state->n_done, state->n_streams);
+  g_main_loop_quit (state->loop);
+  return G_SOURCE_REMOVE;
+}
+
+static glong
+bench_rss_kib (void)
+{
+  glong size = 0, resident = 0;
+  FILE* f    = fopen ("/proc/self/statm", "r");
+  if (!f)
+    return 0;
+  if (fscanf (f, "%ld %ld", &size, &resident) != 2)
+    resident = 0;
+  fclose (f);
+  return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+static glong
+bench_thread_count (void)
+{
+  gchar* status = NULL;
+  glong  count  = 0;
+
+  if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+    return 0;
+
+  const gchar* line = strstr (status, "\nThreads:");
+  if (line)
+    count = strtol (line + strlen ("\nThreads:"), NULL, 10);
+  g_free (status);
+
+  return count;
+}
+
+static gdouble
+bench_cpu_seconds (void)
+{
+  struct rusage ru;
+  getrusage (RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec
+         + ru.ru_stime.tv_usec / 1e6;
+}
+
+static gint
+bench_compare_double (gconstpointer a, gconstpointer b)
+{
+  gdouble da = *(const gdouble*)a, db = *(const gdouble*)b;
+  return da < db ? -1 : da > db;
+}
+
+static gdouble
+bench_percentile (GArray* sorted, gdouble p)
+{
+  if (sorted->len == 0)
+    return 0.0;
+  guint idx = (guint)ceil (p / 100.0 * sorted->len);
+  return g_array_index (sorted, gdouble, idx > 0 ? idx - 1 : 0);
+}
+
+int
+main (int argc, char* argv[])
+{
+  gint     n_streams   = 10;
+  gint     duration    = 10;
+  gint     frame_ms    = 0;
+  gint     interval_ms = 1000;
+  gboolean fast        = FALSE;
+  gchar*   file        = NULL;
+  gchar*   endpoint    = NULL;
+  gchar*   encoding    = NULL;
+  gint     bitrate     = 32000;
+  gchar*   transport   = NULL;
+  gint     chunk_ms    = 60000;
+  gint     http_delay  = 0;
+  GError*  error       = NULL;
+  GString* extra_props = g_string_new (NULL);
+
+  GOptionEntry entries[] = {
+    { "streams", 'n', 0, G_OPTION_ARG_INT, &n_streams,
+      "Number of concurrent pipelines", "N" },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Seconds of test audio per stream (ignored with --file)", "SECS" },
+    { "file", 'f', 0, G_OPTION_ARG_FILENAME, &file,
+      "Decode this file instead of using audiotestsrc", "PATH" },
+    { "frame-duration", 0, 0, G_OPTION_ARG_INT, &frame_ms,
+      "deepgramsink frame-duration in ms", "MS" },
+    { "interval", 'i', 0, G_OPTION_ARG_INT, &interval_ms,
+      "Audio (ms) covered by each mock result", "MS" },
+    { "fast", 0, 0, G_OPTION_ARG_NONE, &fast,
+      "Push audio as fast as possible instead of in real time", NULL },
+    { "endpoint", 'e', 0, G_OPTION_ARG_STRING, &endpoint,
+      "Use an external server instead of the in-process mock", "URL" },
+    { "encoding", 0, 0, G_OPTION_ARG_STRING, &encoding,
+      "deepgramsink encoding: linear16, opus or flac", "ENC" },
+    { "bitrate", 0, 0, G_OPTION_ARG_INT, &bitrate,
+      "deepgramsink Opus bitrate in bits/s", "BPS" },
+    { "transport", 0, 0, G_OPTION_ARG_STRING, &transport,
+      "deepgramsink transport: websocket, or http (implies mode=batch)",
+      "TRANSPORT" },
+    { "chunk-duration", 0, 0, G_OPTION_ARG_INT, &chunk_ms,
+      "deepgramsink chunk-duration in ms with --transport http", "MS" },
+    { "http-delay", 0, 0, G_OPTION_ARG_INT, &http_delay,
+      "Mock processing time (ms) per upload with --transport http", "MS" },
+    { NULL },
+  };
+
+  GOptionContext* ctx = g_option_context_new ("- deepgramsink benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (ctx);
+      return -1;
+    }
+  g_option_context_free (ctx);
+
+  if (n_streams <= 0 || duration <= 0)
+    {
+      g_printerr ("--streams and --duration must be positive\n");
+      return -1;
+    }
+
+  if (!gst_element_factory_find ("deepgramsink"))
+    gst_registry_scan_path (gst_registry_get (), DEEPGRAM_PLUGIN_DIR);
+
+  DeepgramMock* mock = NULL;
+  if (!endpoint)
+    {
+      mock = deepgram_mock_new ();
+      deepgram_mock_set_result_interval (mock, (guint)MAX (interval_ms, 1));
+      deepgram_mock_set_http_delay (mock, (guint)MAX (http_delay, 0));
+      if (!deepgram_mock_start (mock, 0, &error))
+        {
+          g_printerr ("Failed to start mock server: %s\n", error->message);
+          g_error_free (error);
+          deepgram_mock_free (mock);
+          return -2;
+        }
+      endpoint = deepgram_mock_get_url (mock);
+    }
+
+  g_string_append_printf (extra_props, " frame-duration=%" G_GUINT64_FORMAT,
+                          (guint64)MAX (frame_ms, 0) * GST_MSECOND);
+  if (fast)
+    g_string_append (extra_props, " sync=false");
+  if (encoding)
+    g_string_append_printf (extra_props, " encoding=%s bitrate=%d", encoding,
+                            bitrate);
+  if (transport)
+    g_string_append_printf (extra_props, " transport=%s", transport);
+  if (g_strcmp0 (transport, "http") == 0)
+    g_string_append_printf (
+        extra_props,
+        " mode=batch chunk-duration=%" G_GUINT64_FORMAT
+        " drain-timeout=%" G_GUINT64_FORMAT,
+        (guint64)MAX (chunk_ms, 0) * GST_MSECOND,
+        (guint64)(duration * 3 + 30) * GST_SECOND);
+
+  BenchState state = { 0 };
+  state.n_streams    = (guint)n_streams;
+  state.streams      = g_new0 (BenchStream, state.n_streams);
+  state.loop         = g_main_loop_new (NULL, FALSE);
+  state.latencies_ms = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  g_mutex_init (&state.lock);
+
+  glong   rss_before = bench_rss_kib ();
+  gdouble cpu_before = bench_cpu_seconds ();
+
+  for (guint i = 0; i < state.n_streams; i++)
+    {
+      BenchStream* stream = &state.streams[i];
+      gchar*       desc;
+
+      if (file)
+        desc = g_strdup_printf (
+            "filesrc location=\"%s\" ! decodebin ! audioconvert ! "
+            "audioresample ! audio/x-raw,format=S16LE,rate=16000,channels=1 ! "
+            "deepgramsink name=sink deepgram-api-key=bench silent=true "
+            "endpoint=\"%s\"%s",
+            file, endpoint, extra_props->str);
+      else
+        desc = g_strdup_printf (
+            "audiotestsrc is-live=%s wave=sine samplesperbuffer=%d "
+            "num-buffers=%d ! "
+            "audio/x-raw,format=S16LE,rate=16000,channels=1 ! "
+            "deepgramsink name=sink deepgram-api-key=bench silent=true "
+            "endpoint=\"%s\"%s",
+            fast ? "false" : "true", BENCH_SAMPLES_PER_BUF,
+            duration * 16000 / BENCH_SAMPLES_PER_BUF, endpoint,
+            extra_props->str);
+
+      stream->state    = &state;
+      stream->marks    = g_array_new (FALSE, FALSE, sizeof (BenchMark));
+      stream->pipeline = gst_parse_launch (desc, &error);
+      g_mutex_init (&stream->lock);
+      g_free (desc);
+
+      if (!stream->pipeline)
+        {
+          g_printerr ("Failed to build pipeline: %s\n", error->message);
+          return -3;
+        }
+
+      GstElement* sink = gst_bin_get_by_name (GST_BIN (stream->pipeline),
+                                              "sink");
+      GstPad*     pad  = gst_element_get_static_pad (sink, "sink");
+      gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, bench_buffer_probe,
+                         stream, NULL);
+      g_signal_connect (sink, "transcript", G_CALLBACK (bench_on_transcript),
+                        stream);
+      gst_object_unref (pad);
+      gst_object_unref (sink);
+
+      GstBus* bus = gst_element_get_bus (stream->pipeline);
+      gst_bus_add_watch (bus, bench_bus_cb, stream);
+      gst_object_unref (bus);
+    }
+
+  gint64 start_us = g_get_monotonic_time ();
+  for (guint i = 0; i < state.n_streams; i++)
+    gst_element_set_state (state.streams[i].pipeline, GST_STATE_PLAYING);
+
+  g_timeout_add_seconds ((guint)duration * 3 + 30, bench_timeout_cb, &state);
+  g_main_loop_run (state.loop);
+
+  gdouble wall
+      = (g_get_monotonic_time () - start_us) / (gdouble)G_USEC_PER_SEC;
+  gdouble cpu     = bench_cpu_seconds () - cpu_before;
+  glong   rss     = bench_rss_kib () - rss_before;
+  glong   threads = bench_thread_count ();
+  gdouble audio   = 0.0;
+  GArray* wire_p50 = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  gdouble wire_p99 = 0.0;
+
+  for (guint i = 0; i < state.n_streams; i++)
+    {
+      gdouble p50 = state.streams[i].wire_p50 / 1e6;
+      g_array_append_val (wire_p50, p50);
+      wire_p99 = MAX (wire_p99, state.streams[i].wire_p99 / 1e6);
+
+      audio += state.streams[i].pushed_seconds;
+      gst_element_set_state (state.streams[i].pipeline, GST_STATE_NULL);
+      gst_object_unref (state.streams[i].pipeline);
+      g_array_unref (state.streams[i].marks);
+      g_mutex_clear (&state.streams[i].lock);
+    }
+
+  printf ("streams=%u wall=%.2fs errors=%u%s\n", state.n_streams, wall,
+          state.n_errors, mock ? "" : " (external endpoint)");
+
+  if (mock)
+    {
+      guint64 frames, bytes, results;
+      deepgram_mock_get_counters (mock, &frames, &bytes, &results);
+      printf ("frames/s=%.1f bytes/s=%.0f results=%" G_GUINT64_FORMAT "\n",
+              frames / wall, bytes / wall, results);
+
+      /* Bytes on the wire against what linear16 would have taken. */
+      if (audio > 0)
+        printf ("encoding=%s kbit/s/stream=%.1f wire/linear16=%.1f%%\n",
+                encoding ? encoding : "linear16",
+                bytes * 8 / 1000.0 / audio,
+                100.0 * bytes / (audio * BENCH_BYTES_PER_SECOND));
+    }
+
+  printf ("cpu/stream=%.2f%% rss/stream=%.1f KiB%s\n",
+          100.0 * cpu / wall / state.n_streams,
+          (gdouble)rss / state.n_streams,
+          mock ? " (includes in-process mock)" : "");
+  printf ("threads=%ld\n", threads);
+
+  g_array_sort (state.latencies_ms, bench_compare_double);
+  printf ("latency ms: p50=%.1f p90=%.1f p99=%.1f max=%.1f (n=%u)\n",
+          bench_percentile (state.latencies_ms, 50),
+          bench_percentile (state.latencies_ms, 90),
+          bench_percentile (state.latencies_ms, 99),
+          bench_percentile (state.latencies_ms, 100), state.latencies_ms->len);
+
+  /* Median stream's p50 and the worst stream's p99. */
+  g_array_sort (wire_p50, bench_compare_double);
+  printf ("enqueue-to-wire ms: p50=%.3f p99=%.3f\n",
+          bench_percentile (wire_p50, 50), wire_p99);
+  g_array_unref (wire_p50);
+
+  g_array_unref (state.latencies_ms);
+  g_main_loop_unref (state.loop);
+  g_free (state.streams);
+  g_string_free (extra_props, TRUE);
+  g_free (endpoint);
+  g_free (encoding);
+  g_free (transport);
+  g_free (file);
+  deepgram_mock_free (mock);
+
+  return state.n_errors > 0 ? 1 : 0;
+}
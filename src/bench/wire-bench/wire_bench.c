@@ -0,0 +1,203 @@
+#include <glib.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+#include "deepgram_mock.h"
+#include "deepgramws.h"
+
+/* Measures how long audio waits between deepgram_ws_push_audio() and the
+ * socket, from the connections' wire-latency statistics: N DeepgramWS
+ * clients fed chunks in real time against the in-process mock, first with
+ * the sender polling its queue every --poll-ms (as it did before producers
+ * woke it), then woken on every chunk. */
+
+#define WIRE_BENCH_BYTES_PER_SECOND (16000 * 2)
+#define WIRE_BENCH_CONNECT_TIMEOUT  (10 * G_USEC_PER_SEC)
+#define WIRE_BENCH_DRAIN_TIMEOUT    (30 * GST_SECOND)
+
+static gint
+wire_bench_compare_uint64 (gconstpointer a, gconstpointer b)
+{
+  guint64 x = *(const guint64*)a, y = *(const guint64*)b;
+  return x < y ? -1 : x > y;
+}
+
+/* Waits until every connection is open, so connecting is not counted as
+ * queueing time. */
+static gboolean
+wire_bench_wait_connected (DeepgramWS** ws, guint n_streams)
+{
+  gint64 end = g_get_monotonic_time () + WIRE_BENCH_CONNECT_TIMEOUT;
+
+  for (guint i = 0; i < n_streams; i++)
+    {
+      guint64 connect_time = 0;
+      while (connect_time == 0)
+        {
+          GstStructure* stats = deepgram_ws_get_stats (ws[i]);
+          gst_structure_get_uint64 (stats, "connect-time", &connect_time);
+          gst_structure_free (stats);
+
+          if (connect_time == 0)
+            {
+              if (g_get_monotonic_time () > end)
+                return FALSE;
+              g_usleep (1000);
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+/* One run; prints the median stream's p50 and the worst p99 and max. */
+static gboolean
+wire_bench_run (const gchar* endpoint, guint n_streams, guint duration,
+                guint chunk_ms, guint64 poll_interval)
+{
+  DeepgramWS** ws         = g_new0 (DeepgramWS*, n_streams);
+  gsize        chunk_size = WIRE_BENCH_BYTES_PER_SECOND * chunk_ms / 1000;
+  guint8*      silence    = g_malloc0 (chunk_size);
+  gboolean     ok         = TRUE;
+
+  for (guint i = 0; i < n_streams; i++)
+    {
+      ws[i] = deepgram_ws_new ();
+      g_object_set (ws[i], "api-key", "mock", "endpoint", endpoint,
+                    "poll-interval", poll_interval, "silent", TRUE, NULL);
+      if (!deepgram_ws_start (ws[i]))
+        {
+          g_printerr ("Failed to start DeepgramWS\n");
+          ok = FALSE;
+        }
+    }
+
+  if (ok && !wire_bench_wait_connected (ws, n_streams))
+    {
+      g_printerr ("Timed out connecting to %s\n", endpoint);
+      ok = FALSE;
+    }
+
+  guint  n_chunks = duration * 1000 / chunk_ms;
+  gint64 start    = g_get_monotonic_time ();
+
+  for (guint c = 0; ok && c < n_chunks; c++)
+    {
+      gint64 due = start + (gint64)c * chunk_ms * 1000;
+      gint64 now = g_get_monotonic_time ();
+      if (due > now)
+        g_usleep (due - now);
+
+      for (guint i = 0; i < n_streams; i++)
+        deepgram_ws_push_audio (ws[i], silence, chunk_size);
+    }
+
+  GArray* p50s = g_array_new (FALSE, FALSE, sizeof (guint64));
+  guint64 p99  = 0;
+  guint64 max  = 0;
+
+  for (guint i = 0; i < n_streams; i++)
+    {
+      if (ok)
+        deepgram_ws_drain (ws[i], WIRE_BENCH_DRAIN_TIMEOUT);
+
+      GstStructure* stats = deepgram_ws_get_stats (ws[i]);
+      guint64       s_p50 = 0, s_p99 = 0, s_max = 0;
+      gst_structure_get_uint64 (stats, "wire-latency-p50", &s_p50);
+      gst_structure_get_uint64 (stats, "wire-latency-p99", &s_p99);
+      gst_structure_get_uint64 (stats, "wire-latency-max", &s_max);
+      gst_structure_free (stats);
+
+      g_array_append_val (p50s, s_p50);
+      p99 = MAX (p99, s_p99);
+      max = MAX (max, s_max);
+
+      deepgram_ws_stop (ws[i]);
+      g_object_unref (ws[i]);
+    }
+
+  g_array_sort (p50s, wire_bench_compare_uint64);
+  if (ok)
+    {
+      gchar* mode
+          = poll_interval > 0
+                ? g_strdup_printf ("poll-%" G_GUINT64_FORMAT "ms",
+                                   poll_interval / GST_MSECOND)
+                : g_strdup ("wakeup");
+      printf ("%-10s enqueue-to-wire ms: p50=%.3f p99=%.3f max=%.3f\n", mode,
+              g_array_index (p50s, guint64, n_streams / 2) / 1e6, p99 / 1e6,
+              max / 1e6);
+      g_free (mode);
+    }
+
+  g_array_unref (p50s);
+  g_free (silence);
+  g_free (ws);
+
+  return ok;
+}
+
+int
+main (int argc, char* argv[])
+{
+  gint    n_streams = 10;
+  gint    duration  = 5;
+  gint    chunk_ms  = 20;
+  gint    poll_ms   = 100;
+  GError* error     = NULL;
+
+  GOptionEntry entries[] = {
+    { "streams", 'n', 0, G_OPTION_ARG_INT, &n_streams,
+      "Number of concurrent connections", "N" },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Seconds of audio per connection and run", "SECS" },
+    { "chunk-ms", 'c', 0, G_OPTION_ARG_INT, &chunk_ms,
+      "Audio per chunk pushed, in ms", "MS" },
+    { "poll-ms", 'p', 0, G_OPTION_ARG_INT, &poll_ms,
+      "Queue poll interval of the baseline run", "MS" },
+    { NULL },
+  };
+
+  GOptionContext* ctx
+      = g_option_context_new ("- DeepgramWS enqueue-to-wire benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (ctx);
+      return -1;
+    }
+  g_option_context_free (ctx);
+
+  if (n_streams <= 0 || duration <= 0 || chunk_ms <= 0 || poll_ms <= 0)
+    {
+      g_printerr ("--streams, --duration, --chunk-ms and --poll-ms must be "
+                  "positive\n");
+      return -1;
+    }
+
+  DeepgramMock* mock = deepgram_mock_new ();
+  if (!deepgram_mock_start (mock, 0, &error))
+    {
+      g_printerr ("Failed to start mock server: %s\n", error->message);
+      g_error_free (error);
+      deepgram_mock_free (mock);
+      return -2;
+    }
+  gchar* endpoint = deepgram_mock_get_url (mock);
+
+  printf ("streams=%d duration=%ds chunk=%dms\n", n_streams, duration,
+          chunk_ms);
+  gboolean ok = wire_bench_run (endpoint, (guint)n_streams, (guint)duration,
+                                (guint)chunk_ms,
+                                (guint64)poll_ms * GST_MSECOND)
+                && wire_bench_run (endpoint, (guint)n_streams,
+                                   (guint)duration, (guint)chunk_ms, 0);
+
+  g_free (endpoint);
+  deepgram_mock_free (mock);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,620 @@
+#include "deepgramconvert.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DEEPGRAM_CONVERT_SSE2 1
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define DEEPGRAM_CONVERT_AVX2 1
+#endif
+
+/* Zero crossings of the sinc on either side of the centre tap, at the
+ * output rate. */
+#define DEEPGRAM_CONVERT_ZERO_CROSSINGS 8
+
+/* Passband edge as a fraction of the output Nyquist frequency. */
+#define DEEPGRAM_CONVERT_ROLLOFF 0.92
+
+/* Frames converted at a time, so the float scratch stays in cache. */
+#define DEEPGRAM_CONVERT_BLOCK 1024
+
+/* Filter lengths are padded to a whole number of AVX vectors. */
+#define DEEPGRAM_CONVERT_TAP_ALIGN 8
+
+typedef gfloat (*DeepgramDotFunc) (const gfloat* a, const gfloat* b,
+                                   guint n);
+typedef void (*DeepgramToFloatFunc) (DeepgramSampleFormat format,
+                                     guint channels, const guint8* in,
+                                     gsize frames, gfloat* out);
+typedef void (*DeepgramToS16Func) (const gfloat* in, gsize n, gint16* out);
+
+/* Picked once by deepgram_convert_init_simd(). */
+static DeepgramDotFunc     deepgram_convert_dot      = NULL;
+static DeepgramToFloatFunc deepgram_convert_to_float = NULL;
+static DeepgramToS16Func   deepgram_convert_to_s16   = NULL;
+static const gchar*        deepgram_convert_dot_name = NULL;
+
+struct _DeepgramConverter
+{
+  DeepgramSampleFormat format;
+  guint                channels;
+
+  /* The one channel taken from the input, or -1 to downmix them all. */
+  gint channel;
+
+  /* Each output frame advances the input by step_int + step_frac / den. */
+  guint step_int;
+  guint step_frac;
+  guint den;
+
+  /* den phases of taps coefficients each; NULL if the rates match. */
+  gfloat* bank;
+  guint   taps;
+  guint   history;
+
+  /* Mono float input not consumed yet, starting with the filter history;
+   * the next output is centred at pos + frac / den. */
+  gfloat* work;
+  gsize   work_len;
+  gsize   work_cap;
+  gsize   pos;
+  guint   frac;
+
+  gfloat* scratch;
+};
+
+/* ---- Downmix + convert to float ----------------------------------------- */
+
+static void
+deepgram_convert_to_float_scalar (DeepgramSampleFormat format, guint channels,
+                                  const guint8* in, gsize frames, gfloat* out)
+{
+  gfloat scale = 1.0f / channels;
+
+  if (format == DEEPGRAM_SAMPLE_S16LE)
+    {
+      const gint16* s = (const gint16*)in;
+      scale /= 32768.0f;
+      for (gsize i = 0; i < frames; i++)
+        {
+          gint32 sum = 0;
+          for (guint c = 0; c < channels; c++)
+            sum += GINT16_FROM_LE (s[i * channels + c]);
+          out[i] = sum * scale;
+        }
+    }
+  else
+    {
+      const gfloat* f = (const gfloat*)in;
+      for (gsize i = 0; i < frames; i++)
+        {
+          gfloat sum = 0.0f;
+          for (guint c = 0; c < channels; c++)
+            sum += f[i * channels + c];
+          out[i] = sum * scale;
+        }
+    }
+}
+
+#ifdef DEEPGRAM_CONVERT_SSE2
+/* Mono and stereo, the layouts audio actually comes in, get vector loops;
+ * anything else and the tails go through the scalar code. */
+static void
+deepgram_convert_to_float_sse2 (DeepgramSampleFormat format, guint channels,
+                                const guint8* in, gsize frames, gfloat* out)
+{
+  gsize i = 0;
+
+  if (format == DEEPGRAM_SAMPLE_S16LE && channels == 1)
+    {
+      const __m128 scale = _mm_set1_ps (1.0f / 32768.0f);
+      for (; i + 8 <= frames; i += 8)
+        {
+          __m128i s  = _mm_loadu_si128 ((const __m128i*)(in + i * 2));
+          __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (s, s), 16);
+          __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (s, s), 16);
+          _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+          _mm_storeu_ps (out + i + 4,
+                         _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+        }
+    }
+  else if (format == DEEPGRAM_SAMPLE_S16LE && channels == 2)
+    {
+      /* madd against ones sums each L/R pair into 32 bits. */
+      const __m128  scale = _mm_set1_ps (0.5f / 32768.0f);
+      const __m128i ones  = _mm_set1_epi16 (1);
+      for (; i + 4 <= frames; i += 4)
+        {
+          __m128i s   = _mm_loadu_si128 ((const __m128i*)(in + i * 4));
+          __m128i sum = _mm_madd_epi16 (s, ones);
+          _mm_storeu_ps (out + i, _mm_mul_ps (_mm_cvtepi32_ps (sum), scale));
+        }
+    }
+  else if (format == DEEPGRAM_SAMPLE_F32LE && channels == 1)
+    {
+      memcpy (out, in, frames * sizeof (gfloat));
+      i = frames;
+    }
+  else if (format == DEEPGRAM_SAMPLE_F32LE && channels == 2)
+    {
+      const gfloat* f    = (const gfloat*)in;
+      const __m128  half = _mm_set1_ps (0.5f);
+      for (; i + 4 <= frames; i += 4)
+        {
+          __m128 a = _mm_loadu_ps (f + i * 2);
+          __m128 b = _mm_loadu_ps (f + i * 2 + 4);
+          __m128 l = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+          __m128 r = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+          _mm_storeu_ps (out + i, _mm_mul_ps (_mm_add_ps (l, r), half));
+        }
+    }
+
+  deepgram_convert_to_float_scalar (format, channels,
+                                    in + i * channels
+                                             * (format == DEEPGRAM_SAMPLE_S16LE
+                                                    ? 2
+                                                    : 4),
+                                    frames - i, out + i);
+}
+#endif
+
+#ifdef DEEPGRAM_CONVERT_AVX2
+/* deepgram_convert_to_float_sse2() twice as wide; it takes the tails. */
+static __attribute__ ((target ("avx2"))) void
+deepgram_convert_to_float_avx2 (DeepgramSampleFormat format, guint channels,
+                                const guint8* in, gsize frames, gfloat* out)
+{
+  gsize i = 0;
+
+  if (format == DEEPGRAM_SAMPLE_S16LE && channels == 1)
+    {
+      const __m256 scale = _mm256_set1_ps (1.0f / 32768.0f);
+      for (; i + 16 <= frames; i += 16)
+        {
+          __m256i lo = _mm256_cvtepi16_epi32 (
+              _mm_loadu_si128 ((const __m128i*)(in + i * 2)));
+          __m256i hi = _mm256_cvtepi16_epi32 (
+              _mm_loadu_si128 ((const __m128i*)(in + i * 2 + 16)));
+          _mm256_storeu_ps (out + i,
+                            _mm256_mul_ps (_mm256_cvtepi32_ps (lo), scale));
+          _mm256_storeu_ps (out + i + 8,
+                            _mm256_mul_ps (_mm256_cvtepi32_ps (hi), scale));
+        }
+    }
+  else if (format == DEEPGRAM_SAMPLE_S16LE && channels == 2)
+    {
+      const __m256  scale = _mm256_set1_ps (0.5f / 32768.0f);
+      const __m256i ones  = _mm256_set1_epi16 (1);
+      for (; i + 8 <= frames; i += 8)
+        {
+          __m256i s   = _mm256_loadu_si256 ((const __m256i*)(in + i * 4));
+          __m256i sum = _mm256_madd_epi16 (s, ones);
+          _mm256_storeu_ps (out + i,
+                            _mm256_mul_ps (_mm256_cvtepi32_ps (sum), scale));
+        }
+    }
+  else if (format == DEEPGRAM_SAMPLE_F32LE && channels == 2)
+    {
+      /* The in-lane shuffles leave frames 0-1 4-5 | 2-3 6-7; the permute
+       * puts the 64-bit pairs back in order. */
+      const gfloat* f    = (const gfloat*)in;
+      const __m256  half = _mm256_set1_ps (0.5f);
+      for (; i + 8 <= frames; i += 8)
+        {
+          __m256 a   = _mm256_loadu_ps (f + i * 2);
+          __m256 b   = _mm256_loadu_ps (f + i * 2 + 8);
+          __m256 l   = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+          __m256 r   = _mm256_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+          __m256 sum = _mm256_mul_ps (_mm256_add_ps (l, r), half);
+          sum        = _mm256_castpd_ps (_mm256_permute4x64_pd (
+              _mm256_castps_pd (sum), _MM_SHUFFLE (3, 1, 2, 0)));
+          _mm256_storeu_ps (out + i, sum);
+        }
+    }
+
+  deepgram_convert_to_float_sse2 (format, channels,
+                                  in + i * channels
+                                           * (format == DEEPGRAM_SAMPLE_S16LE
+                                                  ? 2
+                                                  : 4),
+                                  frames - i, out + i);
+}
+#endif
+
+static void
+deepgram_convert_channel_to_float (DeepgramSampleFormat format,
+                                   guint channels, guint channel,
+                                   const guint8* in, gsize frames, gfloat* out)
+{
+  if (format == DEEPGRAM_SAMPLE_S16LE)
+    {
+      const gint16* s = (const gint16*)in + channel;
+      for (gsize i = 0; i < frames; i++)
+        out[i] = GINT16_FROM_LE (s[i * channels]) * (1.0f / 32768.0f);
+    }
+  else
+    {
+      const gfloat* f = (const gfloat*)in + channel;
+      for (gsize i = 0; i < frames; i++)
+        out[i] = f[i * channels];
+    }
+}
+
+static void
+deepgram_converter_to_float (DeepgramConverter* conv, const guint8* in,
+                             gsize frames, gfloat* out)
+{
+  if (conv->channel >= 0)
+    deepgram_convert_channel_to_float (conv->format, conv->channels,
+                                       conv->channel, in, frames, out);
+  else
+    deepgram_convert_to_float (conv->format, conv->channels, in, frames,
+                               out);
+}
+
+/* ---- Float to S16 -------------------------------------------------------- */
+
+static inline gint16
+deepgram_convert_sample_to_s16 (gfloat v)
+{
+  v *= 32768.0f;
+  if (v >= 32767.0f)
+    return G_MAXINT16;
+  if (v <= -32768.0f)
+    return G_MININT16;
+  return (gint16)(v >= 0.0f ? v + 0.5f : v - 0.5f);
+}
+
+static void
+deepgram_convert_to_s16_scalar (const gfloat* in, gsize n, gint16* out)
+{
+  for (gsize i = 0; i < n; i++)
+    out[i] = GINT16_TO_LE (deepgram_convert_sample_to_s16 (in[i]));
+}
+
+#ifdef DEEPGRAM_CONVERT_SSE2
+static void
+deepgram_convert_to_s16_sse2 (const gfloat* in, gsize n, gint16* out)
+{
+  gsize i = 0;
+
+  /* cvtps rounds to nearest and packs saturates, so no explicit clamp. */
+  const __m128 scale = _mm_set1_ps (32768.0f);
+  for (; i + 8 <= n; i += 8)
+    {
+      __m128i a = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (in + i), scale));
+      __m128i b
+          = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (in + i + 4), scale));
+      _mm_storeu_si128 ((__m128i*)(out + i), _mm_packs_epi32 (a, b));
+    }
+
+  deepgram_convert_to_s16_scalar (in + i, n - i, out + i);
+}
+#endif
+
+#ifdef DEEPGRAM_CONVERT_AVX2
+/* packs works within each 128-bit lane, so the permute restores the
+ * order of the 64-bit quarters. */
+static __attribute__ ((target ("avx2"))) void
+deepgram_convert_to_s16_avx2 (const gfloat* in, gsize n, gint16* out)
+{
+  gsize i = 0;
+
+  const __m256 scale = _mm256_set1_ps (32768.0f);
+  for (; i + 16 <= n; i += 16)
+    {
+      __m256i a = _mm256_cvtps_epi32 (
+          _mm256_mul_ps (_mm256_loadu_ps (in + i), scale));
+      __m256i b = _mm256_cvtps_epi32 (
+          _mm256_mul_ps (_mm256_loadu_ps (in + i + 8), scale));
+      __m256i packed = _mm256_permute4x64_epi64 (_mm256_packs_epi32 (a, b),
+                                                 _MM_SHUFFLE (3, 1, 2, 0));
+      _mm256_storeu_si256 ((__m256i*)(out + i), packed);
+    }
+
+  deepgram_convert_to_s16_sse2 (in + i, n - i, out + i);
+}
+#endif
+
+/* ---- FIR dot products ---------------------------------------------------- */
+
+static gfloat
+deepgram_convert_dot_scalar (const gfloat* a, const gfloat* b, guint n)
+{
+  gfloat sum = 0.0f;
+  for (guint i = 0; i < n; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+#ifdef DEEPGRAM_CONVERT_SSE2
+static gfloat
+deepgram_convert_dot_sse2 (const gfloat* a, const gfloat* b, guint n)
+{
+  __m128 acc0 = _mm_setzero_ps ();
+  __m128 acc1 = _mm_setzero_ps ();
+
+  /* n is a multiple of DEEPGRAM_CONVERT_TAP_ALIGN. */
+  for (guint i = 0; i < n; i += 8)
+    {
+      acc0 = _mm_add_ps (acc0,
+                         _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+      acc1 = _mm_add_ps (acc1, _mm_mul_ps (_mm_loadu_ps (a + i + 4),
+                                           _mm_loadu_ps (b + i + 4)));
+    }
+
+  __m128 acc = _mm_add_ps (acc0, acc1);
+  acc        = _mm_add_ps (acc, _mm_movehl_ps (acc, acc));
+  acc        = _mm_add_ss (acc, _mm_shuffle_ps (acc, acc, 1));
+  return _mm_cvtss_f32 (acc);
+}
+#endif
+
+#ifdef DEEPGRAM_CONVERT_AVX2
+static __attribute__ ((target ("avx2,fma"))) gfloat
+deepgram_convert_dot_avx2 (const gfloat* a, const gfloat* b, guint n)
+{
+  __m256 acc = _mm256_setzero_ps ();
+
+  for (guint i = 0; i < n; i += 8)
+    acc = _mm256_fmadd_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i),
+                           acc);
+
+  __m128 sum = _mm_add_ps (_mm256_castps256_ps128 (acc),
+                           _mm256_extractf128_ps (acc, 1));
+  sum        = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+  sum        = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+  return _mm_cvtss_f32 (sum);
+}
+#endif
+
+static void
+deepgram_convert_init_simd (void)
+{
+  static gsize initialized = 0;
+
+  if (!g_once_init_enter (&initialized))
+    return;
+
+  deepgram_convert_dot      = deepgram_convert_dot_scalar;
+  deepgram_convert_to_float = deepgram_convert_to_float_scalar;
+  deepgram_convert_to_s16   = deepgram_convert_to_s16_scalar;
+  deepgram_convert_dot_name = "scalar";
+#ifdef DEEPGRAM_CONVERT_SSE2
+  deepgram_convert_dot      = deepgram_convert_dot_sse2;
+  deepgram_convert_to_float = deepgram_convert_to_float_sse2;
+  deepgram_convert_to_s16   = deepgram_convert_to_s16_sse2;
+  deepgram_convert_dot_name = "sse2";
+#endif
+#ifdef DEEPGRAM_CONVERT_AVX2
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+    {
+      deepgram_convert_dot      = deepgram_convert_dot_avx2;
+      deepgram_convert_to_float = deepgram_convert_to_float_avx2;
+      deepgram_convert_to_s16   = deepgram_convert_to_s16_avx2;
+      deepgram_convert_dot_name = "avx2";
+    }
+#endif
+
+  g_once_init_leave (&initialized, 1);
+}
+
+const gchar*
+deepgram_converter_get_simd (void)
+{
+  deepgram_convert_init_simd ();
+  return deepgram_convert_dot_name;
+}
+
+/* ---- Converter ----------------------------------------------------------- */
+
+static guint
+deepgram_convert_gcd (guint a, guint b)
+{
+  while (b)
+    {
+      guint t = a % b;
+      a       = b;
+      b       = t;
+    }
+  return a;
+}
+
+/* Blackman-windowed sinc low-pass, one row of taps per phase. Each row is
+ * normalised to unity DC gain. */
+static void
+deepgram_converter_build_bank (DeepgramConverter* conv, guint in_rate,
+                               guint out_rate)
+{
+  gdouble ratio  = MIN (1.0, (gdouble)out_rate / in_rate);
+  gdouble cutoff = 0.5 * ratio * DEEPGRAM_CONVERT_ROLLOFF;
+  guint   half   = (guint)ceil (DEEPGRAM_CONVERT_ZERO_CROSSINGS / ratio);
+  guint   taps   = 2 * half;
+
+  taps = (taps + DEEPGRAM_CONVERT_TAP_ALIGN - 1)
+         / DEEPGRAM_CONVERT_TAP_ALIGN * DEEPGRAM_CONVERT_TAP_ALIGN;
+
+  conv->taps    = taps;
+  conv->history = half - 1;
+  conv->bank    = g_new0 (gfloat, (gsize)conv->den * taps);
+
+  for (guint p = 0; p < conv->den; p++)
+    {
+      gfloat* row = conv->bank + (gsize)p * taps;
+      gdouble sum = 0.0;
+
+      for (guint k = 0; k < 2 * half; k++)
+        {
+          gdouble d = (gdouble)k - (half - 1) - (gdouble)p / conv->den;
+          gdouble x = d / half;
+          if (fabs (x) >= 1.0)
+            continue;
+
+          gdouble s = d == 0.0 ? 1.0
+                               : sin (2.0 * G_PI * cutoff * d)
+                                     / (2.0 * G_PI * cutoff * d);
+          gdouble w = 0.42 + 0.5 * cos (G_PI * x) + 0.08 * cos (2.0 * G_PI * x);
+          row[k]    = (gfloat)(s * w);
+          sum += row[k];
+        }
+
+      for (guint k = 0; k < taps; k++)
+        row[k] = (gfloat)(row[k] / sum);
+    }
+}
+
+DeepgramConverter*
+deepgram_converter_new (DeepgramSampleFormat format, guint rate,
+                        guint channels, guint out_rate)
+{
+  g_return_val_if_fail (rate > 0 && out_rate > 0 && channels > 0, NULL);
+
+  deepgram_convert_init_simd ();
+
+  DeepgramConverter* conv = g_new0 (DeepgramConverter, 1);
+  conv->format            = format;
+  conv->channels          = channels;
+  conv->channel           = -1;
+  conv->scratch           = g_new (gfloat, DEEPGRAM_CONVERT_BLOCK);
+
+  if (rate != out_rate)
+    {
+      guint gcd       = deepgram_convert_gcd (rate, out_rate);
+      guint num       = rate / gcd;
+      conv->den       = out_rate / gcd;
+      conv->step_int  = num / conv->den;
+      conv->step_frac = num % conv->den;
+      deepgram_converter_build_bank (conv, rate, out_rate);
+    }
+
+  deepgram_converter_reset (conv);
+  return conv;
+}
+
+DeepgramConverter*
+deepgram_converter_new_channel (DeepgramSampleFormat format, guint rate,
+                                guint channels, guint channel, guint out_rate)
+{
+  g_return_val_if_fail (channel < channels, NULL);
+
+  DeepgramConverter* conv
+      = deepgram_converter_new (format, rate, channels, out_rate);
+  conv->channel = channel;
+
+  return conv;
+}
+
+void
+deepgram_converter_free (DeepgramConverter* conv)
+{
+  if (!conv)
+    return;
+
+  g_free (conv->bank);
+  g_free (conv->work);
+  g_free (conv->scratch);
+  g_free (conv);
+}
+
+void
+deepgram_converter_reset (DeepgramConverter* conv)
+{
+  /* Zero history, so the first output is centred on the first input. */
+  conv->work_len = 0;
+  conv->pos      = 0;
+  conv->frac     = 0;
+  if (conv->bank)
+    {
+      if (conv->work_cap < conv->history)
+        {
+          conv->work_cap = conv->history;
+          conv->work     = g_renew (gfloat, conv->work, conv->work_cap);
+        }
+      memset (conv->work, 0, conv->history * sizeof (gfloat));
+      conv->work_len = conv->history;
+    }
+}
+
+gsize
+deepgram_converter_get_max_output (DeepgramConverter* conv, gsize in_frames)
+{
+  if (!conv->bank)
+    return in_frames;
+
+  gsize avail = conv->work_len - conv->pos + in_frames;
+  return avail * conv->den / (conv->step_int * conv->den + conv->step_frac)
+         + 1;
+}
+
+gsize
+deepgram_converter_process (DeepgramConverter* conv, const guint8* in,
+                            gsize in_frames, gint16* out)
+{
+  gsize in_bpf = conv->channels
+                 * (conv->format == DEEPGRAM_SAMPLE_S16LE ? 2 : 4);
+
+  if (!conv->bank)
+    {
+      /* Same rate: downmix and convert block by block. */
+      for (gsize done = 0; done < in_frames;)
+        {
+          gsize n = MIN (in_frames - done, DEEPGRAM_CONVERT_BLOCK);
+          deepgram_converter_to_float (conv, in + done * in_bpf, n,
+                                       conv->scratch);
+          deepgram_convert_to_s16 (conv->scratch, n, out + done);
+          done += n;
+        }
+      return in_frames;
+    }
+
+  if (conv->work_len + in_frames > conv->work_cap)
+    {
+      conv->work_cap = conv->work_len + in_frames;
+      conv->work     = g_renew (gfloat, conv->work, conv->work_cap);
+    }
+  deepgram_converter_to_float (conv, in, in_frames,
+                               conv->work + conv->work_len);
+  conv->work_len += in_frames;
+
+  /* Filter into the scratch block, then pack to S16 a block at a time. */
+  gsize produced = 0;
+  gsize n        = 0;
+  while (conv->pos + conv->taps <= conv->work_len)
+    {
+      conv->scratch[n++] = deepgram_convert_dot (
+          conv->bank + (gsize)conv->frac * conv->taps, conv->work + conv->pos,
+          conv->taps);
+
+      conv->pos += conv->step_int;
+      conv->frac += conv->step_frac;
+      if (conv->frac >= conv->den)
+        {
+          conv->frac -= conv->den;
+          conv->pos++;
+        }
+
+      if (n == DEEPGRAM_CONVERT_BLOCK)
+        {
+          deepgram_convert_to_s16 (conv->scratch, n, out + produced);
+          produced += n;
+          n = 0;
+        }
+    }
+  deepgram_convert_to_s16 (conv->scratch, n, out + produced);
+  produced += n;
+
+  /* Keep what the next outputs still need. */
+  gsize keep = conv->work_len - MIN (conv->pos, conv->work_len);
+  memmove (conv->work, conv->work + conv->work_len - keep,
+           keep * sizeof (gfloat));
+  conv->pos -= conv->work_len - keep;
+  conv->work_len = keep;
+
+  return produced;
+}
@@ -0,0 +1,48 @@
+#ifndef __DEEPGRAM_CONVERT_H__
+#define __DEEPGRAM_CONVERT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  DEEPGRAM_SAMPLE_S16LE,
+  DEEPGRAM_SAMPLE_F32LE,
+} DeepgramSampleFormat;
+
+/* Turns interleaved S16LE/F32LE audio of any channel count and rate into
+ * the mono S16LE stream Deepgram is sent, in one pass per block: samples are
+ * downmixed and converted together, then resampled with a windowed-sinc
+ * polyphase filter if the rates differ. Filter state carries over between
+ * calls, so buffers can be fed as they come. */
+typedef struct _DeepgramConverter DeepgramConverter;
+
+DeepgramConverter * deepgram_converter_new(DeepgramSampleFormat format,
+                                           guint rate, guint channels,
+                                           guint out_rate);
+
+/* Same, but only passes on the given channel of the input instead of
+ * downmixing; one converter per channel keeps channels apart. */
+DeepgramConverter * deepgram_converter_new_channel(DeepgramSampleFormat format,
+                                                   guint rate, guint channels,
+                                                   guint channel,
+                                                   guint out_rate);
+
+void deepgram_converter_free(DeepgramConverter *conv);
+
+/* Forgets buffered input, e.g. after a flush. */
+void deepgram_converter_reset(DeepgramConverter *conv);
+
+/* Upper bound on the frames the next process() call can output. */
+gsize deepgram_converter_get_max_output(DeepgramConverter *conv,
+                                        gsize in_frames);
+
+gsize deepgram_converter_process(DeepgramConverter *conv, const guint8 *in,
+                                 gsize in_frames, gint16 *out);
+
+/* Name of the SIMD variant in use, for benchmarks. */
+const gchar * deepgram_converter_get_simd(void);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_CONVERT_H__ */
@@ -0,0 +1,601 @@
+#include "deepgramencode.h"
+
+#include <string.h>
+
+#ifdef HAVE_OPUS
+#include <opus.h>
+#endif
+
+#ifdef HAVE_FLAC
+#include <FLAC/stream_encoder.h>
+#endif
+
+/* Codec frame length: the most audio the encoder holds back. */
+#define DEEPGRAM_ENCODE_FRAME_MS 20
+
+/* Ogg Opus granule positions always count 48 kHz samples (RFC 7845). */
+#define DEEPGRAM_OPUS_GRANULE_RATE 48000
+
+/* Plenty for one 20 ms frame at the highest bitrate. */
+#define DEEPGRAM_OPUS_MAX_PACKET 1500
+
+#define DEEPGRAM_OGG_MAX_SEGMENTS 255
+#define DEEPGRAM_OGG_HEADER_SIZE  27
+#define DEEPGRAM_OGG_FLAG_BOS     0x02
+#define DEEPGRAM_OGG_FLAG_EOS     0x04
+
+/* libFLAC's default, a good size/CPU trade-off for speech. */
+#define DEEPGRAM_FLAC_COMPRESSION 5
+
+struct _DeepgramEncoder
+{
+  DeepgramEncoding encoding;
+  guint            rate;
+  guint            channels;
+  guint            bitrate;
+  guint            frame_samples;
+
+  /* Output produced by the current call; the first handed_out bytes were
+   * returned by the previous one. Stream headers written by reset() wait
+   * here for the first call. */
+  GByteArray* out;
+  gsize       handed_out;
+  gboolean    finished;
+
+  /* Frames (per channel) given to the encoder since the stream began. */
+  guint64 input_frames;
+
+#ifdef HAVE_OPUS
+  OpusEncoder* opus;
+  gint16*      pending;
+  guint        pending_frames;
+  guint        pre_skip;
+  guint64      granule;
+  guint32      serial;
+  guint32      page_seq;
+  guint8       lacing[DEEPGRAM_OGG_MAX_SEGMENTS];
+  guint        n_lacing;
+  GByteArray*  page;
+#endif
+
+#ifdef HAVE_FLAC
+  FLAC__StreamEncoder* flac;
+  FLAC__int32*         flac_buf;
+  gsize                flac_cap;
+#endif
+};
+
+GType
+deepgram_encoding_get_type (void)
+{
+  static gsize            encoding_type = 0;
+  static const GEnumValue values[]      = {
+    { DEEPGRAM_ENCODING_LINEAR16, "Uncompressed 16-bit PCM", "linear16" },
+    { DEEPGRAM_ENCODING_OPUS, "Ogg Opus", "opus" },
+    { DEEPGRAM_ENCODING_FLAC, "FLAC", "flac" },
+    { 0, NULL, NULL },
+  };
+
+  if (g_once_init_enter (&encoding_type))
+    {
+      GType type = g_enum_register_static ("DeepgramEncoding", values);
+      g_once_init_leave (&encoding_type, type);
+    }
+
+  return encoding_type;
+}
+
+const gchar*
+deepgram_encoding_get_name (DeepgramEncoding encoding)
+{
+  switch (encoding)
+    {
+    case DEEPGRAM_ENCODING_OPUS:
+      return "opus";
+    case DEEPGRAM_ENCODING_FLAC:
+      return "flac";
+    case DEEPGRAM_ENCODING_LINEAR16:
+    default:
+      return "linear16";
+    }
+}
+
+gboolean
+deepgram_encoding_is_supported (DeepgramEncoding encoding)
+{
+  switch (encoding)
+    {
+    case DEEPGRAM_ENCODING_LINEAR16:
+      return TRUE;
+    case DEEPGRAM_ENCODING_OPUS:
+#ifdef HAVE_OPUS
+      return TRUE;
+#else
+      return FALSE;
+#endif
+    case DEEPGRAM_ENCODING_FLAC:
+#ifdef HAVE_FLAC
+      return TRUE;
+#else
+      return FALSE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+/* ---- Ogg Opus ----------------------------------------------------------- */
+
+#ifdef HAVE_OPUS
+
+static guint32 deepgram_ogg_crc_table[256];
+
+/* CRC-32 with polynomial 0x04c11db7, unreflected, as Ogg pages use it. */
+static void
+deepgram_ogg_init_crc (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      for (guint i = 0; i < 256; i++)
+        {
+          guint32 r = (guint32)i << 24;
+          for (guint j = 0; j < 8; j++)
+            r = (r & 0x80000000u) ? (r << 1) ^ 0x04c11db7u : r << 1;
+          deepgram_ogg_crc_table[i] = r;
+        }
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+static guint32
+deepgram_ogg_crc (guint32 crc, const guint8* data, gsize size)
+{
+  for (gsize i = 0; i < size; i++)
+    crc = (crc << 8) ^ deepgram_ogg_crc_table[((crc >> 24) ^ data[i]) & 0xff];
+  return crc;
+}
+
+static void
+deepgram_put_le16 (guint8* p, guint16 v)
+{
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+static void
+deepgram_put_le32 (guint8* p, guint32 v)
+{
+  for (guint i = 0; i < 4; i++)
+    p[i] = (v >> (8 * i)) & 0xff;
+}
+
+/* Closes the page holding the packets added so far. A page ends with the
+ * granule position of its last complete packet. */
+static void
+deepgram_ogg_flush_page (DeepgramEncoder* enc, guint8 flags)
+{
+  guint8 header[DEEPGRAM_OGG_HEADER_SIZE + DEEPGRAM_OGG_MAX_SEGMENTS];
+  gsize  header_size = DEEPGRAM_OGG_HEADER_SIZE + enc->n_lacing;
+
+  memcpy (header, "OggS", 4);
+  header[4] = 0;
+  header[5] = flags;
+  for (guint i = 0; i < 8; i++)
+    header[6 + i] = (enc->granule >> (8 * i)) & 0xff;
+  deepgram_put_le32 (header + 14, enc->serial);
+  deepgram_put_le32 (header + 18, enc->page_seq++);
+  deepgram_put_le32 (header + 22, 0);
+  header[26] = enc->n_lacing;
+  memcpy (header + DEEPGRAM_OGG_HEADER_SIZE, enc->lacing, enc->n_lacing);
+
+  guint32 crc = deepgram_ogg_crc (0, header, header_size);
+  crc         = deepgram_ogg_crc (crc, enc->page->data, enc->page->len);
+  deepgram_put_le32 (header + 22, crc);
+
+  g_byte_array_append (enc->out, header, header_size);
+  g_byte_array_append (enc->out, enc->page->data, enc->page->len);
+  g_byte_array_set_size (enc->page, 0);
+  enc->n_lacing = 0;
+}
+
+static void
+deepgram_ogg_add_packet (DeepgramEncoder* enc, const guint8* data, gsize size)
+{
+  guint segments = size / 255 + 1;
+
+  if (enc->n_lacing + segments > DEEPGRAM_OGG_MAX_SEGMENTS)
+    deepgram_ogg_flush_page (enc, 0);
+
+  for (guint i = 0; i + 1 < segments; i++)
+    enc->lacing[enc->n_lacing++] = 255;
+  enc->lacing[enc->n_lacing++] = size % 255;
+  g_byte_array_append (enc->page, data, size);
+}
+
+/* OpusHead and OpusTags, each on a page of its own (RFC 7845 section 5). */
+static void
+deepgram_opus_write_headers (DeepgramEncoder* enc)
+{
+  guint8 head[19];
+  memcpy (head, "OpusHead", 8);
+  head[8] = 1;
+  head[9] = enc->channels;
+  deepgram_put_le16 (head + 10, enc->pre_skip);
+  deepgram_put_le32 (head + 12, enc->rate);
+  deepgram_put_le16 (head + 16, 0);
+  head[18] = 0;
+
+  deepgram_ogg_add_packet (enc, head, sizeof (head));
+  deepgram_ogg_flush_page (enc, DEEPGRAM_OGG_FLAG_BOS);
+
+  const gchar* vendor     = opus_get_version_string ();
+  gsize        vendor_len = strlen (vendor);
+  guint8*      tags       = g_malloc (16 + vendor_len);
+  memcpy (tags, "OpusTags", 8);
+  deepgram_put_le32 (tags + 8, vendor_len);
+  memcpy (tags + 12, vendor, vendor_len);
+  deepgram_put_le32 (tags + 12 + vendor_len, 0);
+
+  deepgram_ogg_add_packet (enc, tags, 16 + vendor_len);
+  deepgram_ogg_flush_page (enc, 0);
+  g_free (tags);
+}
+
+static gboolean
+deepgram_opus_encode_frame (DeepgramEncoder* enc, const gint16* pcm)
+{
+  guint8     packet[DEEPGRAM_OPUS_MAX_PACKET];
+  opus_int32 len = opus_encode (enc->opus, pcm, enc->frame_samples, packet,
+                                sizeof (packet));
+
+  if (len < 0)
+    {
+      g_printerr ("[DeepgramEncoder] Opus encoding failed: %s\n",
+                  opus_strerror (len));
+      return FALSE;
+    }
+
+  deepgram_ogg_add_packet (enc, packet, len);
+  enc->granule += (guint64)enc->frame_samples * DEEPGRAM_OPUS_GRANULE_RATE
+                  / enc->rate;
+  return TRUE;
+}
+
+static gboolean
+deepgram_opus_init (DeepgramEncoder* enc)
+{
+  gint error = OPUS_OK;
+
+  enc->opus = opus_encoder_create (enc->rate, enc->channels,
+                                   OPUS_APPLICATION_VOIP, &error);
+  if (error != OPUS_OK)
+    {
+      g_printerr ("[DeepgramEncoder] Cannot encode %u Hz x%u as Opus: %s\n",
+                  enc->rate, enc->channels, opus_strerror (error));
+      enc->opus = NULL;
+      return FALSE;
+    }
+
+  opus_encoder_ctl (enc->opus, OPUS_SET_BITRATE (enc->bitrate));
+  opus_encoder_ctl (enc->opus, OPUS_SET_SIGNAL (OPUS_SIGNAL_VOICE));
+
+  deepgram_ogg_init_crc ();
+  enc->pending = g_new (gint16, enc->frame_samples * enc->channels);
+  enc->page    = g_byte_array_new ();
+
+  return TRUE;
+}
+
+static void
+deepgram_opus_reset (DeepgramEncoder* enc)
+{
+  opus_int32 lookahead = 0;
+
+  opus_encoder_ctl (enc->opus, OPUS_RESET_STATE);
+  opus_encoder_ctl (enc->opus, OPUS_GET_LOOKAHEAD (&lookahead));
+
+  enc->pre_skip       = lookahead * (DEEPGRAM_OPUS_GRANULE_RATE / enc->rate);
+  enc->pending_frames = 0;
+  enc->granule        = 0;
+  enc->serial         = g_random_int ();
+  enc->page_seq       = 0;
+  enc->n_lacing       = 0;
+  g_byte_array_set_size (enc->page, 0);
+
+  deepgram_opus_write_headers (enc);
+}
+
+/* Whole frames go to the encoder, the remainder waits for the next call.
+ * Everything encoded here ends up on one page, so a WebSocket message
+ * carries whole pages. */
+static void
+deepgram_opus_encode (DeepgramEncoder* enc, const guint8* data, gsize size)
+{
+  gsize bpf    = enc->channels * sizeof (gint16);
+  gsize frames = size / bpf;
+
+  while (frames > 0)
+    {
+      guint take = MIN (frames, enc->frame_samples - enc->pending_frames);
+      memcpy (enc->pending + enc->pending_frames * enc->channels, data,
+              take * bpf);
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+      for (guint i = 0; i < take * enc->channels; i++)
+        enc->pending[enc->pending_frames * enc->channels + i] = GINT16_FROM_LE (
+            enc->pending[enc->pending_frames * enc->channels + i]);
+#endif
+      enc->pending_frames += take;
+      data += take * bpf;
+      frames -= take;
+
+      if (enc->pending_frames == enc->frame_samples)
+        {
+          deepgram_opus_encode_frame (enc, enc->pending);
+          enc->pending_frames = 0;
+        }
+    }
+
+  if (enc->n_lacing > 0)
+    deepgram_ogg_flush_page (enc, 0);
+}
+
+/* Pads the last frame with silence, and keeps encoding silence until the
+ * encoder's lookahead has caught up with the end of the input. The final
+ * granule position then trims the padding off again. */
+static void
+deepgram_opus_finish (DeepgramEncoder* enc)
+{
+  guint   scale = DEEPGRAM_OPUS_GRANULE_RATE / enc->rate;
+  guint64 end   = enc->pre_skip + enc->input_frames * scale;
+
+  if (enc->pending_frames > 0)
+    {
+      memset (enc->pending + enc->pending_frames * enc->channels, 0,
+              (enc->frame_samples - enc->pending_frames) * enc->channels
+                  * sizeof (gint16));
+      deepgram_opus_encode_frame (enc, enc->pending);
+      enc->pending_frames = 0;
+    }
+
+  memset (enc->pending, 0,
+          enc->frame_samples * enc->channels * sizeof (gint16));
+  while (enc->granule < end)
+    if (!deepgram_opus_encode_frame (enc, enc->pending))
+      break;
+
+  enc->granule = MIN (enc->granule, end);
+  deepgram_ogg_flush_page (enc, DEEPGRAM_OGG_FLAG_EOS);
+}
+
+#endif /* HAVE_OPUS */
+
+/* ---- FLAC --------------------------------------------------------------- */
+
+#ifdef HAVE_FLAC
+
+static FLAC__StreamEncoderWriteStatus
+deepgram_flac_write (const FLAC__StreamEncoder* flac, const FLAC__byte buffer[],
+                     size_t bytes, unsigned samples, unsigned current_frame,
+                     void* client_data)
+{
+  DeepgramEncoder* enc = client_data;
+
+  g_byte_array_append (enc->out, buffer, bytes);
+  return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+/* A fresh encoder per stream; initialising it writes the fLaC marker and
+ * STREAMINFO through deepgram_flac_write(). */
+static gboolean
+deepgram_flac_start (DeepgramEncoder* enc)
+{
+  /* Deleting finishes the old stream; its tail is not wanted. */
+  if (enc->flac)
+    FLAC__stream_encoder_delete (enc->flac);
+  g_byte_array_set_size (enc->out, 0);
+
+  enc->flac = FLAC__stream_encoder_new ();
+  if (!enc->flac)
+    return FALSE;
+
+  /* Small blocks keep the latency at one codec frame, at a small cost in
+   * compression. */
+  FLAC__stream_encoder_set_channels (enc->flac, enc->channels);
+  FLAC__stream_encoder_set_bits_per_sample (enc->flac, 16);
+  FLAC__stream_encoder_set_sample_rate (enc->flac, enc->rate);
+  FLAC__stream_encoder_set_compression_level (enc->flac,
+                                              DEEPGRAM_FLAC_COMPRESSION);
+  FLAC__stream_encoder_set_blocksize (enc->flac, enc->frame_samples);
+  FLAC__stream_encoder_set_do_md5 (enc->flac, FALSE);
+
+  FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream (
+      enc->flac, deepgram_flac_write, NULL, NULL, NULL, enc);
+  if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+      g_printerr ("[DeepgramEncoder] Cannot encode %u Hz x%u as FLAC: %s\n",
+                  enc->rate, enc->channels,
+                  FLAC__StreamEncoderInitStatusString[status]);
+      FLAC__stream_encoder_delete (enc->flac);
+      enc->flac = NULL;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+deepgram_flac_encode (DeepgramEncoder* enc, const guint8* data, gsize size)
+{
+  gsize samples = size / sizeof (gint16);
+  gsize frames  = samples / enc->channels;
+
+  if (!enc->flac || frames == 0)
+    return;
+
+  samples = frames * enc->channels;
+  if (samples > enc->flac_cap)
+    {
+      enc->flac_cap = samples;
+      enc->flac_buf = g_renew (FLAC__int32, enc->flac_buf, samples);
+    }
+
+  for (gsize i = 0; i < samples; i++)
+    {
+      gint16 s;
+      memcpy (&s, data + i * sizeof (gint16), sizeof (s));
+      enc->flac_buf[i] = GINT16_FROM_LE (s);
+    }
+
+  if (!FLAC__stream_encoder_process_interleaved (enc->flac, enc->flac_buf,
+                                                 frames))
+    g_printerr ("[DeepgramEncoder] FLAC encoding failed: %s\n",
+                FLAC__stream_encoder_get_resolved_state_string (enc->flac));
+}
+
+#endif /* HAVE_FLAC */
+
+/* ---- Public API --------------------------------------------------------- */
+
+DeepgramEncoder*
+deepgram_encoder_new (DeepgramEncoding encoding, guint rate, guint channels,
+                      guint bitrate)
+{
+  g_return_val_if_fail (encoding != DEEPGRAM_ENCODING_LINEAR16, NULL);
+  g_return_val_if_fail (rate > 0 && channels > 0, NULL);
+
+  if (!deepgram_encoding_is_supported (encoding))
+    {
+      g_printerr ("[DeepgramEncoder] Built without %s support.\n",
+                  deepgram_encoding_get_name (encoding));
+      return NULL;
+    }
+
+  DeepgramEncoder* enc = g_new0 (DeepgramEncoder, 1);
+  enc->encoding        = encoding;
+  enc->rate            = rate;
+  enc->channels        = channels;
+  enc->bitrate         = bitrate;
+  enc->frame_samples   = rate * DEEPGRAM_ENCODE_FRAME_MS / 1000;
+  enc->out             = g_byte_array_new ();
+
+  gboolean ok = FALSE;
+#ifdef HAVE_OPUS
+  if (encoding == DEEPGRAM_ENCODING_OPUS)
+    ok = deepgram_opus_init (enc);
+#endif
+#ifdef HAVE_FLAC
+  if (encoding == DEEPGRAM_ENCODING_FLAC)
+    ok = TRUE;
+#endif
+
+  if (!ok)
+    {
+      deepgram_encoder_free (enc);
+      return NULL;
+    }
+
+  deepgram_encoder_reset (enc);
+
+#ifdef HAVE_FLAC
+  if (encoding == DEEPGRAM_ENCODING_FLAC && !enc->flac)
+    {
+      deepgram_encoder_free (enc);
+      return NULL;
+    }
+#endif
+
+  return enc;
+}
+
+void
+deepgram_encoder_free (DeepgramEncoder* enc)
+{
+  if (!enc)
+    return;
+
+#ifdef HAVE_OPUS
+  if (enc->opus)
+    opus_encoder_destroy (enc->opus);
+  g_free (enc->pending);
+  if (enc->page)
+    g_byte_array_unref (enc->page);
+#endif
+
+#ifdef HAVE_FLAC
+  if (enc->flac)
+    FLAC__stream_encoder_delete (enc->flac);
+  g_free (enc->flac_buf);
+#endif
+
+  g_byte_array_unref (enc->out);
+  g_free (enc);
+}
+
+void
+deepgram_encoder_reset (DeepgramEncoder* enc)
+{
+  enc->input_frames = 0;
+  enc->finished     = FALSE;
+  enc->handed_out   = 0;
+  g_byte_array_set_size (enc->out, 0);
+
+#ifdef HAVE_FLAC
+  if (enc->encoding == DEEPGRAM_ENCODING_FLAC)
+    deepgram_flac_start (enc);
+#endif
+
+#ifdef HAVE_OPUS
+  if (enc->encoding == DEEPGRAM_ENCODING_OPUS)
+    deepgram_opus_reset (enc);
+#endif
+}
+
+const guint8*
+deepgram_encoder_encode (DeepgramEncoder* enc, const guint8* data, gsize size,
+                         gsize* out_size)
+{
+  g_byte_array_remove_range (enc->out, 0, enc->handed_out);
+
+  if (!enc->finished)
+    {
+      enc->input_frames += size / (enc->channels * sizeof (gint16));
+
+#ifdef HAVE_OPUS
+      if (enc->encoding == DEEPGRAM_ENCODING_OPUS)
+        deepgram_opus_encode (enc, data, size);
+#endif
+#ifdef HAVE_FLAC
+      if (enc->encoding == DEEPGRAM_ENCODING_FLAC)
+        deepgram_flac_encode (enc, data, size);
+#endif
+    }
+
+  enc->handed_out = enc->out->len;
+  *out_size       = enc->out->len;
+  return enc->out->data;
+}
+
+const guint8*
+deepgram_encoder_finish (DeepgramEncoder* enc, gsize* out_size)
+{
+  g_byte_array_remove_range (enc->out, 0, enc->handed_out);
+
+  if (!enc->finished)
+    {
+#ifdef HAVE_OPUS
+      if (enc->encoding == DEEPGRAM_ENCODING_OPUS)
+        deepgram_opus_finish (enc);
+#endif
+#ifdef HAVE_FLAC
+      if (enc->encoding == DEEPGRAM_ENCODING_FLAC && enc->flac)
+        FLAC__stream_encoder_finish (enc->flac);
+#endif
+      enc->finished = TRUE;
+    }
+
+  enc->handed_out = enc->out->len;
+  *out_size       = enc->out->len;
+  return enc->out->data;
+}
@@ -0,0 +1,49 @@
+#ifndef __DEEPGRAM_ENCODE_H__
+#define __DEEPGRAM_ENCODE_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  DEEPGRAM_ENCODING_LINEAR16,
+  DEEPGRAM_ENCODING_OPUS,
+  DEEPGRAM_ENCODING_FLAC,
+} DeepgramEncoding;
+
+#define DEEPGRAM_TYPE_ENCODING (deepgram_encoding_get_type())
+GType deepgram_encoding_get_type(void);
+
+/* The value of Deepgram's encoding query parameter. */
+const gchar * deepgram_encoding_get_name(DeepgramEncoding encoding);
+
+/* Whether the plugin was built with the library the encoding needs;
+ * linear16 always is. */
+gboolean deepgram_encoding_is_supported(DeepgramEncoding encoding);
+
+/* Compresses interleaved S16LE audio into a stream Deepgram accepts: Ogg
+ * Opus or native FLAC. Input of any size is cut into 20 ms codec frames;
+ * each call returns whatever complete output the audio given so far
+ * produced, the stream headers included. */
+typedef struct _DeepgramEncoder DeepgramEncoder;
+
+DeepgramEncoder * deepgram_encoder_new(DeepgramEncoding encoding, guint rate,
+                                       guint channels, guint bitrate);
+
+void deepgram_encoder_free(DeepgramEncoder *enc);
+
+/* Starts a new stream, headers and all, e.g. for a new connection. */
+void deepgram_encoder_reset(DeepgramEncoder *enc);
+
+/* The returned bytes belong to the encoder and stay valid until the next
+ * call. */
+const guint8 * deepgram_encoder_encode(DeepgramEncoder *enc,
+                                       const guint8 *data, gsize size,
+                                       gsize *out_size);
+
+/* Encodes the buffered tail of the audio and ends the stream. */
+const guint8 * deepgram_encoder_finish(DeepgramEncoder *enc, gsize *out_size);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_ENCODE_H__ */
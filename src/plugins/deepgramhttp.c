@@ -0,0 +1,478 @@
+#include "deepgramhttp.h"
+
+#include <string.h>
+
+/* Chunks end in the middle of the quietest FRAME_MS of the last
+ * 1/SEARCH_DIVISOR of chunk_bytes. */
+#define DEEPGRAM_HTTP_FRAME_MS       20
+#define DEEPGRAM_HTTP_SEARCH_DIVISOR 4
+
+/* Retry backoff: doubles from MIN to MAX between attempts. */
+#define DEEPGRAM_HTTP_RETRY_MIN_MS 250
+#define DEEPGRAM_HTTP_RETRY_MAX_MS 8000
+
+typedef struct
+{
+  /* NULL once deepgram_http_free() has let go of the chunk while its
+   * upload was still running. */
+  DeepgramHttp* http;
+
+  /* Stream offset and size (bytes) of the audio, and what is sent. */
+  guint64 start;
+  gsize   size;
+  GBytes* body;
+
+  guint        attempt;
+  gint64       sent_at;
+  SoupMessage* msg;
+  GSource*     retry;
+
+  /* Set once answered; response stays NULL if the chunk was given up on. */
+  gboolean done;
+  GBytes*  response;
+} DeepgramHttpChunk;
+
+struct _DeepgramHttp
+{
+  SoupSession*  session;
+  GUri*         uri;
+  gchar*        auth;
+  GCancellable* cancellable;
+  guint         bytes_per_second;
+  guint         block_align;
+
+  gsize            chunk_bytes;
+  guint            max_uploads;
+  guint            max_retries;
+  DeepgramEncoder* encoder;
+  const gchar*     content_type;
+
+  DeepgramHttpCallbacks callbacks;
+  gpointer              user_data;
+
+  /* Audio not uploaded yet, pending_start bytes into the stream; once
+   * flushing, the rest goes out as a last chunk as soon as there is room. */
+  GByteArray* pending;
+  guint64     pending_start;
+  gboolean    flushing;
+
+  /* Chunks uploaded and not handed out yet, oldest first; in_flight of
+   * them are still waiting for an answer. */
+  GQueue          chunks;
+  guint           in_flight;
+  DeepgramResult* result;
+};
+
+static void deepgram_http_send (DeepgramHttpChunk* chunk);
+static void deepgram_http_start_uploads (DeepgramHttp* http);
+
+DeepgramHttp*
+deepgram_http_new (SoupSession* session, const gchar* url,
+                   const gchar* api_key, guint bytes_per_second,
+                   guint block_align, const DeepgramHttpCallbacks* callbacks,
+                   gpointer user_data)
+{
+  GError* error = NULL;
+  GUri*   uri   = g_uri_parse (url, SOUP_HTTP_URI_FLAGS, &error);
+  if (!uri)
+    {
+      g_printerr ("[DeepgramHttp] Invalid URL %s: %s\n", url, error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  DeepgramHttp* http     = g_new0 (DeepgramHttp, 1);
+  http->session          = g_object_ref (session);
+  http->uri              = uri;
+  http->auth             = g_strdup_printf ("Token %s", api_key);
+  http->cancellable      = g_cancellable_new ();
+  http->bytes_per_second = MAX (bytes_per_second, 1);
+  http->block_align      = MAX (block_align, 1);
+  http->max_uploads      = 1;
+  http->content_type     = "application/octet-stream";
+  http->callbacks        = *callbacks;
+  http->user_data        = user_data;
+  http->pending          = g_byte_array_new ();
+  http->result           = deepgram_result_new ();
+  g_queue_init (&http->chunks);
+
+  return http;
+}
+
+static void
+deepgram_http_chunk_free (DeepgramHttpChunk* chunk)
+{
+  if (chunk->retry)
+    {
+      g_source_destroy (chunk->retry);
+      g_source_unref (chunk->retry);
+    }
+  g_clear_object (&chunk->msg);
+  g_bytes_unref (chunk->body);
+  if (chunk->response)
+    g_bytes_unref (chunk->response);
+  g_free (chunk);
+}
+
+void
+deepgram_http_free (DeepgramHttp* http)
+{
+  if (!http)
+    return;
+
+  /* A chunk whose request is still running is freed by its callback,
+   * which the cancellation below brings on. */
+  DeepgramHttpChunk* chunk;
+  while ((chunk = g_queue_pop_head (&http->chunks)))
+    {
+      chunk->http = NULL;
+      if (!chunk->msg)
+        deepgram_http_chunk_free (chunk);
+    }
+  g_cancellable_cancel (http->cancellable);
+
+  g_object_unref (http->cancellable);
+  g_object_unref (http->session);
+  g_uri_unref (http->uri);
+  g_free (http->auth);
+  g_byte_array_unref (http->pending);
+  deepgram_result_free (http->result);
+  g_free (http);
+}
+
+void
+deepgram_http_set_chunking (DeepgramHttp* http, gsize chunk_bytes,
+                            guint max_uploads)
+{
+  http->chunk_bytes = chunk_bytes;
+  http->max_uploads = MAX (max_uploads, 1);
+}
+
+void
+deepgram_http_set_max_retries (DeepgramHttp* http, guint max_retries)
+{
+  http->max_retries = max_retries;
+}
+
+void
+deepgram_http_set_encoder (DeepgramHttp* http, DeepgramEncoding encoding,
+                           DeepgramEncoder* encoder)
+{
+  http->encoder = encoder;
+
+  switch (encoding)
+    {
+    case DEEPGRAM_ENCODING_OPUS:
+      http->content_type = "audio/ogg";
+      break;
+    case DEEPGRAM_ENCODING_FLAC:
+      http->content_type = "audio/flac";
+      break;
+    default:
+      http->content_type = "application/octet-stream";
+      break;
+    }
+}
+
+/* Hands out the answered chunks at the head of the queue; a chunk still
+ * waiting holds back everything after it. */
+static void
+deepgram_http_deliver (DeepgramHttp* http)
+{
+  DeepgramHttpChunk* chunk;
+
+  while ((chunk = g_queue_peek_head (&http->chunks)) && chunk->done)
+    {
+      g_queue_pop_head (&http->chunks);
+
+      gsize        size   = 0;
+      const gchar* data   = chunk->response
+                                ? g_bytes_get_data (chunk->response, &size)
+                                : NULL;
+      gdouble      offset = (gdouble)chunk->start / http->bytes_per_second;
+      guint        n_channels = data ? 1 : 0;
+      GError*      error      = NULL;
+
+      for (guint channel = 0; channel < n_channels; channel++)
+        {
+          DeepgramResult* result = http->result;
+
+          if (!deepgram_result_parse_prerecorded (result, data, size, channel,
+                                                  &n_channels, &error))
+            {
+              g_printerr ("[DeepgramHttp] Bad response for the audio at "
+                          "%.1f s: %s\n",
+                          offset, error->message);
+              g_clear_error (&error);
+              break;
+            }
+
+          /* The chunk's own range rather than Deepgram's rounded
+           * duration, so consecutive chunks meet exactly. */
+          result->has_range = TRUE;
+          result->start     = 0.0;
+          result->duration  = (gdouble)chunk->size / http->bytes_per_second;
+          http->callbacks.on_result (result, offset, http->user_data);
+        }
+
+      deepgram_http_chunk_free (chunk);
+    }
+}
+
+static void
+deepgram_http_complete (DeepgramHttpChunk* chunk, GBytes* response)
+{
+  DeepgramHttp* http = chunk->http;
+  guint64       time = (g_get_monotonic_time () - chunk->sent_at) * 1000;
+
+  chunk->done     = TRUE;
+  chunk->response = response;
+  http->in_flight--;
+
+  /* Before the results, so they find the upload accounted for. */
+  http->callbacks.on_uploaded (g_bytes_get_size (chunk->body), time,
+                               response != NULL, http->user_data);
+  deepgram_http_deliver (http);
+  deepgram_http_start_uploads (http);
+}
+
+static gboolean
+deepgram_http_retry (gpointer user_data)
+{
+  DeepgramHttpChunk* chunk = user_data;
+
+  g_clear_pointer (&chunk->retry, g_source_unref);
+  deepgram_http_send (chunk);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+deepgram_http_upload_cb (GObject* source_object, GAsyncResult* res,
+                         gpointer user_data)
+{
+  DeepgramHttpChunk* chunk = user_data;
+  DeepgramHttp*      http  = chunk->http;
+  GError*            error = NULL;
+
+  GBytes* body = soup_session_send_and_read_finish (
+      SOUP_SESSION (source_object), res, &error);
+  guint status = soup_message_get_status (chunk->msg);
+  g_clear_object (&chunk->msg);
+
+  if (!http)
+    {
+      g_clear_error (&error);
+      if (body)
+        g_bytes_unref (body);
+      deepgram_http_chunk_free (chunk);
+      return;
+    }
+
+  if (body && status == SOUP_STATUS_OK)
+    {
+      deepgram_http_complete (chunk, body);
+      return;
+    }
+
+  gchar* reason;
+  if (error)
+    {
+      reason = g_strdup (error->message);
+    }
+  else
+    {
+      gsize        size = 0;
+      const gchar* text = body ? g_bytes_get_data (body, &size) : NULL;
+      reason = g_strdup_printf ("HTTP %u %.*s", status, (int)MIN (size, 200),
+                                text ? text : "");
+    }
+
+  gboolean transient = error != NULL
+                       || status == SOUP_STATUS_TOO_MANY_REQUESTS
+                       || status >= 500;
+  gdouble at = (gdouble)chunk->start / http->bytes_per_second;
+
+  if (transient && chunk->attempt < http->max_retries)
+    {
+      guint delay_ms = DEEPGRAM_HTTP_RETRY_MIN_MS << MIN (chunk->attempt, 8);
+      delay_ms       = MIN (delay_ms, DEEPGRAM_HTTP_RETRY_MAX_MS);
+
+      g_printerr ("[DeepgramHttp] Upload of the audio at %.1f s failed (%s), "
+                  "retrying in %u ms.\n",
+                  at, reason, delay_ms);
+      chunk->attempt++;
+      chunk->retry = g_timeout_source_new (delay_ms);
+      g_source_set_callback (chunk->retry, deepgram_http_retry, chunk, NULL);
+      g_source_attach (chunk->retry, g_main_context_get_thread_default ());
+    }
+  else
+    {
+      gdouble duration = (gdouble)chunk->size / http->bytes_per_second;
+
+      g_printerr ("[DeepgramHttp] Giving up on %.1f s of audio at %.1f s: "
+                  "%s\n",
+                  duration, at, reason);
+      http->callbacks.on_failed (at, duration, http->user_data);
+      deepgram_http_complete (chunk, NULL);
+    }
+
+  g_free (reason);
+  g_clear_error (&error);
+  if (body)
+    g_bytes_unref (body);
+}
+
+static void
+deepgram_http_send (DeepgramHttpChunk* chunk)
+{
+  DeepgramHttp* http = chunk->http;
+  SoupMessage*  msg  = soup_message_new_from_uri (SOUP_METHOD_POST, http->uri);
+
+  soup_message_headers_append (soup_message_get_request_headers (msg),
+                               "Authorization", http->auth);
+  soup_message_set_request_body_from_bytes (msg, http->content_type,
+                                            chunk->body);
+
+  chunk->msg     = msg;
+  chunk->sent_at = g_get_monotonic_time ();
+  soup_session_send_and_read_async (http->session, msg, G_PRIORITY_DEFAULT,
+                                    http->cancellable,
+                                    deepgram_http_upload_cb, chunk);
+}
+
+/* What is sent for size bytes of audio: the audio itself, or a complete
+ * compressed file of it. */
+static GBytes*
+deepgram_http_encode (DeepgramHttp* http, const guint8* data, gsize size)
+{
+  if (!http->encoder)
+    return g_bytes_new (data, size);
+
+  GByteArray*   out = g_byte_array_new ();
+  const guint8* encoded;
+  gsize         encoded_size;
+
+  deepgram_encoder_reset (http->encoder);
+  encoded = deepgram_encoder_encode (http->encoder, data, size, &encoded_size);
+  g_byte_array_append (out, encoded, encoded_size);
+  encoded = deepgram_encoder_finish (http->encoder, &encoded_size);
+  g_byte_array_append (out, encoded, encoded_size);
+
+  return g_byte_array_free_to_bytes (out);
+}
+
+/* Uploads the first size bytes of the pending audio as the next chunk. */
+static void
+deepgram_http_upload (DeepgramHttp* http, gsize size)
+{
+  DeepgramHttpChunk* chunk = g_new0 (DeepgramHttpChunk, 1);
+
+  chunk->http  = http;
+  chunk->start = http->pending_start;
+  chunk->size  = size;
+  chunk->body  = deepgram_http_encode (http, http->pending->data, size);
+
+  g_byte_array_remove_range (http->pending, 0, size);
+  http->pending_start += size;
+
+  g_queue_push_tail (&http->chunks, chunk);
+  http->in_flight++;
+  deepgram_http_send (chunk);
+}
+
+/* Where the next chunk ends: in the middle of the quietest frame near the
+ * end of chunk_bytes, so that a cut rarely falls inside a word. Energy is
+ * summed over all channels. */
+static gsize
+deepgram_http_find_cut (DeepgramHttp* http)
+{
+  gsize align = http->block_align;
+  gsize frame = http->bytes_per_second * DEEPGRAM_HTTP_FRAME_MS / 1000;
+  gsize end   = http->chunk_bytes - http->chunk_bytes % align;
+  gsize from  = end - end / DEEPGRAM_HTTP_SEARCH_DIVISOR;
+
+  frame = MAX (frame - frame % align, align);
+  from -= from % align;
+
+  gsize   cut  = end;
+  guint64 best = G_MAXUINT64;
+  for (gsize pos = from; pos + frame <= end; pos += frame)
+    {
+      const gint16* samples = (const gint16*)(http->pending->data + pos);
+      guint64       energy  = 0;
+
+      for (gsize i = 0; i < frame / 2; i++)
+        energy += (gint64)samples[i] * samples[i];
+
+      if (energy < best)
+        {
+          best = energy;
+          cut  = pos + frame / 2;
+        }
+    }
+
+  cut -= cut % align;
+  return MAX (cut, align);
+}
+
+/* Starts uploads while fewer than max_uploads are unanswered: one for
+ * every complete chunk pending and, once flushing, one for the rest.
+ * Whatever does not fit waits for an answer to come in. */
+static void
+deepgram_http_start_uploads (DeepgramHttp* http)
+{
+  while (http->in_flight < http->max_uploads && http->pending->len > 0)
+    {
+      if (http->chunk_bytes > 0 && http->pending->len >= http->chunk_bytes)
+        deepgram_http_upload (http, deepgram_http_find_cut (http));
+      else if (http->flushing)
+        deepgram_http_upload (http, http->pending->len);
+      else
+        break;
+    }
+}
+
+/* Whether another chunk may be started; the caller should hold back
+ * audio until on_uploaded says otherwise. */
+gboolean
+deepgram_http_can_push (DeepgramHttp* http)
+{
+  return http->in_flight < http->max_uploads;
+}
+
+void
+deepgram_http_push (DeepgramHttp* http, const guint8* data, gsize size)
+{
+  g_byte_array_append (http->pending, data, size);
+  deepgram_http_start_uploads (http);
+}
+
+/* Uploads what is pending, the end as a last, shorter chunk, as soon as
+ * max_uploads allows. */
+void
+deepgram_http_flush (DeepgramHttp* http)
+{
+  http->flushing = TRUE;
+  deepgram_http_start_uploads (http);
+}
+
+/* Forgets the audio not uploaded yet, e.g. after a flush, and returns how
+ * much that was; chunks already on their way are still answered. */
+gsize
+deepgram_http_discard (DeepgramHttp* http)
+{
+  gsize discarded = http->pending->len;
+
+  g_byte_array_set_size (http->pending, 0);
+  http->flushing = FALSE;
+
+  return discarded;
+}
+
+/* Whether every chunk has been answered and handed out. */
+gboolean
+deepgram_http_is_done (DeepgramHttp* http)
+{
+  return http->pending->len == 0 && g_queue_is_empty (&http->chunks);
+}
@@ -0,0 +1,71 @@
+#ifndef __DEEPGRAM_HTTP_H__
+#define __DEEPGRAM_HTTP_H__
+
+#include <glib.h>
+#include <libsoup/soup.h>
+
+#include "deepgramencode.h"
+#include "deepgramresult.h"
+
+G_BEGIN_DECLS
+
+/* Transcribes a stream through Deepgram's prerecorded API rather than a
+ * WebSocket, for files: the audio is cut into chunks at quiet points, each
+ * chunk is POSTed to /v1/listen on its own, several at a time over one
+ * SoupSession, and the responses are handed out in stream order whatever
+ * order they arrive in, timed from the start of the stream. Used from one
+ * thread, whose thread-default GMainContext the requests complete in. */
+typedef struct _DeepgramHttp DeepgramHttp;
+
+typedef struct {
+  /* A channel's result for a chunk, in stream order; offset (s) is where
+   * the chunk starts in the stream. */
+  void (*on_result) (DeepgramResult *result, gdouble offset,
+                     gpointer user_data);
+
+  /* A chunk of size bytes (as sent) was answered after time (ns) since it
+   * was last sent, or given up on (ok is FALSE); either way it no longer
+   * counts against max_uploads. Called before its results. */
+  void (*on_uploaded) (gsize size, guint64 time, gboolean ok,
+                       gpointer user_data);
+
+  /* A chunk was given up on, so the audio from start for duration (s)
+   * will have no results. Called before its on_uploaded. */
+  void (*on_failed) (gdouble start, gdouble duration, gpointer user_data);
+} DeepgramHttpCallbacks;
+
+DeepgramHttp * deepgram_http_new(SoupSession *session, const gchar *url,
+                                 const gchar *api_key, guint bytes_per_second,
+                                 guint block_align,
+                                 const DeepgramHttpCallbacks *callbacks,
+                                 gpointer user_data);
+
+/* Cancels the uploads still running; no callbacks are called after this. */
+void deepgram_http_free(DeepgramHttp *http);
+
+/* chunk_bytes of audio per upload, 0 for a single upload at the end; at
+ * most max_uploads unanswered at a time. */
+void deepgram_http_set_chunking(DeepgramHttp *http, gsize chunk_bytes,
+                                guint max_uploads);
+
+/* Attempts after a network error or a 429/5xx answer, per chunk. */
+void deepgram_http_set_max_retries(DeepgramHttp *http, guint max_retries);
+
+/* Compresses every chunk into a file of its own; the encoder stays the
+ * caller's. */
+void deepgram_http_set_encoder(DeepgramHttp *http, DeepgramEncoding encoding,
+                               DeepgramEncoder *encoder);
+
+gboolean deepgram_http_can_push(DeepgramHttp *http);
+
+void deepgram_http_push(DeepgramHttp *http, const guint8 *data, gsize size);
+
+void deepgram_http_flush(DeepgramHttp *http);
+
+gsize deepgram_http_discard(DeepgramHttp *http);
+
+gboolean deepgram_http_is_done(DeepgramHttp *http);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_HTTP_H__ */
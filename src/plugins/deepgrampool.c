@@ -0,0 +1,224 @@
+#include "deepgrampool.h"
+
+#include <stdatomic.h>
+
+#define DEEPGRAM_POOL_WORKERS_ENV "DEEPGRAM_WS_WORKERS"
+
+/* Upper bound on DEEPGRAM_WS_WORKERS, against typos. */
+#define DEEPGRAM_POOL_MAX_WORKERS 1024
+
+/* libsoup keeps at most 2 connections per host by default, which would
+ * serialise transport=http uploads; WebSockets leave the session's
+ * connection pool once open and are not limited by this. */
+#define DEEPGRAM_POOL_MAX_CONNS          256
+#define DEEPGRAM_POOL_MAX_CONNS_PER_HOST 64
+
+struct _DeepgramWorker
+{
+  GThread*      thread;
+  GMainContext* context;
+  GMainLoop*    loop;
+  SoupSession*  session;
+
+  /* Connections currently assigned to this worker. */
+  atomic_uint n_streams;
+
+  /* Not part of the pool; freed by its own thread once the loop quits. */
+  gboolean dedicated;
+};
+
+static DeepgramWorker* deepgram_pool_workers   = NULL;
+static guint           deepgram_pool_n_workers = 0;
+
+static SoupSession*
+deepgram_pool_new_session (void)
+{
+  return soup_session_new_with_options (
+      "max-conns", DEEPGRAM_POOL_MAX_CONNS, "max-conns-per-host",
+      DEEPGRAM_POOL_MAX_CONNS_PER_HOST, NULL);
+}
+
+static gpointer
+deepgram_worker_thread_func (gpointer user_data)
+{
+  DeepgramWorker* worker = (DeepgramWorker*)user_data;
+
+  g_main_context_push_thread_default (worker->context);
+  g_main_loop_run (worker->loop);
+
+  /* Let completions that are already due (e.g. of operations cancelled
+   * by the teardown) run and drop their references before the context
+   * goes away. */
+  if (worker->dedicated)
+    while (g_main_context_iteration (worker->context, FALSE))
+      ;
+  g_main_context_pop_thread_default (worker->context);
+
+  if (worker->dedicated)
+    {
+      g_object_unref (worker->session);
+      g_main_loop_unref (worker->loop);
+      g_main_context_unref (worker->context);
+      g_free (worker);
+    }
+
+  return NULL;
+}
+
+static guint
+deepgram_pool_default_size (void)
+{
+  const gchar* env = g_getenv (DEEPGRAM_POOL_WORKERS_ENV);
+
+  if (env && *env)
+    {
+      guint64 n = g_ascii_strtoull (env, NULL, 10);
+      if (n > 0)
+        return (guint)MIN (n, DEEPGRAM_POOL_MAX_WORKERS);
+
+      g_printerr ("[DeepgramPool] Ignoring invalid %s=%s\n",
+                  DEEPGRAM_POOL_WORKERS_ENV, env);
+    }
+
+  return MAX (g_get_num_processors (), 1);
+}
+
+static void
+deepgram_worker_start (DeepgramWorker* worker, const gchar* name,
+                       SoupSession* shared)
+{
+  worker->context = g_main_context_new ();
+  worker->loop    = g_main_loop_new (worker->context, FALSE);
+  atomic_init (&worker->n_streams, 0);
+
+  if (shared)
+    {
+      worker->session = g_object_ref (shared);
+    }
+  else
+    {
+      /* Older libsoup binds a session to the thread-default context it was
+       * created in. */
+      g_main_context_push_thread_default (worker->context);
+      worker->session = deepgram_pool_new_session ();
+      g_main_context_pop_thread_default (worker->context);
+    }
+
+  worker->thread = g_thread_new (name, deepgram_worker_thread_func, worker);
+}
+
+static void
+deepgram_pool_init (void)
+{
+  guint        n_workers = deepgram_pool_default_size ();
+  SoupSession* shared    = NULL;
+
+#if SOUP_CHECK_VERSION(3, 2, 0)
+  /* Since libsoup 3.2 a session may be used from several threads, each
+   * operation running in the caller's thread-default context; one session
+   * then gives all workers one connection and TLS session cache. */
+  shared = deepgram_pool_new_session ();
+#endif
+
+  deepgram_pool_workers   = g_new0 (DeepgramWorker, n_workers);
+  deepgram_pool_n_workers = n_workers;
+
+  for (guint i = 0; i < n_workers; i++)
+    {
+      gchar* name = g_strdup_printf ("deepgram-ws-%u", i);
+      deepgram_worker_start (&deepgram_pool_workers[i], name, shared);
+      g_free (name);
+    }
+
+  g_clear_object (&shared);
+
+  g_print ("[DeepgramPool] Started %u worker thread(s).\n", n_workers);
+}
+
+/* Assigns a new connection to the worker with the fewest connections. */
+DeepgramWorker*
+deepgram_pool_acquire (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      deepgram_pool_init ();
+      g_once_init_leave (&initialized, 1);
+    }
+
+  DeepgramWorker* best = &deepgram_pool_workers[0];
+  for (guint i = 1; i < deepgram_pool_n_workers; i++)
+    {
+      DeepgramWorker* worker = &deepgram_pool_workers[i];
+      if (atomic_load (&worker->n_streams) < atomic_load (&best->n_streams))
+        best = worker;
+    }
+
+  atomic_fetch_add (&best->n_streams, 1);
+  return best;
+}
+
+DeepgramWorker*
+deepgram_pool_acquire_dedicated (void)
+{
+  DeepgramWorker* worker = g_new0 (DeepgramWorker, 1);
+
+  worker->dedicated = TRUE;
+  deepgram_worker_start (worker, "deepgram-ws-dedicated", NULL);
+  atomic_fetch_add (&worker->n_streams, 1);
+
+  return worker;
+}
+
+static gboolean
+deepgram_worker_quit (gpointer user_data)
+{
+  g_main_loop_quit ((GMainLoop*)user_data);
+  return G_SOURCE_REMOVE;
+}
+
+void
+deepgram_pool_release (DeepgramWorker* worker)
+{
+  g_return_if_fail (worker != NULL);
+
+  atomic_fetch_sub (&worker->n_streams, 1);
+  if (!worker->dedicated)
+    return;
+
+  /* Called once the connection's teardown has run, see deepgram_ws_stop();
+   * the thread then frees the worker. */
+  GThread* thread = worker->thread;
+  GSource* quit   = g_idle_source_new ();
+  g_source_set_priority (quit, G_PRIORITY_LOW);
+  g_source_set_callback (quit, deepgram_worker_quit,
+                         g_main_loop_ref (worker->loop),
+                         (GDestroyNotify)g_main_loop_unref);
+  g_source_attach (quit, worker->context);
+  g_source_unref (quit);
+
+  if (g_thread_self () == thread)
+    g_thread_unref (thread);
+  else
+    g_thread_join (thread);
+}
+
+/* 0 until the first deepgram_pool_acquire(). */
+guint
+deepgram_pool_get_size (void)
+{
+  return deepgram_pool_n_workers;
+}
+
+GMainContext*
+deepgram_worker_get_context (DeepgramWorker* worker)
+{
+  return worker->context;
+}
+
+SoupSession*
+deepgram_worker_get_session (DeepgramWorker* worker)
+{
+  return worker->session;
+}
@@ -0,0 +1,32 @@
+#ifndef __DEEPGRAM_POOL_H__
+#define __DEEPGRAM_POOL_H__
+
+#include <glib.h>
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+/* Process-wide set of worker threads shared by every DeepgramWS. Each worker
+ * iterates its own GMainContext (pushed as the thread-default context), so
+ * one worker multiplexes many connections. Workers are started on first use
+ * and live until the process exits. The worker count defaults to the number
+ * of CPUs and can be overridden with DEEPGRAM_WS_WORKERS. */
+typedef struct _DeepgramWorker DeepgramWorker;
+
+DeepgramWorker * deepgram_pool_acquire(void);
+
+/* A worker outside the pool, serving a single connection on a thread and
+ * GMainContext of its own; stopped again by deepgram_pool_release(). */
+DeepgramWorker * deepgram_pool_acquire_dedicated(void);
+
+void deepgram_pool_release(DeepgramWorker *worker);
+
+guint deepgram_pool_get_size(void);
+
+GMainContext * deepgram_worker_get_context(DeepgramWorker *worker);
+
+SoupSession * deepgram_worker_get_session(DeepgramWorker *worker);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_POOL_H__ */
@@ -0,0 +1,814 @@
+#include "deepgramresult.h"
+
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+/* Deeper nesting than this in a skipped value is rejected rather than
+ * recursed into. */
+#define DEEPGRAM_RESULT_MAX_DEPTH 64
+
+/* Longest number literal accepted; Deepgram sends at most ~20 digits. */
+#define DEEPGRAM_RESULT_MAX_NUMBER 64
+
+/* A pull parser over one message that only looks at the members DeepgramWS
+ * needs and skips everything else without building a tree:
+ *
+ *   { "type", "is_final", "start", "duration", "channel_index": [ index ],
+ *     "channel": { "alternatives": [ { "transcript",
+ *       "words": [ { "word", "start", "end", "confidence" } ] } ] } }
+ *
+ * Input need not be NUL-terminated. Decoded strings are appended to
+ * result->strings, NUL-separated, and only turned into pointers once the
+ * parse is done, since the GString may move while it grows. */
+typedef struct
+{
+  const gchar*    p;
+  const gchar*    end;
+  DeepgramResult* result;
+} DeepgramReader;
+
+static gboolean deepgram_reader_skip_value (DeepgramReader* r, guint depth);
+
+static inline void
+deepgram_reader_skip_ws (DeepgramReader* r)
+{
+  while (r->p < r->end
+         && (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r'))
+    r->p++;
+}
+
+static inline gboolean
+deepgram_reader_accept (DeepgramReader* r, gchar c)
+{
+  deepgram_reader_skip_ws (r);
+  if (r->p < r->end && *r->p == c)
+    {
+      r->p++;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+static inline gboolean
+deepgram_reader_peek (DeepgramReader* r, gchar c)
+{
+  deepgram_reader_skip_ws (r);
+  return r->p < r->end && *r->p == c;
+}
+
+/* Scans a string without decoding it. On return *raw and *raw_len span
+ * its contents between the quotes, escapes included. */
+static gboolean
+deepgram_reader_raw_string (DeepgramReader* r, const gchar** raw,
+                            gsize* raw_len)
+{
+  if (!deepgram_reader_accept (r, '"'))
+    return FALSE;
+
+  const gchar* start = r->p;
+  while (r->p < r->end && *r->p != '"')
+    {
+      if (*r->p == '\\' && ++r->p == r->end)
+        return FALSE;
+      r->p++;
+    }
+  if (r->p >= r->end)
+    return FALSE;
+
+  *raw     = start;
+  *raw_len = r->p - start;
+  r->p++;
+  return TRUE;
+}
+
+static gboolean
+deepgram_reader_hex4 (const gchar* p, const gchar* end, gunichar* out)
+{
+  if (end - p < 4)
+    return FALSE;
+
+  gunichar value = 0;
+  for (guint i = 0; i < 4; i++)
+    {
+      gint digit = g_ascii_xdigit_value (p[i]);
+      if (digit < 0)
+        return FALSE;
+      value = (value << 4) | digit;
+    }
+
+  *out = value;
+  return TRUE;
+}
+
+/* Decodes a string into result->strings and returns its offset there, or -1
+ * if the string is malformed. */
+static gssize
+deepgram_reader_string (DeepgramReader* r)
+{
+  const gchar* raw;
+  gsize        raw_len;
+
+  if (!deepgram_reader_raw_string (r, &raw, &raw_len))
+    return -1;
+
+  GString*     strings = r->result->strings;
+  gssize       offset  = strings->len;
+  const gchar* p       = raw;
+  const gchar* end     = raw + raw_len;
+
+  while (p < end)
+    {
+      const gchar* run = p;
+      while (p < end && *p != '\\')
+        p++;
+      g_string_append_len (strings, run, p - run);
+      if (p >= end)
+        break;
+
+      /* The scan above guarantees a character after the backslash. */
+      p++;
+      switch (*p++)
+        {
+        case '"':
+          g_string_append_c (strings, '"');
+          break;
+        case '\\':
+          g_string_append_c (strings, '\\');
+          break;
+        case '/':
+          g_string_append_c (strings, '/');
+          break;
+        case 'b':
+          g_string_append_c (strings, '\b');
+          break;
+        case 'f':
+          g_string_append_c (strings, '\f');
+          break;
+        case 'n':
+          g_string_append_c (strings, '\n');
+          break;
+        case 'r':
+          g_string_append_c (strings, '\r');
+          break;
+        case 't':
+          g_string_append_c (strings, '\t');
+          break;
+        case 'u':
+          {
+            gunichar c;
+            if (!deepgram_reader_hex4 (p, end, &c))
+              return -1;
+            p += 4;
+
+            if (c >= 0xd800 && c <= 0xdbff)
+              {
+                gunichar low;
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u'
+                    || !deepgram_reader_hex4 (p + 2, end, &low)
+                    || low < 0xdc00 || low > 0xdfff)
+                  return -1;
+                p += 6;
+                c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+              }
+            else if (c >= 0xdc00 && c <= 0xdfff)
+              {
+                return -1;
+              }
+
+            g_string_append_unichar (strings, c);
+            break;
+          }
+        default:
+          return -1;
+        }
+    }
+
+  g_string_append_c (strings, '\0');
+  return offset;
+}
+
+static gboolean
+deepgram_reader_number (DeepgramReader* r, gdouble* out)
+{
+  gchar buf[DEEPGRAM_RESULT_MAX_NUMBER];
+  gsize len = 0;
+
+  deepgram_reader_skip_ws (r);
+  while (r->p < r->end
+         && (g_ascii_isdigit (*r->p) || *r->p == '-' || *r->p == '+'
+             || *r->p == '.' || *r->p == 'e' || *r->p == 'E'))
+    {
+      if (len == sizeof (buf) - 1)
+        return FALSE;
+      buf[len++] = *r->p++;
+    }
+  if (len == 0)
+    return FALSE;
+  buf[len] = '\0';
+
+  gchar* endptr = NULL;
+  *out          = g_ascii_strtod (buf, &endptr);
+  return endptr == buf + len;
+}
+
+static gboolean
+deepgram_reader_literal (DeepgramReader* r, const gchar* literal)
+{
+  gsize len = strlen (literal);
+
+  deepgram_reader_skip_ws (r);
+  if ((gsize)(r->end - r->p) < len || memcmp (r->p, literal, len) != 0)
+    return FALSE;
+
+  r->p += len;
+  return TRUE;
+}
+
+static gboolean
+deepgram_reader_boolean (DeepgramReader* r, gboolean* out)
+{
+  if (deepgram_reader_literal (r, "true"))
+    *out = TRUE;
+  else if (deepgram_reader_literal (r, "false"))
+    *out = FALSE;
+  else
+    return FALSE;
+  return TRUE;
+}
+
+/* Iterates the members of an object whose '{' has been consumed: returns
+ * TRUE with the key in *key and *key_len and the ':' consumed, or FALSE once
+ * the object has ended (*ok tells whether it ended well). */
+static gboolean
+deepgram_reader_next_member (DeepgramReader* r, gboolean* first,
+                             const gchar** key, gsize* key_len, gboolean* ok)
+{
+  *ok = TRUE;
+  if (deepgram_reader_accept (r, '}'))
+    return FALSE;
+
+  if (!*first && !deepgram_reader_accept (r, ','))
+    {
+      *ok = FALSE;
+      return FALSE;
+    }
+  *first = FALSE;
+
+  if (!deepgram_reader_raw_string (r, key, key_len)
+      || !deepgram_reader_accept (r, ':'))
+    {
+      *ok = FALSE;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* Same for the elements of an array whose '[' has been consumed. */
+static gboolean
+deepgram_reader_next_element (DeepgramReader* r, gboolean* first,
+                              gboolean* ok)
+{
+  *ok = TRUE;
+  if (deepgram_reader_accept (r, ']'))
+    return FALSE;
+
+  if (!*first && !deepgram_reader_accept (r, ','))
+    {
+      *ok = FALSE;
+      return FALSE;
+    }
+  *first = FALSE;
+  return TRUE;
+}
+
+#define DEEPGRAM_KEY_IS(key, key_len, name)                                   \
+  ((key_len) == sizeof (name) - 1 && memcmp ((key), (name), (key_len)) == 0)
+
+static gboolean
+deepgram_reader_skip_value (DeepgramReader* r, guint depth)
+{
+  const gchar* key;
+  gsize        key_len;
+  gboolean     first = TRUE;
+  gboolean     ok;
+
+  if (depth > DEEPGRAM_RESULT_MAX_DEPTH)
+    return FALSE;
+
+  deepgram_reader_skip_ws (r);
+  if (r->p >= r->end)
+    return FALSE;
+
+  switch (*r->p)
+    {
+    case '"':
+      return deepgram_reader_raw_string (r, &key, &key_len);
+    case '{':
+      r->p++;
+      while (deepgram_reader_next_member (r, &first, &key, &key_len, &ok))
+        if (!deepgram_reader_skip_value (r, depth + 1))
+          return FALSE;
+      return ok;
+    case '[':
+      r->p++;
+      while (deepgram_reader_next_element (r, &first, &ok))
+        if (!deepgram_reader_skip_value (r, depth + 1))
+          return FALSE;
+      return ok;
+    case 't':
+      return deepgram_reader_literal (r, "true");
+    case 'f':
+      return deepgram_reader_literal (r, "false");
+    case 'n':
+      return deepgram_reader_literal (r, "null");
+    default:
+      {
+        gdouble unused;
+        return deepgram_reader_number (r, &unused);
+      }
+    }
+}
+
+static gboolean
+deepgram_reader_word (DeepgramReader* r)
+{
+  const gchar* key;
+  gsize        key_len;
+  gboolean     first = TRUE;
+  gboolean     ok;
+  DeepgramWord word        = { NULL, 0.0, 0.0, 0.0 };
+  gssize       text_offset = -1;
+
+  if (!deepgram_reader_accept (r, '{'))
+    return FALSE;
+
+  while (deepgram_reader_next_member (r, &first, &key, &key_len, &ok))
+    {
+      if (DEEPGRAM_KEY_IS (key, key_len, "word"))
+        ok = (text_offset = deepgram_reader_string (r)) >= 0;
+      else if (DEEPGRAM_KEY_IS (key, key_len, "start"))
+        ok = deepgram_reader_number (r, &word.start);
+      else if (DEEPGRAM_KEY_IS (key, key_len, "end"))
+        ok = deepgram_reader_number (r, &word.end);
+      else if (DEEPGRAM_KEY_IS (key, key_len, "confidence"))
+        ok = deepgram_reader_number (r, &word.confidence);
+      else
+        ok = deepgram_reader_skip_value (r, 0);
+
+      if (!ok)
+        return FALSE;
+    }
+  if (!ok)
+    return FALSE;
+
+  g_array_append_val (r->result->words, word);
+  g_array_append_val (r->result->word_offsets, text_offset);
+  return TRUE;
+}
+
+static gboolean
+deepgram_reader_alternative (DeepgramReader* r)
+{
+  const gchar* key;
+  gsize        key_len;
+  gboolean     first = TRUE;
+  gboolean     ok;
+
+  if (!deepgram_reader_accept (r, '{'))
+    return FALSE;
+
+  while (deepgram_reader_next_member (r, &first, &key, &key_len, &ok))
+    {
+      if (DEEPGRAM_KEY_IS (key, key_len, "transcript"))
+        {
+          r->result->transcript_offset = deepgram_reader_string (r);
+          ok = r->result->transcript_offset >= 0;
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "words"))
+        {
+          gboolean first_word = TRUE;
+
+          if (!deepgram_reader_accept (r, '['))
+            return FALSE;
+          while (deepgram_reader_next_element (r, &first_word, &ok))
+            if (!deepgram_reader_word (r))
+              return FALSE;
+        }
+      else
+        {
+          ok = deepgram_reader_skip_value (r, 0);
+        }
+
+      if (!ok)
+        return FALSE;
+    }
+
+  return ok;
+}
+
+static gboolean
+deepgram_reader_channel (DeepgramReader* r)
+{
+  const gchar* key;
+  gsize        key_len;
+  gboolean     first = TRUE;
+  gboolean     ok;
+
+  if (!deepgram_reader_accept (r, '{'))
+    return FALSE;
+
+  while (deepgram_reader_next_member (r, &first, &key, &key_len, &ok))
+    {
+      if (DEEPGRAM_KEY_IS (key, key_len, "alternatives"))
+        {
+          gboolean first_alt = TRUE;
+          gboolean seen      = FALSE;
+
+          if (!deepgram_reader_accept (r, '['))
+            return FALSE;
+          while (deepgram_reader_next_element (r, &first_alt, &ok))
+            {
+              ok = seen ? deepgram_reader_skip_value (r, 0)
+                        : deepgram_reader_alternative (r);
+              if (!ok)
+                return FALSE;
+              seen = TRUE;
+            }
+        }
+      else
+        {
+          ok = deepgram_reader_skip_value (r, 0);
+        }
+
+      if (!ok)
+        return FALSE;
+    }
+
+  return ok;
+}
+
+/* The [index, count] pair of a multichannel result; only index is kept. */
+static gboolean
+deepgram_reader_channel_index (DeepgramReader* r, guint* index)
+{
+  gboolean first = TRUE;
+  gboolean ok;
+
+  if (!deepgram_reader_accept (r, '['))
+    return FALSE;
+
+  while (deepgram_reader_next_element (r, &first, &ok))
+    {
+      gdouble value;
+
+      if (!deepgram_reader_number (r, &value))
+        return FALSE;
+      if (index && value >= 0 && value <= G_MAXUINT)
+        *index = (guint)value;
+      index = NULL;
+    }
+
+  return ok;
+}
+
+static void
+deepgram_result_reset (DeepgramResult* result)
+{
+  result->type              = DEEPGRAM_RESULT_OTHER;
+  result->is_final          = FALSE;
+  result->has_range         = FALSE;
+  result->start             = 0.0;
+  result->duration          = 0.0;
+  result->channel           = 0;
+  result->transcript        = NULL;
+  result->transcript_offset = -1;
+  g_array_set_size (result->words, 0);
+  g_array_set_size (result->word_offsets, 0);
+  g_string_truncate (result->strings, 0);
+}
+
+/* Turns string offsets into pointers once result->strings has stopped
+ * growing. */
+static void
+deepgram_result_resolve (DeepgramResult* result)
+{
+  if (result->transcript_offset >= 0)
+    result->transcript = result->strings->str + result->transcript_offset;
+
+  for (guint i = 0; i < result->words->len; i++)
+    {
+      gssize offset = g_array_index (result->word_offsets, gssize, i);
+      g_array_index (result->words, DeepgramWord, i).text
+          = offset >= 0 ? result->strings->str + offset : NULL;
+    }
+}
+
+DeepgramResult*
+deepgram_result_new (void)
+{
+  DeepgramResult* result = g_new0 (DeepgramResult, 1);
+
+  result->words        = g_array_new (FALSE, FALSE, sizeof (DeepgramWord));
+  result->word_offsets = g_array_new (FALSE, FALSE, sizeof (gssize));
+  result->strings      = g_string_sized_new (256);
+  deepgram_result_reset (result);
+
+  return result;
+}
+
+void
+deepgram_result_free (DeepgramResult* result)
+{
+  if (!result)
+    return;
+
+  g_array_unref (result->words);
+  g_array_unref (result->word_offsets);
+  g_string_free (result->strings, TRUE);
+  g_free (result);
+}
+
+/* Returns FALSE if data is not a well-formed JSON object, in which case the
+ * result's contents are undefined. Values of unexpected types in the members
+ * above are treated as malformed too, so the caller can fall back to
+ * deepgram_result_parse_json_glib() for anything unusual. */
+gboolean
+deepgram_result_parse (DeepgramResult* result, const gchar* data, gsize size)
+{
+  DeepgramReader r = { data, data + size, result };
+  const gchar*   key;
+  gsize          key_len;
+  gboolean       first = TRUE;
+  gboolean       ok;
+  gboolean       has_start    = FALSE;
+  gboolean       has_duration = FALSE;
+
+  g_return_val_if_fail (result != NULL, FALSE);
+
+  deepgram_result_reset (result);
+
+  if (!data || !deepgram_reader_accept (&r, '{'))
+    return FALSE;
+
+  while (deepgram_reader_next_member (&r, &first, &key, &key_len, &ok))
+    {
+      if (DEEPGRAM_KEY_IS (key, key_len, "type"))
+        {
+          const gchar* type;
+          gsize        type_len;
+
+          ok = deepgram_reader_raw_string (&r, &type, &type_len);
+          if (ok && DEEPGRAM_KEY_IS (type, type_len, "Results"))
+            result->type = DEEPGRAM_RESULT_RESULTS;
+          else if (ok && DEEPGRAM_KEY_IS (type, type_len, "Metadata"))
+            result->type = DEEPGRAM_RESULT_METADATA;
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "is_final"))
+        {
+          ok = deepgram_reader_boolean (&r, &result->is_final);
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "start"))
+        {
+          ok = has_start = deepgram_reader_number (&r, &result->start);
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "duration"))
+        {
+          ok = has_duration = deepgram_reader_number (&r, &result->duration);
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "channel_index"))
+        {
+          ok = deepgram_reader_channel_index (&r, &result->channel);
+        }
+      else if (DEEPGRAM_KEY_IS (key, key_len, "channel")
+               && deepgram_reader_peek (&r, '{'))
+        {
+          /* "channel" is also the [index, count] array of multichannel
+           * Metadata; only the object form is parsed. */
+          ok = deepgram_reader_channel (&r);
+        }
+      else
+        {
+          ok = deepgram_reader_skip_value (&r, 0);
+        }
+
+      if (!ok)
+        return FALSE;
+    }
+  if (!ok)
+    return FALSE;
+
+  /* Nothing but whitespace may follow. */
+  deepgram_reader_skip_ws (&r);
+  if (r.p != r.end)
+    return FALSE;
+
+  result->has_range = has_start && has_duration;
+  deepgram_result_resolve (result);
+  return TRUE;
+}
+
+static gssize
+deepgram_result_add_string (DeepgramResult* result, const gchar* str)
+{
+  gssize offset = result->strings->len;
+
+  g_string_append (result->strings, str);
+  g_string_append_c (result->strings, '\0');
+  return offset;
+}
+
+/* The first alternative's transcript and words of a channel object, with
+ * json-glib. */
+static void
+deepgram_result_read_channel (DeepgramResult* result, JsonObject* channel_obj)
+{
+  JsonArray* alt_arr = NULL;
+
+  if (json_object_has_member (channel_obj, "alternatives"))
+    alt_arr = json_object_get_array_member (channel_obj, "alternatives");
+
+  JsonObject* first_alt = NULL;
+  if (alt_arr && json_array_get_length (alt_arr) > 0)
+    first_alt = json_array_get_object_element (alt_arr, 0);
+
+  if (first_alt && json_object_has_member (first_alt, "transcript"))
+    {
+      const gchar* transcript
+          = json_object_get_string_member (first_alt, "transcript");
+      if (transcript)
+        result->transcript_offset
+            = deepgram_result_add_string (result, transcript);
+    }
+
+  JsonArray* words_arr = NULL;
+  if (first_alt && json_object_has_member (first_alt, "words"))
+    words_arr = json_object_get_array_member (first_alt, "words");
+
+  for (guint i = 0; words_arr && i < json_array_get_length (words_arr); i++)
+    {
+      JsonObject* word_obj = json_array_get_object_element (words_arr, i);
+      if (!word_obj)
+        continue;
+
+      DeepgramWord word        = { NULL, 0.0, 0.0, 0.0 };
+      gssize       text_offset = -1;
+
+      if (json_object_has_member (word_obj, "word"))
+        {
+          const gchar* text = json_object_get_string_member (word_obj, "word");
+          if (text)
+            text_offset = deepgram_result_add_string (result, text);
+        }
+      if (json_object_has_member (word_obj, "start"))
+        word.start = json_object_get_double_member (word_obj, "start");
+      if (json_object_has_member (word_obj, "end"))
+        word.end = json_object_get_double_member (word_obj, "end");
+      if (json_object_has_member (word_obj, "confidence"))
+        word.confidence
+            = json_object_get_double_member (word_obj, "confidence");
+
+      g_array_append_val (result->words, word);
+      g_array_append_val (result->word_offsets, text_offset);
+    }
+}
+
+/* The reference implementation on top of json-glib: slower, but lenient
+ * about value types in the same way the original message handler was. */
+gboolean
+deepgram_result_parse_json_glib (DeepgramResult* result, const gchar* data,
+                                 gsize size, GError** error)
+{
+  g_return_val_if_fail (result != NULL, FALSE);
+
+  deepgram_result_reset (result);
+
+  JsonParser* parser = json_parser_new ();
+  if (!json_parser_load_from_data (parser, data, size, error))
+    {
+      g_object_unref (parser);
+      return FALSE;
+    }
+
+  JsonNode* root = json_parser_get_root (parser);
+  if (!root || !JSON_NODE_HOLDS_OBJECT (root))
+    {
+      g_set_error_literal (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE,
+                           "Message is not a JSON object");
+      g_object_unref (parser);
+      return FALSE;
+    }
+
+  JsonObject*  root_obj = json_node_get_object (root);
+  const gchar* type     = NULL;
+
+  if (json_object_has_member (root_obj, "type"))
+    type = json_object_get_string_member (root_obj, "type");
+
+  if (g_strcmp0 (type, "Results") == 0)
+    result->type = DEEPGRAM_RESULT_RESULTS;
+  else if (g_strcmp0 (type, "Metadata") == 0)
+    result->type = DEEPGRAM_RESULT_METADATA;
+
+  if (json_object_has_member (root_obj, "is_final"))
+    result->is_final = json_object_get_boolean_member (root_obj, "is_final");
+
+  if (json_object_has_member (root_obj, "start")
+      && json_object_has_member (root_obj, "duration"))
+    {
+      result->has_range = TRUE;
+      result->start     = json_object_get_double_member (root_obj, "start");
+      result->duration  = json_object_get_double_member (root_obj, "duration");
+    }
+
+  JsonNode* index_node = json_object_get_member (root_obj, "channel_index");
+  if (index_node && JSON_NODE_HOLDS_ARRAY (index_node))
+    {
+      JsonArray* index_arr = json_node_get_array (index_node);
+      if (json_array_get_length (index_arr) > 0)
+        result->channel = json_array_get_int_element (index_arr, 0);
+    }
+
+  JsonNode* channel_node = json_object_get_member (root_obj, "channel");
+  if (channel_node && JSON_NODE_HOLDS_OBJECT (channel_node))
+    deepgram_result_read_channel (result, json_node_get_object (channel_node));
+
+  g_object_unref (parser);
+
+  deepgram_result_resolve (result);
+  return TRUE;
+}
+
+/* One channel of a response of the prerecorded (REST) API, as a final
+ * Results message covering the whole upload; word times count from the
+ * start of the audio uploaded:
+ *
+ *   { "metadata": { "duration" }, "results": { "channels": [
+ *       { "alternatives": [ { "transcript", "words": [ ... ] } ] } ] } }
+ *
+ * *n_channels is set to the number of channels in the response. This runs
+ * once per upload and channel rather than per streaming message, so it
+ * uses json-glib. */
+gboolean
+deepgram_result_parse_prerecorded (DeepgramResult* result, const gchar* data,
+                                   gsize size, guint channel,
+                                   guint* n_channels, GError** error)
+{
+  g_return_val_if_fail (result != NULL, FALSE);
+
+  deepgram_result_reset (result);
+  *n_channels = 0;
+
+  JsonParser* parser = json_parser_new ();
+  if (!json_parser_load_from_data (parser, data, size, error))
+    {
+      g_object_unref (parser);
+      return FALSE;
+    }
+
+  JsonNode*   root     = json_parser_get_root (parser);
+  JsonObject* root_obj = root && JSON_NODE_HOLDS_OBJECT (root)
+                             ? json_node_get_object (root)
+                             : NULL;
+  JsonNode*   results
+      = root_obj ? json_object_get_member (root_obj, "results") : NULL;
+  JsonNode*   channels
+      = results && JSON_NODE_HOLDS_OBJECT (results)
+            ? json_object_get_member (json_node_get_object (results),
+                                      "channels")
+            : NULL;
+  if (!channels || !JSON_NODE_HOLDS_ARRAY (channels))
+    {
+      g_set_error_literal (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE,
+                           "Response has no results.channels array");
+      g_object_unref (parser);
+      return FALSE;
+    }
+
+  JsonArray* channel_arr = json_node_get_array (channels);
+  *n_channels            = json_array_get_length (channel_arr);
+
+  JsonNode* metadata = json_object_get_member (root_obj, "metadata");
+  if (metadata && JSON_NODE_HOLDS_OBJECT (metadata)
+      && json_object_has_member (json_node_get_object (metadata), "duration"))
+    {
+      result->has_range = TRUE;
+      result->duration  = json_object_get_double_member (
+          json_node_get_object (metadata), "duration");
+    }
+
+  result->type     = DEEPGRAM_RESULT_RESULTS;
+  result->is_final = TRUE;
+  result->channel  = channel;
+  if (channel < *n_channels)
+    {
+      JsonObject* channel_obj
+          = json_array_get_object_element (channel_arr, channel);
+      if (channel_obj)
+        deepgram_result_read_channel (result, channel_obj);
+    }
+
+  g_object_unref (parser);
+
+  deepgram_result_resolve (result);
+  return TRUE;
+}
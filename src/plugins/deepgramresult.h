@@ -0,0 +1,60 @@
+#ifndef __DEEPGRAM_RESULT_H__
+#define __DEEPGRAM_RESULT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  DEEPGRAM_RESULT_OTHER,
+  DEEPGRAM_RESULT_RESULTS,
+  DEEPGRAM_RESULT_METADATA,
+} DeepgramResultType;
+
+typedef struct {
+  const gchar *text;
+  gdouble      start;
+  gdouble      end;
+  gdouble      confidence;
+} DeepgramWord;
+
+/* The fields of a streaming response that DeepgramWS uses; only the first
+ * alternative is kept. A result is meant to be reused from message to
+ * message: its buffers only grow, so once warmed up parsing allocates
+ * nothing. Strings point into the result and stay valid until the next
+ * parse or deepgram_result_free(). */
+typedef struct {
+  DeepgramResultType type;
+  gboolean           is_final;
+  gboolean           has_range;
+  gdouble            start;
+  gdouble            duration;
+  guint              channel;   /* channel_index with multichannel=true */
+  const gchar       *transcript;
+  GArray            *words;   /* DeepgramWord */
+
+  /*< private >*/
+  GString           *strings;
+  GArray            *word_offsets;
+  gssize             transcript_offset;
+} DeepgramResult;
+
+DeepgramResult * deepgram_result_new(void);
+
+void deepgram_result_free(DeepgramResult *result);
+
+gboolean deepgram_result_parse(DeepgramResult *result, const gchar *data,
+                               gsize size);
+
+gboolean deepgram_result_parse_json_glib(DeepgramResult *result,
+                                         const gchar *data, gsize size,
+                                         GError **error);
+
+gboolean deepgram_result_parse_prerecorded(DeepgramResult *result,
+                                           const gchar *data, gsize size,
+                                           guint channel, guint *n_channels,
+                                           GError **error);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_RESULT_H__ */
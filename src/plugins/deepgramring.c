@@ -0,0 +1,99 @@
+#include "deepgramring.h"
+
+#include <stdatomic.h>
+
+#define DEEPGRAM_RING_CACHE_LINE 64
+
+struct _DeepgramRing
+{
+  guint     mask;
+  gpointer* slots;
+
+  /* The consumer owns head and the producer owns tail; keep them on
+   * different cache lines so the two threads do not false-share. */
+  gchar       pad0[DEEPGRAM_RING_CACHE_LINE];
+  atomic_uint head;
+  gchar       pad1[DEEPGRAM_RING_CACHE_LINE - sizeof (atomic_uint)];
+  atomic_uint tail;
+  gchar       pad2[DEEPGRAM_RING_CACHE_LINE - sizeof (atomic_uint)];
+};
+
+DeepgramRing*
+deepgram_ring_new (guint min_capacity)
+{
+  guint capacity = 1;
+  while (capacity < min_capacity)
+    capacity <<= 1;
+
+  DeepgramRing* ring = g_new0 (DeepgramRing, 1);
+  ring->mask         = capacity - 1;
+  ring->slots        = g_new0 (gpointer, capacity);
+  atomic_init (&ring->head, 0);
+  atomic_init (&ring->tail, 0);
+
+  return ring;
+}
+
+void
+deepgram_ring_free (DeepgramRing* ring, GDestroyNotify free_func)
+{
+  if (!ring)
+    return;
+
+  if (free_func)
+    {
+      gpointer item;
+      while ((item = deepgram_ring_pop (ring)) != NULL)
+        free_func (item);
+    }
+
+  g_free (ring->slots);
+  g_free (ring);
+}
+
+gboolean
+deepgram_ring_push (DeepgramRing* ring, gpointer item)
+{
+  g_return_val_if_fail (item != NULL, FALSE);
+
+  guint tail = atomic_load_explicit (&ring->tail, memory_order_relaxed);
+  guint head = atomic_load_explicit (&ring->head, memory_order_acquire);
+
+  if (tail - head > ring->mask)
+    return FALSE;
+
+  ring->slots[tail & ring->mask] = item;
+  atomic_store_explicit (&ring->tail, tail + 1, memory_order_release);
+
+  return TRUE;
+}
+
+gpointer
+deepgram_ring_pop (DeepgramRing* ring)
+{
+  guint head = atomic_load_explicit (&ring->head, memory_order_relaxed);
+  guint tail = atomic_load_explicit (&ring->tail, memory_order_acquire);
+
+  if (head == tail)
+    return NULL;
+
+  gpointer item = ring->slots[head & ring->mask];
+  atomic_store_explicit (&ring->head, head + 1, memory_order_release);
+
+  return item;
+}
+
+guint
+deepgram_ring_length (DeepgramRing* ring)
+{
+  guint head = atomic_load_explicit (&ring->head, memory_order_acquire);
+  guint tail = atomic_load_explicit (&ring->tail, memory_order_acquire);
+
+  return tail - head;
+}
+
+guint
+deepgram_ring_capacity (DeepgramRing* ring)
+{
+  return ring->mask + 1;
+}
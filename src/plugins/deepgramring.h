@@ -0,0 +1,27 @@
+#ifndef __DEEPGRAM_RING_H__
+#define __DEEPGRAM_RING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Bounded single-producer/single-consumer ring of pointers. push() may only
+ * be called from one thread and pop() from one (other) thread; neither takes
+ * a lock. */
+typedef struct _DeepgramRing DeepgramRing;
+
+DeepgramRing * deepgram_ring_new(guint min_capacity);
+
+void deepgram_ring_free(DeepgramRing *ring, GDestroyNotify free_func);
+
+gboolean deepgram_ring_push(DeepgramRing *ring, gpointer item);
+
+gpointer deepgram_ring_pop(DeepgramRing *ring);
+
+guint deepgram_ring_length(DeepgramRing *ring);
+
+guint deepgram_ring_capacity(DeepgramRing *ring);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_RING_H__ */
@@ -0,0 +1,165 @@
+#include "deepgramsession.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEEPGRAM_SESSION_MAGIC      "DGSESS01"
+#define DEEPGRAM_SESSION_MAGIC_SIZE 8
+#define DEEPGRAM_SESSION_HEADER     16
+
+/* Buffered, so recording costs the worker a memcpy per message. */
+#define DEEPGRAM_SESSION_BUFFER (64 * 1024)
+
+struct _DeepgramSessionLog
+{
+  FILE*    file;
+  gchar*   path;
+  gboolean with_audio;
+  gint64   start;
+};
+
+struct _DeepgramSessionReader
+{
+  GMappedFile*  file;
+  const guint8* data;
+  gsize         size;
+  gsize         pos;
+};
+
+DeepgramSessionLog*
+deepgram_session_log_new (const gchar* path, gboolean with_audio)
+{
+  FILE* file = g_fopen (path, "wb");
+  if (!file)
+    {
+      g_printerr ("[DeepgramSession] Cannot open %s: %s\n", path,
+                  g_strerror (errno));
+      return NULL;
+    }
+
+  setvbuf (file, NULL, _IOFBF, DEEPGRAM_SESSION_BUFFER);
+  fwrite (DEEPGRAM_SESSION_MAGIC, 1, DEEPGRAM_SESSION_MAGIC_SIZE, file);
+
+  DeepgramSessionLog* log = g_new0 (DeepgramSessionLog, 1);
+  log->file               = file;
+  log->path               = g_strdup (path);
+  log->with_audio         = with_audio;
+  log->start              = g_get_monotonic_time ();
+
+  return log;
+}
+
+void
+deepgram_session_log_free (DeepgramSessionLog* log)
+{
+  if (!log)
+    return;
+
+  if (log->file && fclose (log->file) != 0)
+    g_printerr ("[DeepgramSession] Failed to write %s: %s\n", log->path,
+                g_strerror (errno));
+  g_free (log->path);
+  g_free (log);
+}
+
+void
+deepgram_session_log_write (DeepgramSessionLog* log,
+                            DeepgramSessionEvent event, gconstpointer data,
+                            gsize size)
+{
+  if (!log->file)
+    return;
+
+  gboolean with_payload
+      = data && (event != DEEPGRAM_SESSION_SENT_AUDIO || log->with_audio);
+  guint64 time = (guint64)(g_get_monotonic_time () - log->start) * 1000;
+  guint8  header[DEEPGRAM_SESSION_HEADER] = { 0 };
+
+  guint64 time_le = GUINT64_TO_LE (time);
+  guint32 size_le = GUINT32_TO_LE ((guint32)MIN (size, G_MAXUINT32));
+  memcpy (header, &time_le, 8);
+  memcpy (header + 8, &size_le, 4);
+  header[12] = event;
+  header[13] = with_payload ? DEEPGRAM_SESSION_HAS_PAYLOAD : 0;
+
+  if (fwrite (header, 1, sizeof (header), log->file) != sizeof (header)
+      || (with_payload && fwrite (data, 1, size, log->file) != size))
+    {
+      /* Stop rather than leave a log that cannot be read past this. */
+      g_printerr ("[DeepgramSession] Failed to write %s: %s\n", log->path,
+                  g_strerror (errno));
+      fclose (log->file);
+      log->file = NULL;
+    }
+}
+
+DeepgramSessionReader*
+deepgram_session_reader_new (const gchar* path, GError** error)
+{
+  GMappedFile* file = g_mapped_file_new (path, FALSE, error);
+  if (!file)
+    return NULL;
+
+  const guint8* data = (const guint8*)g_mapped_file_get_contents (file);
+  gsize         size = g_mapped_file_get_length (file);
+  if (size < DEEPGRAM_SESSION_MAGIC_SIZE
+      || memcmp (data, DEEPGRAM_SESSION_MAGIC, DEEPGRAM_SESSION_MAGIC_SIZE)
+             != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s is not a session log", path);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  DeepgramSessionReader* reader = g_new0 (DeepgramSessionReader, 1);
+  reader->file                  = file;
+  reader->data                  = data;
+  reader->size                  = size;
+  reader->pos                   = DEEPGRAM_SESSION_MAGIC_SIZE;
+
+  return reader;
+}
+
+void
+deepgram_session_reader_free (DeepgramSessionReader* reader)
+{
+  if (!reader)
+    return;
+
+  g_mapped_file_unref (reader->file);
+  g_free (reader);
+}
+
+/* FALSE at the end of the log, including a record cut short because the
+ * recording process died while writing it. */
+gboolean
+deepgram_session_reader_next (DeepgramSessionReader* reader,
+                              DeepgramSessionRecord* record)
+{
+  if (reader->size - reader->pos < DEEPGRAM_SESSION_HEADER)
+    return FALSE;
+
+  const guint8* header = reader->data + reader->pos;
+  guint64       time_le;
+  guint32       size_le;
+  memcpy (&time_le, header, 8);
+  memcpy (&size_le, header + 8, 4);
+
+  gsize    size        = GUINT32_FROM_LE (size_le);
+  gboolean has_payload = header[13] & DEEPGRAM_SESSION_HAS_PAYLOAD;
+  gsize    stored      = has_payload ? size : 0;
+  if (reader->size - reader->pos - DEEPGRAM_SESSION_HEADER < stored)
+    return FALSE;
+
+  record->event = header[12];
+  record->time  = GUINT64_FROM_LE (time_le);
+  record->size  = size;
+  record->data  = has_payload ? header + DEEPGRAM_SESSION_HEADER : NULL;
+
+  reader->pos += DEEPGRAM_SESSION_HEADER + stored;
+
+  return TRUE;
+}
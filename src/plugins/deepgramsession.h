@@ -0,0 +1,64 @@
+#ifndef __DEEPGRAM_SESSION_H__
+#define __DEEPGRAM_SESSION_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Binary log of a streaming session, for replaying it offline (see the
+ * mock server's --session and session_bench). After an 8 byte magic,
+ * every event is a little-endian record header followed by its payload:
+ *
+ *   guint64 time    ns since the log was opened
+ *   guint32 size    payload size, even when the payload is not stored
+ *   guint8  event   DeepgramSessionEvent
+ *   guint8  flags   DEEPGRAM_SESSION_HAS_PAYLOAD
+ *   guint16 unused
+ *
+ * CONNECTED carries the URL of the connection that was opened. Audio
+ * payloads are only stored when asked for; text always is. */
+typedef enum
+{
+  DEEPGRAM_SESSION_CONNECTED,
+  DEEPGRAM_SESSION_SENT_AUDIO,
+  DEEPGRAM_SESSION_SENT_TEXT,
+  DEEPGRAM_SESSION_RECEIVED,
+} DeepgramSessionEvent;
+
+#define DEEPGRAM_SESSION_HAS_PAYLOAD 0x01
+
+typedef struct
+{
+  DeepgramSessionEvent event;
+  guint64              time;
+  gsize                size;
+  const guint8        *data;
+} DeepgramSessionRecord;
+
+/* Writer, used from one thread at a time. */
+typedef struct _DeepgramSessionLog DeepgramSessionLog;
+
+DeepgramSessionLog * deepgram_session_log_new(const gchar *path,
+                                              gboolean with_audio);
+
+void deepgram_session_log_free(DeepgramSessionLog *log);
+
+void deepgram_session_log_write(DeepgramSessionLog *log,
+                                DeepgramSessionEvent event,
+                                gconstpointer data, gsize size);
+
+/* Reader; record data (NULL if not stored) points into the mapped file and
+ * stays valid until the reader is freed. */
+typedef struct _DeepgramSessionReader DeepgramSessionReader;
+
+DeepgramSessionReader * deepgram_session_reader_new(const gchar *path,
+                                                    GError **error);
+
+void deepgram_session_reader_free(DeepgramSessionReader *reader);
+
+gboolean deepgram_session_reader_next(DeepgramSessionReader *reader,
+                                      DeepgramSessionRecord *record);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_SESSION_H__ */
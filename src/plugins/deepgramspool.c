@@ -0,0 +1,274 @@
+#include "deepgramspool.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Mapped at a time by the consumer, unless a single chunk is larger. */
+#define DEEPGRAM_SPOOL_WINDOW (4 << 20)
+
+/* Each record is a native-endian guint32 payload size and the payload. */
+typedef guint32 DeepgramSpoolHeader;
+
+struct _DeepgramSpool
+{
+  gint  fd;
+  gsize page_size;
+
+  /* write_end is where the next record goes and read_next the oldest one
+   * not popped yet, as file offsets; records and pending count what lies
+   * in between. The popped chunk, while out, still points into the file,
+   * so the file is only rewound once it is released. All guarded by
+   * lock; the file itself is only written past write_end. */
+  GMutex   lock;
+  guint64  write_end;
+  guint64  read_next;
+  guint64  records;
+  guint64  pending;
+  gboolean out;
+
+  /* Records up to lost_end that could not be read back; they are popped
+   * as empty chunks. */
+  guint64 lost;
+  guint64 lost_end;
+
+  /* Consumer only: the part of the file that is mapped. */
+  guint8* map;
+  guint64 map_offset;
+  gsize   map_size;
+};
+
+DeepgramSpool*
+deepgram_spool_new (const gchar* dir)
+{
+  gchar* path = g_build_filename (dir, "deepgram-XXXXXX.spool", NULL);
+  gint   fd   = g_mkstemp (path);
+  if (fd < 0)
+    {
+      g_printerr ("[DeepgramSpool] Cannot create a spool file in %s: %s\n",
+                  dir, g_strerror (errno));
+      g_free (path);
+      return NULL;
+    }
+
+  /* Only reachable through fd from now on. */
+  g_unlink (path);
+  g_free (path);
+
+  DeepgramSpool* spool = g_new0 (DeepgramSpool, 1);
+  spool->fd            = fd;
+  spool->page_size     = (gsize)sysconf (_SC_PAGESIZE);
+  g_mutex_init (&spool->lock);
+
+  return spool;
+}
+
+void
+deepgram_spool_free (DeepgramSpool* spool)
+{
+  if (!spool)
+    return;
+
+  if (spool->map)
+    munmap (spool->map, spool->map_size);
+  close (spool->fd);
+  g_mutex_clear (&spool->lock);
+  g_free (spool);
+}
+
+static gboolean
+deepgram_spool_write (gint fd, const void* data, gsize size, guint64 offset)
+{
+  const guint8* p = data;
+
+  while (size > 0)
+    {
+      ssize_t n = pwrite (fd, p, size, (off_t)offset);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          g_printerr ("[DeepgramSpool] Write failed: %s\n",
+                      g_strerror (errno));
+          return FALSE;
+        }
+
+      p += n;
+      size -= n;
+      offset += n;
+    }
+
+  return TRUE;
+}
+
+/* Producer side. Returns FALSE if the chunk could not be written, e.g.
+ * because the disk is full; the spool is unchanged then. */
+gboolean
+deepgram_spool_append (DeepgramSpool* spool, const guint8* data, gsize size)
+{
+  g_return_val_if_fail (size <= G_MAXUINT32, FALSE);
+
+  g_mutex_lock (&spool->lock);
+  if (spool->records == 0 && !spool->out && spool->write_end > 0)
+    {
+      /* Everything spooled has been sent: start over, so the file only
+       * grows as long as the outage lasts. */
+      if (ftruncate (spool->fd, 0) == 0)
+        {
+          spool->write_end = 0;
+          spool->read_next = 0;
+        }
+    }
+  guint64 offset = spool->write_end;
+  g_mutex_unlock (&spool->lock);
+
+  DeepgramSpoolHeader header = (DeepgramSpoolHeader)size;
+  if (!deepgram_spool_write (spool->fd, &header, sizeof (header), offset)
+      || !deepgram_spool_write (spool->fd, data, size,
+                                offset + sizeof (header)))
+    return FALSE;
+
+  g_mutex_lock (&spool->lock);
+  spool->write_end = offset + sizeof (header) + size;
+  spool->records++;
+  spool->pending += size;
+  g_mutex_unlock (&spool->lock);
+
+  return TRUE;
+}
+
+/* Makes sure size bytes from offset are mapped, moving the window if not. */
+static gboolean
+deepgram_spool_map (DeepgramSpool* spool, guint64 offset, gsize size)
+{
+  if (spool->map && offset >= spool->map_offset
+      && offset + size <= spool->map_offset + spool->map_size)
+    return TRUE;
+
+  if (spool->map)
+    {
+      munmap (spool->map, spool->map_size);
+      spool->map = NULL;
+    }
+
+  gsize   page  = spool->page_size;
+  guint64 start = offset - offset % page;
+  gsize   len   = MAX (DEEPGRAM_SPOOL_WINDOW, offset - start + size);
+  len           = (len + page - 1) / page * page;
+
+  /* The window may reach past the end of the file; only pages that hold
+   * records are ever touched. */
+  void* map = mmap (NULL, len, PROT_READ, MAP_SHARED, spool->fd, (off_t)start);
+  if (map == MAP_FAILED)
+    {
+      g_printerr ("[DeepgramSpool] mmap failed: %s\n", g_strerror (errno));
+      return FALSE;
+    }
+
+  spool->map        = map;
+  spool->map_offset = start;
+  spool->map_size   = len;
+
+  return TRUE;
+}
+
+static void
+deepgram_spool_release (gpointer user_data)
+{
+  DeepgramSpool* spool = user_data;
+
+  g_mutex_lock (&spool->lock);
+  spool->out = FALSE;
+  g_mutex_unlock (&spool->lock);
+}
+
+/* Consumer side: the oldest chunk, or NULL if there is none. It points into
+ * the mapped file, so at most one may be alive at a time; release it before
+ * popping the next. A record that cannot be mapped comes back empty, so
+ * every appended chunk is popped exactly once. */
+GBytes*
+deepgram_spool_pop (DeepgramSpool* spool)
+{
+  g_mutex_lock (&spool->lock);
+  if (spool->out || spool->records == 0)
+    {
+      g_mutex_unlock (&spool->lock);
+      return NULL;
+    }
+  if (spool->lost > 0)
+    {
+      spool->records--;
+      if (--spool->lost == 0)
+        spool->read_next = spool->lost_end;
+      g_mutex_unlock (&spool->lock);
+      return g_bytes_new (NULL, 0);
+    }
+  guint64 offset = spool->read_next;
+  spool->out     = TRUE;
+  g_mutex_unlock (&spool->lock);
+
+  DeepgramSpoolHeader size;
+  if (!deepgram_spool_map (spool, offset, sizeof (size)))
+    {
+      /* Without the header the records that follow cannot be found
+       * either: give up on all of them. */
+      g_mutex_lock (&spool->lock);
+      g_printerr ("[DeepgramSpool] Lost %" G_GUINT64_FORMAT
+                  " spooled bytes.\n",
+                  spool->pending);
+      spool->lost     = spool->records - 1;
+      spool->lost_end = spool->write_end;
+      spool->records--;
+      spool->pending = 0;
+      spool->out     = FALSE;
+      if (spool->lost == 0)
+        spool->read_next = spool->lost_end;
+      g_mutex_unlock (&spool->lock);
+      return g_bytes_new (NULL, 0);
+    }
+  memcpy (&size, spool->map + (offset - spool->map_offset), sizeof (size));
+
+  gboolean mapped = deepgram_spool_map (spool, offset, sizeof (size) + size);
+
+  g_mutex_lock (&spool->lock);
+  spool->read_next = offset + sizeof (size) + size;
+  spool->records--;
+  spool->pending -= size;
+  if (!mapped)
+    spool->out = FALSE;
+  g_mutex_unlock (&spool->lock);
+
+  if (!mapped)
+    {
+      g_printerr ("[DeepgramSpool] Lost %u spooled bytes.\n", size);
+      return g_bytes_new (NULL, 0);
+    }
+
+  return g_bytes_new_with_free_func (
+      spool->map + (offset + sizeof (size) - spool->map_offset), size,
+      deepgram_spool_release, spool);
+}
+
+/* Whether every chunk appended so far has been popped. */
+gboolean
+deepgram_spool_is_empty (DeepgramSpool* spool)
+{
+  g_mutex_lock (&spool->lock);
+  gboolean empty = spool->records == 0;
+  g_mutex_unlock (&spool->lock);
+
+  return empty;
+}
+
+/* Payload bytes appended and not popped yet. */
+guint64
+deepgram_spool_get_pending (DeepgramSpool* spool)
+{
+  g_mutex_lock (&spool->lock);
+  guint64 pending = spool->pending;
+  g_mutex_unlock (&spool->lock);
+
+  return pending;
+}
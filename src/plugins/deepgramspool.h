@@ -0,0 +1,30 @@
+#ifndef __DEEPGRAM_SPOOL_H__
+#define __DEEPGRAM_SPOOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Append-only on-disk FIFO of audio chunks, for what does not fit in
+ * memory. Like DeepgramRing it has one producer, which appends, and one
+ * consumer, which pops; chunks are read back through an mmap()ed window of
+ * the file, without copying. The file is unlinked as soon as it is
+ * created, so nothing is left behind if the process dies. */
+typedef struct _DeepgramSpool DeepgramSpool;
+
+DeepgramSpool * deepgram_spool_new(const gchar *dir);
+
+void deepgram_spool_free(DeepgramSpool *spool);
+
+gboolean deepgram_spool_append(DeepgramSpool *spool, const guint8 *data,
+                               gsize size);
+
+GBytes * deepgram_spool_pop(DeepgramSpool *spool);
+
+gboolean deepgram_spool_is_empty(DeepgramSpool *spool);
+
+guint64 deepgram_spool_get_pending(DeepgramSpool *spool);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_SPOOL_H__ */
@@ -0,0 +1,334 @@
+#include "deepgramvad.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DEEPGRAM_VAD_SSE2 1
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define DEEPGRAM_VAD_AVX2 1
+#endif
+
+/* Audio is classified in windows of this length. */
+#define DEEPGRAM_VAD_WINDOW_MS 10
+
+typedef guint64 (*DeepgramEnergyFunc) (const gint16* s, gsize n,
+                                       guint channels, guint channel);
+
+struct _DeepgramVad
+{
+  guint   channels;
+  gsize   window_bytes;
+  gdouble threshold;
+  gsize   hangover_bytes;
+
+  /* Audio still sent after the last window above the threshold. */
+  gboolean open;
+  gsize    hangover_left;
+
+  /* The newest held-back bytes, at most preroll_bytes of them, oldest
+   * first; copied to preroll_out when the gate opens. */
+  guint8* held;
+  gsize   held_len;
+  gsize   preroll_bytes;
+  guint8* preroll_out;
+};
+
+/* ---- Sum of squares ------------------------------------------------------ */
+
+/* Of one channel's samples among n interleaved ones. The vector variants
+ * handle mono and stereo, masking out the other channel of each pair. */
+static guint64
+deepgram_vad_energy_scalar (const gint16* s, gsize n, guint channels,
+                            guint channel)
+{
+  guint64 sum = 0;
+
+  for (gsize i = channel; i < n; i += channels)
+    {
+      gint32 v = GINT16_FROM_LE (s[i]);
+      sum += (guint32)(v * v);
+    }
+
+  return sum;
+}
+
+#ifdef DEEPGRAM_VAD_SSE2
+/* madd squares and pairs up the samples; a pair of -32768s gives exactly
+ * 2^31, so the lanes are widened as unsigned before accumulating. */
+static guint64
+deepgram_vad_energy_sse2 (const gint16* s, gsize n, guint channels,
+                          guint channel)
+{
+  if (channels > 2)
+    return deepgram_vad_energy_scalar (s, n, channels, channel);
+
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i mask = _mm_set1_epi32 (
+      channels == 1 ? -1 : (gint32)(0xffffu << (16 * channel)));
+  __m128i acc = _mm_setzero_si128 ();
+  gsize   i   = 0;
+
+  for (; i + 8 <= n; i += 8)
+    {
+      __m128i x  = _mm_loadu_si128 ((const __m128i*)(s + i));
+      __m128i sq = _mm_madd_epi16 (x, _mm_and_si128 (x, mask));
+      acc        = _mm_add_epi64 (acc, _mm_unpacklo_epi32 (sq, zero));
+      acc        = _mm_add_epi64 (acc, _mm_unpackhi_epi32 (sq, zero));
+    }
+
+  guint64 lanes[2];
+  _mm_storeu_si128 ((__m128i*)lanes, acc);
+
+  return lanes[0] + lanes[1]
+         + deepgram_vad_energy_scalar (s + i, n - i, channels, channel);
+}
+#endif
+
+#ifdef DEEPGRAM_VAD_AVX2
+static __attribute__ ((target ("avx2"))) guint64
+deepgram_vad_energy_avx2 (const gint16* s, gsize n, guint channels,
+                          guint channel)
+{
+  if (channels > 2)
+    return deepgram_vad_energy_scalar (s, n, channels, channel);
+
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i mask = _mm256_set1_epi32 (
+      channels == 1 ? -1 : (gint32)(0xffffu << (16 * channel)));
+  __m256i acc = _mm256_setzero_si256 ();
+  gsize   i   = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      __m256i x  = _mm256_loadu_si256 ((const __m256i*)(s + i));
+      __m256i sq = _mm256_madd_epi16 (x, _mm256_and_si256 (x, mask));
+      acc        = _mm256_add_epi64 (acc, _mm256_unpacklo_epi32 (sq, zero));
+      acc        = _mm256_add_epi64 (acc, _mm256_unpackhi_epi32 (sq, zero));
+    }
+
+  guint64 lanes[4];
+  _mm256_storeu_si256 ((__m256i*)lanes, acc);
+
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+         + deepgram_vad_energy_scalar (s + i, n - i, channels, channel);
+}
+#endif
+
+static DeepgramEnergyFunc deepgram_vad_energy      = NULL;
+static const gchar*       deepgram_vad_energy_name = NULL;
+
+static void
+deepgram_vad_init_simd (void)
+{
+  static gsize initialized = 0;
+
+  if (!g_once_init_enter (&initialized))
+    return;
+
+  deepgram_vad_energy      = deepgram_vad_energy_scalar;
+  deepgram_vad_energy_name = "scalar";
+#ifdef DEEPGRAM_VAD_SSE2
+  deepgram_vad_energy      = deepgram_vad_energy_sse2;
+  deepgram_vad_energy_name = "sse2";
+#endif
+#ifdef DEEPGRAM_VAD_AVX2
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      deepgram_vad_energy      = deepgram_vad_energy_avx2;
+      deepgram_vad_energy_name = "avx2";
+    }
+#endif
+
+  g_once_init_leave (&initialized, 1);
+}
+
+const gchar*
+deepgram_vad_get_simd (void)
+{
+  deepgram_vad_init_simd ();
+  return deepgram_vad_energy_name;
+}
+
+/* ---- Gate ---------------------------------------------------------------- */
+
+DeepgramVad*
+deepgram_vad_new (guint rate, guint channels, gdouble threshold_db,
+                  guint64 hangover, guint64 preroll)
+{
+  deepgram_vad_init_simd ();
+
+  DeepgramVad* vad    = g_new0 (DeepgramVad, 1);
+  guint        frame  = channels * sizeof (gint16);
+  guint        window = MAX (rate * DEEPGRAM_VAD_WINDOW_MS / 1000, 1);
+
+  /* Compared against the mean square sample value of a window's loudest
+   * channel, so speech on one channel is not diluted by silence on the
+   * others. */
+  gdouble level  = 32768.0 * pow (10.0, threshold_db / 20.0);
+  vad->threshold = level * level;
+  vad->channels  = MAX (channels, 1);
+
+  vad->window_bytes   = window * frame;
+  vad->hangover_bytes = (gsize)(hangover / 1000 * rate / 1000000) * frame;
+  vad->preroll_bytes  = (gsize)(preroll / 1000 * rate / 1000000) * frame;
+  vad->held           = g_malloc (MAX (vad->preroll_bytes, 1));
+  vad->preroll_out    = g_malloc (MAX (vad->preroll_bytes, 1));
+
+  return vad;
+}
+
+void
+deepgram_vad_free (DeepgramVad* vad)
+{
+  if (!vad)
+    return;
+
+  g_free (vad->held);
+  g_free (vad->preroll_out);
+  g_free (vad);
+}
+
+void
+deepgram_vad_reset (DeepgramVad* vad)
+{
+  vad->open          = FALSE;
+  vad->hangover_left = 0;
+  vad->held_len      = 0;
+}
+
+gboolean
+deepgram_vad_is_open (DeepgramVad* vad)
+{
+  return vad->open;
+}
+
+/* Appends to the held-back silence, keeping only the newest preroll_bytes. */
+static void
+deepgram_vad_hold (DeepgramVad* vad, const guint8* data, gsize size)
+{
+  if (size >= vad->preroll_bytes)
+    {
+      memcpy (vad->held, data + size - vad->preroll_bytes, vad->preroll_bytes);
+      vad->held_len = vad->preroll_bytes;
+      return;
+    }
+
+  gsize keep = MIN (vad->held_len, vad->preroll_bytes - size);
+  memmove (vad->held, vad->held + vad->held_len - keep, keep);
+  memcpy (vad->held + keep, data, size);
+  vad->held_len = keep + size;
+}
+
+static void
+deepgram_vad_add_run (GArray* runs, guint first, gsize offset, gsize size,
+                      gboolean send)
+{
+  if (runs->len > first)
+    {
+      DeepgramVadRun* last
+          = &g_array_index (runs, DeepgramVadRun, runs->len - 1);
+      if (last->send == send)
+        {
+          last->size += size;
+          return;
+        }
+    }
+
+  DeepgramVadRun run = { offset, size, send };
+  g_array_append_val (runs, run);
+}
+
+void
+deepgram_vad_process (DeepgramVad* vad, const guint8* data, gsize size,
+                      GArray* runs, const guint8** preroll,
+                      gsize* preroll_size)
+{
+  guint first = runs->len;
+
+  *preroll      = NULL;
+  *preroll_size = 0;
+
+  for (gsize offset = 0; offset < size; offset += vad->window_bytes)
+    {
+      gsize   len    = MIN (vad->window_bytes, size - offset);
+      gsize   n      = len / sizeof (gint16);
+      gsize   frames = n / vad->channels;
+      guint64 energy = 0;
+
+      for (guint c = 0; frames > 0 && c < vad->channels; c++)
+        energy = MAX (energy,
+                      deepgram_vad_energy ((const gint16*)(data + offset), n,
+                                           vad->channels, c));
+
+      gsize    run_offset = offset;
+      gboolean send;
+      if (frames > 0 && energy >= vad->threshold * frames)
+        {
+          vad->hangover_left = vad->hangover_bytes;
+          send               = TRUE;
+        }
+      else if (vad->hangover_left > 0)
+        {
+          vad->hangover_left -= MIN (len, vad->hangover_left);
+          send = TRUE;
+        }
+      else
+        {
+          send = FALSE;
+        }
+
+      if (send && !vad->open)
+        {
+          /* Opening: move the tail of the silence before into this run. */
+          gsize take = 0;
+          if (runs->len > first)
+            {
+              DeepgramVadRun* last
+                  = &g_array_index (runs, DeepgramVadRun, runs->len - 1);
+              take = MIN (vad->preroll_bytes, last->size);
+              last->size -= take;
+              if (last->size == 0)
+                g_array_set_size (runs, runs->len - 1);
+            }
+
+          /* The silence reaches back into earlier buffers. */
+          if (runs->len == first && take < vad->preroll_bytes)
+            {
+              gsize extra = MIN (vad->preroll_bytes - take, vad->held_len);
+              memcpy (vad->preroll_out, vad->held + vad->held_len - extra,
+                      extra);
+              *preroll      = vad->preroll_out;
+              *preroll_size = extra;
+            }
+
+          run_offset -= take;
+          len += take;
+        }
+
+      vad->open = send;
+      deepgram_vad_add_run (runs, first, run_offset, len, send);
+    }
+
+  if (runs->len == first)
+    return;
+
+  /* Remember the trailing silence for the next opening; it only joins up
+   * with what is held already if nothing was sent in between. */
+  DeepgramVadRun* last = &g_array_index (runs, DeepgramVadRun, runs->len - 1);
+  if (last->send)
+    {
+      vad->held_len = 0;
+    }
+  else
+    {
+      if (last->offset > 0)
+        vad->held_len = 0;
+      deepgram_vad_hold (vad, data + last->offset, last->size);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef __DEEPGRAM_VAD_H__
+#define __DEEPGRAM_VAD_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A stretch of a buffer that is either sent to Deepgram or held back. */
+typedef struct {
+  gsize    offset;
+  gsize    size;
+  gboolean send;
+} DeepgramVadRun;
+
+/* Energy-based voice activity gate for interleaved S16LE audio; channels
+ * are gated together, never split within a frame. The level of each
+ * 10 ms window's loudest channel is compared with a threshold in dBFS; the
+ * gate opens on the first window above it and closes once hangover has
+ * passed without one.
+ * When it opens, up to preroll of the silence before is sent as well, so
+ * quiet word onsets are not clipped. */
+typedef struct _DeepgramVad DeepgramVad;
+
+DeepgramVad * deepgram_vad_new(guint rate, guint channels,
+                               gdouble threshold_db, guint64 hangover,
+                               guint64 preroll);
+
+void deepgram_vad_free(DeepgramVad *vad);
+
+/* Closes the gate and forgets the held-back silence, e.g. after a flush. */
+void deepgram_vad_reset(DeepgramVad *vad);
+
+/* Splits size bytes of audio into alternating runs to send and to hold
+ * back, appended to runs (of DeepgramVadRun). If the gate opens in the
+ * first send run after silence in earlier buffers, *preroll is set to the
+ * tail of that silence, to be sent just before the run; it stays valid
+ * until the next call. Otherwise *preroll_size is 0. */
+void deepgram_vad_process(DeepgramVad *vad, const guint8 *data, gsize size,
+                          GArray *runs, const guint8 **preroll,
+                          gsize *preroll_size);
+
+gboolean deepgram_vad_is_open(DeepgramVad *vad);
+
+/* Name of the SIMD variant in use, for benchmarks. */
+const gchar * deepgram_vad_get_simd(void);
+
+G_END_DECLS
+
+#endif /* __DEEPGRAM_VAD_H__ */
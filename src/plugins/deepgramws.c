@@ -1,90 +1,327 @@
 #include "deepgramws.h"
+#include "deepgramencode.h"
+#include "deepgramhttp.h"
+#include "deepgrampool.h"
+#include "deepgramresult.h"
+#include "deepgramring.h"
+#include "deepgramsession.h"
+#include "deepgramspool.h"
 
-#include <json-glib/json-glib.h>
 #include <libsoup/soup.h>
-#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-struct _DeepgramWS
-{
-  GObject parent_instance;
-
-  gchar*   api_key;
-  gchar*   model;
-  gboolean silent;
+#define DEEPGRAM_WS_DEFAULT_ENDPOINT "wss://api.deepgram.com/v1/listen"
 
-  SoupSession*             soup_session;
-  SoupWebsocketConnection* ws_conn;
-
-  GMutex    lock;
-  GCond     cond;
-  pthread_t ws_thread;
-  gboolean  stop_thread;
+/* Upper bound on queued chunks; the byte limit normally kicks in first. */
+#define DEEPGRAM_WS_RING_SLOTS 4096
 
-  GQueue* audio_queue;
-};
+/* How often a sender waiting for the socket to drain re-checks it. */
+#define DEEPGRAM_WS_WRITABLE_POLL_US 2000
 
-G_DEFINE_TYPE (DeepgramWS, deepgram_ws, G_TYPE_OBJECT)
+/* Max. chunks sent per dispatch before yielding to the other connections on
+ * the same worker. */
+#define DEEPGRAM_WS_PUMP_BUDGET 64
 
-static guint signals[N_WS_SIGNALS] = { 0 };
+/* Messages whose enqueue-to-wire time is kept for the percentiles in
+ * deepgram_ws_get_stats(). */
+#define DEEPGRAM_FRAMER_WIRE_SAMPLES 1024
 
-static void deepgram_ws_dispose (GObject* object);
+/* Reconnect backoff: doubles from MIN to MAX between attempts. */
+#define DEEPGRAM_WS_RECONNECT_MIN_MS 250
+#define DEEPGRAM_WS_RECONNECT_MAX_MS 8000
 
-static void* deepgram_ws_thread_func (void* user_data);
-static void  deepgram_ws_on_message (SoupWebsocketConnection* conn, gint type,
-                                     GBytes* message, gpointer user_data);
+/* transport=http: a minute of 16 kHz mono per upload, eight at a time. */
+#define DEEPGRAM_WS_DEFAULT_CHUNK_BYTES (60 * 32000)
+#define DEEPGRAM_WS_DEFAULT_MAX_UPLOADS 8
 
-static void deepgram_ws_get_property (GObject* object, guint prop_id,
-                                      GValue* value, GParamSpec* pspec);
+/* Opus at 32 kbit/s is transparent enough for wideband speech. */
+#define DEEPGRAM_WS_DEFAULT_BITRATE 32000
 
-static void deepgram_ws_set_property (GObject* object, guint prop_id,
-                                      const GValue* value, GParamSpec* pspec);
+#define DEEPGRAM_WS_CLOSE_STREAM "{\"type\":\"CloseStream\"}"
+#define DEEPGRAM_WS_KEEPALIVE    "{\"type\":\"KeepAlive\"}"
+#define DEEPGRAM_WS_FINALIZE     "{\"type\":\"Finalize\"}"
 
+/* Re-frames the audio stream into frame_bytes sized WebSocket messages. */
 typedef struct
 {
-  GMainLoop*               loop;
   SoupWebsocketConnection* conn;
-  GError*                  error;
-} DeepgramConnectData;
+  gsize                    frame_bytes;
+  gint64                   max_delay_us;
+
+  guint8* staging;
+  gsize   staged;
+  gint64  staged_since;
+
+  /* Optional bytes/s cap on what is handed to the socket. */
+  guint64 max_rate;
+  gint64  pace_start;
+  guint64 paced_bytes;
+
+  /* KeepAlive is sent after keepalive_us without any outgoing message. */
+  gint64 keepalive_us;
+  gint64 last_send;
+
+  /* Compresses each frame before it is sent; NULL for linear16. Pacing and
+   * framing still count audio bytes, so results line up as before. */
+  DeepgramEncoder* encoder;
+  _Atomic guint64  bytes_sent;
+  _Atomic guint64  encode_time;
+
+  /* Messages handed to the socket and the time spent doing so (ns);
+   * first_send is when the first one went out, on the monotonic clock. */
+  _Atomic guint64 frames_sent;
+  _Atomic guint64 send_time;
+  _Atomic guint64 send_time_max;
+  gint64          first_send;
+
+  /* How long the oldest audio in each message waited between
+   * deepgram_ws_enqueue() and the socket (ns), for the last
+   * DEEPGRAM_FRAMER_WIRE_SAMPLES messages; staged_enqueued is when the
+   * oldest audio in the staging frame was queued. */
+  gint64          staged_enqueued;
+  _Atomic guint64 wire_latency[DEEPGRAM_FRAMER_WIRE_SAMPLES];
+  _Atomic guint64 wire_samples;
+
+  /* Everything sent is logged here too, with record-to. */
+  DeepgramSessionLog* record;
+} DeepgramFramer;
+
+/* The last capacity bytes of audio handed to the framer, kept for replay
+ * after a reconnect. end is the stream offset just past the newest byte. */
+typedef struct
+{
+  guint8* data;
+  gsize   capacity;
+  guint64 end;
+} DeepgramReplay;
 
-static void
-deepgram_ws_connect_cb (GObject* source_object, GAsyncResult* res,
-                        gpointer user_data)
+struct _DeepgramWS
 {
-  DeepgramConnectData* cd = (DeepgramConnectData*)user_data;
-  cd->conn                = soup_session_websocket_connect_finish (
-      SOUP_SESSION (source_object), res, &cd->error);
-  g_main_loop_quit (cd->loop);
-}
+  GObject parent_instance;
+
+  gchar*        api_key;
+  gchar*        model;
+  gboolean      silent;
+  gchar*        endpoint;
+  GstStructure* query_params;
+
+  DeepgramEncoding encoding;
+  guint            bitrate;
+  DeepgramEncoder* encoder;
 
-static SoupWebsocketConnection*
-deepgram_ws_connect_sync (SoupSession* session, SoupMessage* msg,
-                          const gchar* origin, GCancellable* cancellable,
-                          GError** error_out)
+  /* Interleaved channels sent; with multichannel Deepgram transcribes each
+   * one separately instead of mixing them. */
+  guint    channels;
+  gboolean multichannel;
+
+  SoupWebsocketConnection* ws_conn;
+
+  /* With transport=http the worker feeds the queued audio to http instead
+   * of a WebSocket; it exists while the worker is running. */
+  gint          transport;
+  guint64       chunk_bytes;
+  guint         max_uploads;
+  DeepgramHttp* http;
+
+  /* The connection lives on a pool worker: connecting, sending (the pump
+   * source) and receiving all run on the worker's GMainContext. A worker
+   * stopped from its own thread is released by the teardown, see
+   * deepgram_ws_stop(). */
+  DeepgramWorker* worker;
+  DeepgramWorker* pending_release;
+  gboolean        dedicated_thread;
+  GCancellable*   cancellable;
+  SoupMessage*    msg;
+  GSource*        pump;
+  DeepgramFramer  framer;
+  guint64         discarded;
+
+  /* Reused by every incoming message, on the worker. */
+  DeepgramResult* result;
+
+  /* Reconnect state, owned by the worker. Results are acknowledged up to
+   * acked_bytes of the stream; the current session's time 0 is at
+   * session_base. Both are stream offsets in bytes. */
+  guint          max_reconnects;
+  guint64        replay_bytes;
+  DeepgramReplay replay;
+  guint          bytes_per_second;
+  guint          block_align;
+  guint64        acked_bytes;
+  guint64*       channel_acked;
+  guint          n_acked;
+  guint64        session_base;
+  gboolean       reconnecting;
+  guint          reconnect_attempt;
+  guint          generation;
+  GSource*       reconnect_source;
+  gint64         outage_start;
+
+  _Atomic guint   reconnects;
+  _Atomic guint64 outage_time;
+
+  /* lock only guards lifecycle state and the sleep/wake-up handshake; the
+   * streaming thread and the worker exchange audio through audio_ring. */
+  GMutex           lock;
+  GCond            cond;
+  GCond            space_cond;
+  _Atomic gboolean stopping;
+  gboolean         running;
+  gboolean         flushing;
+  _Atomic gboolean sender_waiting;
+  _Atomic gboolean producer_waiting;
+
+  /* End-of-stream handshake, see deepgram_ws_drain(). */
+  GCond            drain_cond;
+  _Atomic gboolean drain_requested;
+  gboolean         drained;
+  gboolean         stream_finished;
+
+  /* Finalize is sent once chunks_popped reaches finalize_at - 1 (0 = none
+   * requested); finalized is the last request served, on the worker. */
+  _Atomic guint64 finalize_at;
+  guint64         finalized;
+
+  DeepgramRing*   audio_ring;
+  _Atomic guint64 queued_bytes;
+  _Atomic guint64 max_queue_bytes;
+
+  /* Stream offset (bytes, the timeline results are on) at which the audio
+   * queued so far ends: what the worker has taken into the stream plus
+   * what is still queued, ring and spool alike. Audio that is dropped or
+   * discarded before it was sent is taken out again. */
+  _Atomic guint64 queued_end;
+  _Atomic gint    leaky;
+
+  /* When each chunk in audio_ring was queued (monotonic ns), in slot
+   * ring_pushed (producer) / ring_popped (consumer) modulo n_enqueue_times.
+   * Twice the ring's capacity, so the producer never reuses a slot before
+   * the consumer has read it. */
+  _Atomic gint64* enqueue_times;
+  guint           n_enqueue_times;
+  guint64         ring_pushed;
+  guint64         ring_popped;
+
+  /* With spool-dir set, audio that does not fit in the ring goes to disk,
+   * and so does everything after it until the spool is empty again: the
+   * ring only ever holds audio older than what is spooled. Created by
+   * deepgram_ws_start(). */
+  gchar*         spool_dir;
+  DeepgramSpool* spool;
+
+  /* With record-to, the session is logged for offline replay; opened by
+   * deepgram_ws_start() and closed by the worker's teardown. */
+  gchar*              record_to;
+  gboolean            record_audio;
+  DeepgramSessionLog* record;
+
+  _Atomic guint64 chunks_copied;
+  _Atomic guint64 chunks_zero_copy;
+
+  /* Chunks ever pushed/popped; chunks numbered up to discard_until were
+   * queued before a flush and are dropped by whoever pops them. */
+  _Atomic guint64 chunks_pushed;
+  _Atomic guint64 chunks_popped;
+  _Atomic guint64 discard_until;
+
+  /* Frame coalescing and pacing, read when the connection opens. */
+  guint   frame_bytes;
+  guint64 max_frame_delay;
+  guint64 max_send_rate;
+  guint64 keepalive_interval;
+
+  /* Benchmarking only: when non-zero, the idle sender looks at the queue
+   * every poll_interval (ns) instead of being woken by producers, as it
+   * did before deepgram_ws_wake_sender() existed. */
+  _Atomic guint64 poll_interval;
+
+  /* Live statistics, see deepgram_ws_get_stats(). Written on the worker
+   * and read from any thread; times in ns. stats_rate is the audio's
+   * bytes per second, set by deepgram_ws_start(). */
+  guint           stats_rate;
+  guint64         stats_interval;
+  GSource*        stats_source;
+  gint64          connect_start;
+  _Atomic guint64 connect_time;
+  _Atomic guint64 first_result_time;
+  _Atomic guint64 result_lag;
+  _Atomic guint64 result_lag_max;
+  _Atomic guint64 parse_time;
+  _Atomic guint64 messages_received;
+};
+
+G_DEFINE_TYPE (DeepgramWS, deepgram_ws, G_TYPE_OBJECT)
+
+GType
+deepgram_ws_leaky_get_type (void)
 {
-  DeepgramConnectData cd = { 0 };
-  cd.loop                = g_main_loop_new (NULL, FALSE);
-  soup_session_websocket_connect_async (
-      session, msg, origin, NULL, 0, cancellable, deepgram_ws_connect_cb, &cd);
+  static gsize            leaky_type = 0;
+  static const GEnumValue values[]   = {
+    { DEEPGRAM_WS_LEAKY_NO, "Not Leaky (block upstream)", "no" },
+    { DEEPGRAM_WS_LEAKY_UPSTREAM, "Leaky on upstream (drop new audio)",
+      "upstream" },
+    { DEEPGRAM_WS_LEAKY_DOWNSTREAM, "Leaky on downstream (drop old audio)",
+      "downstream" },
+    { 0, NULL, NULL },
+  };
+
+  if (g_once_init_enter (&leaky_type))
+    {
+      GType type = g_enum_register_static ("DeepgramWSLeaky", values);
+      g_once_init_leave (&leaky_type, type);
+    }
 
-  g_main_loop_run (cd.loop);
-  g_main_loop_unref (cd.loop);
+  return leaky_type;
+}
 
-  if (!cd.conn)
+GType
+deepgram_ws_transport_get_type (void)
+{
+  static gsize            transport_type = 0;
+  static const GEnumValue values[]       = {
+    { DEEPGRAM_WS_TRANSPORT_WEBSOCKET, "Stream over a WebSocket",
+      "websocket" },
+    { DEEPGRAM_WS_TRANSPORT_HTTP,
+      "Upload chunks to the prerecorded API concurrently", "http" },
+    { 0, NULL, NULL },
+  };
+
+  if (g_once_init_enter (&transport_type))
     {
-      if (error_out)
-        {
-          *error_out = cd.error;
-        }
-      else
-        {
-          g_clear_error (&cd.error);
-        }
-      return NULL;
+      GType type = g_enum_register_static ("DeepgramWSTransport", values);
+      g_once_init_leave (&transport_type, type);
     }
 
-  return cd.conn;
+  return transport_type;
 }
 
+static guint signals[N_WS_SIGNALS] = { 0 };
+
+static void deepgram_ws_dispose (GObject* object);
+
+static gchar*   deepgram_ws_build_url (DeepgramWS* self);
+static void     deepgram_ws_get_audio_format (DeepgramWS* self,
+                                              guint*      bytes_per_second,
+                                              guint*      block_align);
+static gint64   deepgram_monotonic_time (void);
+static gboolean deepgram_ws_connect (gpointer user_data);
+static gboolean deepgram_ws_pump (gpointer user_data);
+static void     deepgram_ws_teardown (DeepgramWS* self);
+static void     deepgram_ws_on_closed (SoupWebsocketConnection* conn,
+                                       gpointer                 user_data);
+static void     deepgram_ws_on_message (SoupWebsocketConnection* conn,
+                                        gint type, GBytes* message,
+                                        gpointer user_data);
+
+static void deepgram_ws_get_property (GObject* object, guint prop_id,
+                                      GValue* value, GParamSpec* pspec);
+
+static void deepgram_ws_set_property (GObject* object, guint prop_id,
+                                      const GValue* value, GParamSpec* pspec);
+
 static void
 deepgram_ws_class_init (DeepgramWSClass* klass)
 {
@@ -104,36 +341,401 @@ deepgram_ws_class_init (DeepgramWSClass* klass)
       g_param_spec_string ("model", "Model", "Deepgram model name", "general",
                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (
+      object_class, PROP_WS_MAX_SEND_RATE,
+      g_param_spec_uint64 ("max-send-rate", "Max Send Rate",
+                           "Max. bytes per second sent (0 = unlimited)", 0,
+                           G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_KEEPALIVE_INTERVAL,
+      g_param_spec_uint64 ("keepalive-interval", "KeepAlive Interval",
+                           "Send a KeepAlive message after this long (ns) "
+                           "without audio (0 = never)",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_DEDICATED_THREAD,
+      g_param_spec_boolean ("dedicated-thread", "Dedicated Thread",
+                            "Run the connection on a thread and main context "
+                            "of its own instead of a shared pool worker",
+                            FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_MAX_RECONNECTS,
+      g_param_spec_uint ("max-reconnects", "Max Reconnects",
+                         "Reconnect attempts after the connection drops "
+                         "(0 = don't reconnect)",
+                         0, G_MAXUINT, 0,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_REPLAY_BYTES,
+      g_param_spec_uint64 ("replay-bytes", "Replay Bytes",
+                           "Recently sent audio kept for replay after a "
+                           "reconnect",
+                           0, G_MAXUINT32, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_RECONNECTS,
+      g_param_spec_uint ("reconnects", "Reconnects",
+                         "Successful reconnects since start", 0, G_MAXUINT, 0,
+                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_OUTAGE_TIME,
+      g_param_spec_uint64 ("outage-time", "Outage Time",
+                           "Total time (ns) spent reconnecting since start", 0,
+                           G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_ENCODING,
+      g_param_spec_enum ("encoding", "Encoding",
+                         "How audio is sent: as is, or compressed on the "
+                         "worker",
+                         DEEPGRAM_TYPE_ENCODING, DEEPGRAM_ENCODING_LINEAR16,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate",
+                         "Opus target bitrate in bits per second", 6000,
+                         256000, DEEPGRAM_WS_DEFAULT_BITRATE,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_CHANNELS,
+      g_param_spec_uint ("channels", "Channels",
+                         "Interleaved channels in the audio pushed", 1, 255, 1,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_MULTICHANNEL,
+      g_param_spec_boolean ("multichannel", "Multichannel",
+                            "Have Deepgram transcribe each channel on its own",
+                            FALSE,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_BYTES_SENT,
+      g_param_spec_uint64 ("bytes-sent", "Bytes Sent",
+                           "Audio bytes put on the wire since start, after "
+                           "encoding",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_ENCODE_TIME,
+      g_param_spec_uint64 ("encode-time", "Encode Time",
+                           "CPU time (ns) spent encoding since start", 0,
+                           G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+                          "Live statistics of the stream as a "
+                          "deepgram-stats structure",
+                          GST_TYPE_STRUCTURE,
+                          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_STATS_INTERVAL,
+      g_param_spec_uint64 ("stats-interval", "Stats Interval",
+                           "Emit \"stats\" this often (ns) while connected; "
+                           "0 = never",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_ENDPOINT,
+      g_param_spec_string ("endpoint", "Endpoint",
+                           "Deepgram streaming endpoint URL",
+                           DEEPGRAM_WS_DEFAULT_ENDPOINT,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_QUERY_PARAMS,
+      g_param_spec_boxed ("query-params", "Query Parameters",
+                          "Extra query parameters for the endpoint URL, one "
+                          "field per parameter (e.g. interim_results=true)",
+                          GST_TYPE_STRUCTURE,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (
       object_class, PROP_WS_SILENT,
       g_param_spec_boolean ("silent", "Silent", "Suppress console logging",
                             FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (
+      object_class, PROP_WS_CHUNKS_COPIED,
+      g_param_spec_uint64 ("chunks-copied", "Chunks Copied",
+                           "Audio chunks that were copied before queueing", 0,
+                           G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_CHUNKS_ZERO_COPY,
+      g_param_spec_uint64 ("chunks-zero-copy", "Chunks Zero Copy",
+                           "Audio chunks queued without copying the payload",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_MAX_QUEUE_BYTES,
+      g_param_spec_uint64 ("max-queue-bytes", "Max Queue Bytes",
+                           "Max. amount of audio waiting to be sent "
+                           "(0 = unlimited)",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_LEAKY,
+      g_param_spec_enum ("leaky", "Leaky",
+                         "Where to drop audio when the queue is full",
+                         DEEPGRAM_TYPE_WS_LEAKY, DEEPGRAM_WS_LEAKY_NO,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_SPOOL_DIR,
+      g_param_spec_string ("spool-dir", "Spool Directory",
+                           "Directory for a file holding the audio that does "
+                           "not fit in max-queue-bytes, instead of blocking "
+                           "or dropping it (NULL = keep it in memory)",
+                           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_RECORD_TO,
+      g_param_spec_string ("record-to", "Record To",
+                           "File to log every message sent and received to, "
+                           "for replaying the session offline (NULL = off)",
+                           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_RECORD_AUDIO,
+      g_param_spec_boolean ("record-audio", "Record Audio",
+                            "Log the audio sent with record-to, not just the "
+                            "size of each message",
+                            FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_TRANSPORT,
+      g_param_spec_enum ("transport", "Transport",
+                         "Stream over a WebSocket, or upload chunks cut at "
+                         "quiet points to the prerecorded API (for files)",
+                         DEEPGRAM_TYPE_WS_TRANSPORT,
+                         DEEPGRAM_WS_TRANSPORT_WEBSOCKET,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_CHUNK_BYTES,
+      g_param_spec_uint64 ("chunk-bytes", "Chunk Bytes",
+                           "transport=http: audio per upload, ending at the "
+                           "quietest point of its last quarter (0 = upload "
+                           "everything at the end)",
+                           0, G_MAXUINT32, DEEPGRAM_WS_DEFAULT_CHUNK_BYTES,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_MAX_UPLOADS,
+      g_param_spec_uint ("max-uploads", "Max Uploads",
+                         "transport=http: chunks uploaded at the same time",
+                         1, 256, DEEPGRAM_WS_DEFAULT_MAX_UPLOADS,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_FRAME_BYTES,
+      g_param_spec_uint ("frame-bytes", "Frame Bytes",
+                         "Size of each binary WebSocket message; queued audio "
+                         "is merged or split to fit (0 = send chunks as-is)",
+                         0, G_MAXUINT, 0,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_MAX_FRAME_DELAY,
+      g_param_spec_uint64 ("max-frame-delay", "Max Frame Delay",
+                           "Max. time (ns) a partial frame is held back "
+                           "waiting for more audio",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      object_class, PROP_WS_POLL_INTERVAL,
+      g_param_spec_uint64 ("poll-interval", "Poll Interval",
+                           "For benchmarks: poll the queue every this many "
+                           "ns instead of sending audio as soon as it is "
+                           "queued (0 = no polling)",
+                           0, G_MAXUINT64, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /* Every result signal ends with the channel it belongs to, 0 unless
+   * multichannel is set. */
   signals[SIGNAL_WS_TRANSCRIPT] = g_signal_new (
       "transcript", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
-      NULL, G_TYPE_NONE, 4, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_DOUBLE,
-      G_TYPE_DOUBLE);
+      NULL, G_TYPE_NONE, 5, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE, G_TYPE_UINT);
 
+  /* Per-word text, start, end and confidence; only emitted when connected,
+   * see "words" for the cheaper batched form. */
   signals[SIGNAL_WS_WORD]
       = g_signal_new ("word", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0,
-                      NULL, NULL, NULL, G_TYPE_NONE, 4, G_TYPE_STRING,
-                      G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+                      NULL, NULL, NULL, G_TYPE_NONE, 5, G_TYPE_STRING,
+                      G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_UINT);
+
+  /* The leaky queue dropped this many bytes: emitted on the streaming
+   * thread when queueing, or on the worker when trimming the backlog, once
+   * for each chunk queued or sent. */
+  signals[SIGNAL_WS_AUDIO_DROPPED] = g_signal_new (
+      "audio-dropped", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT64);
+
+  /* Emitted on the worker after a dropped connection was re-established:
+   * attempts it took, outage (ns), and replayed audio (bytes). */
+  signals[SIGNAL_WS_RECONNECTED] = g_signal_new (
+      "reconnected", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 3, G_TYPE_UINT, G_TYPE_UINT64, G_TYPE_UINT64);
+
+  /* All words of a result at once, as a GArray of DeepgramWord on the
+   * stream's timeline, and whether the result is final. The array and its
+   * strings belong to the connection and are only valid during emission. */
+  signals[SIGNAL_WS_WORDS] = g_signal_new (
+      "words", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+      NULL, G_TYPE_NONE, 3, G_TYPE_ARRAY | G_SIGNAL_TYPE_STATIC_SCOPE,
+      G_TYPE_BOOLEAN, G_TYPE_UINT);
+
+  /* Emitted on the worker every stats-interval with the same structure as
+   * the "stats" property, which is only valid during emission. */
+  signals[SIGNAL_WS_STATS] = g_signal_new (
+      "stats", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+      NULL, G_TYPE_NONE, 1, GST_TYPE_STRUCTURE | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  /* transport=http: emitted on the worker when an upload was given up on,
+   * with the start and duration (s) of the audio left without results. */
+  signals[SIGNAL_WS_CHUNK_FAILED] = g_signal_new (
+      "chunk-failed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+
+  /* Queued audio was taken out of the stream before it was sent, by a
+   * flush or the leaky queue: the stream offset it was at and its size
+   * (bytes). Audio queued after it moves up by that much on the timeline
+   * results are on. Emitted on the streaming thread or the worker. */
+  signals[SIGNAL_WS_AUDIO_REMOVED] = g_signal_new (
+      "audio-removed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_UINT64, G_TYPE_UINT64);
 }
 
 static void
 deepgram_ws_init (DeepgramWS* self)
 {
-  self->api_key      = NULL;
-  self->model        = g_strdup ("general");
-  self->silent       = FALSE;
-  self->soup_session = NULL;
-  self->ws_conn      = NULL;
+  self->api_key          = NULL;
+  self->model            = g_strdup ("general");
+  self->silent           = FALSE;
+  self->endpoint         = g_strdup (DEEPGRAM_WS_DEFAULT_ENDPOINT);
+  self->query_params     = NULL;
+  self->encoding         = DEEPGRAM_ENCODING_LINEAR16;
+  self->bitrate          = DEEPGRAM_WS_DEFAULT_BITRATE;
+  self->encoder          = NULL;
+  self->ws_conn          = NULL;
+  self->transport        = DEEPGRAM_WS_TRANSPORT_WEBSOCKET;
+  self->chunk_bytes      = DEEPGRAM_WS_DEFAULT_CHUNK_BYTES;
+  self->max_uploads      = DEEPGRAM_WS_DEFAULT_MAX_UPLOADS;
+  self->http             = NULL;
+  self->worker           = NULL;
+  self->dedicated_thread = FALSE;
+  self->cancellable      = NULL;
+  self->msg              = NULL;
+  self->pending_release  = NULL;
+  self->pump             = NULL;
+  self->discarded        = 0;
+  self->result           = deepgram_result_new ();
 
   g_mutex_init (&self->lock);
   g_cond_init (&self->cond);
-
-  self->stop_thread = FALSE;
-  self->audio_queue = g_queue_new ();
+  g_cond_init (&self->space_cond);
+
+  atomic_init (&self->stopping, FALSE);
+  self->running  = FALSE;
+  self->flushing = FALSE;
+  atomic_init (&self->sender_waiting, FALSE);
+  atomic_init (&self->producer_waiting, FALSE);
+
+  g_cond_init (&self->drain_cond);
+  atomic_init (&self->drain_requested, FALSE);
+  self->drained       = FALSE;
+  self->stream_finished = FALSE;
+  atomic_init (&self->finalize_at, 0);
+  self->finalized = 0;
+
+  self->audio_ring = deepgram_ring_new (DEEPGRAM_WS_RING_SLOTS);
+  atomic_init (&self->queued_bytes, 0);
+  atomic_init (&self->queued_end, 0);
+  self->n_enqueue_times = 2 * deepgram_ring_capacity (self->audio_ring);
+  self->enqueue_times   = g_new0 (_Atomic gint64, self->n_enqueue_times);
+  self->ring_pushed     = 0;
+  self->ring_popped     = 0;
+  atomic_init (&self->max_queue_bytes, 0);
+  atomic_init (&self->leaky, DEEPGRAM_WS_LEAKY_NO);
+  self->spool_dir    = NULL;
+  self->spool        = NULL;
+  self->record_to    = NULL;
+  self->record_audio = FALSE;
+  self->record       = NULL;
+
+  atomic_init (&self->chunks_copied, 0);
+  atomic_init (&self->chunks_zero_copy, 0);
+  atomic_init (&self->chunks_pushed, 0);
+  atomic_init (&self->chunks_popped, 0);
+  atomic_init (&self->discard_until, 0);
+
+  self->frame_bytes        = 0;
+  self->max_frame_delay    = 0;
+  self->max_send_rate      = 0;
+  self->keepalive_interval = 0;
+  atomic_init (&self->poll_interval, 0);
+
+  self->max_reconnects    = 0;
+  self->replay_bytes      = 0;
+  self->replay.data       = NULL;
+  self->replay.capacity   = 0;
+  self->replay.end        = 0;
+  self->bytes_per_second  = 1;
+  self->block_align       = 2;
+  self->acked_bytes       = 0;
+  self->channel_acked     = NULL;
+  self->n_acked           = 0;
+  self->channels          = 1;
+  self->multichannel      = FALSE;
+  self->session_base      = 0;
+  self->reconnecting      = FALSE;
+  self->reconnect_attempt = 0;
+  self->generation        = 0;
+  self->reconnect_source  = NULL;
+  self->outage_start      = 0;
+  atomic_init (&self->reconnects, 0);
+  atomic_init (&self->outage_time, 0);
+  atomic_init (&self->framer.bytes_sent, 0);
+  atomic_init (&self->framer.encode_time, 0);
+  atomic_init (&self->framer.frames_sent, 0);
+  atomic_init (&self->framer.send_time, 0);
+  atomic_init (&self->framer.send_time_max, 0);
+  self->framer.staged_enqueued = 0;
+  atomic_init (&self->framer.wire_samples, 0);
+  self->framer.first_send = 0;
+  self->framer.record     = NULL;
+  self->stats_rate        = 1;
+  self->stats_interval    = 0;
+  self->stats_source      = NULL;
+  self->connect_start     = 0;
+  atomic_init (&self->connect_time, 0);
+  atomic_init (&self->first_result_time, GST_CLOCK_TIME_NONE);
+  atomic_init (&self->result_lag, 0);
+  atomic_init (&self->result_lag_max, 0);
+  atomic_init (&self->parse_time, 0);
+  atomic_init (&self->messages_received, 0);
 }
 
 static void
@@ -153,18 +755,20 @@ deepgram_ws_dispose (GObject* object)
       g_free (self->model);
       self->model = NULL;
     }
+  g_clear_pointer (&self->endpoint, g_free);
+  g_clear_pointer (&self->query_params, gst_structure_free);
+  g_clear_pointer (&self->result, deepgram_result_free);
 
-  if (self->audio_queue)
+  if (self->audio_ring)
     {
-      while (!g_queue_is_empty (self->audio_queue))
-        {
-          GBytes* chunk = g_queue_pop_head (self->audio_queue);
-          if (chunk)
-            g_bytes_unref (chunk);
-        }
-      g_queue_free (self->audio_queue);
-      self->audio_queue = NULL;
+      deepgram_ring_free (self->audio_ring, (GDestroyNotify)g_bytes_unref);
+      self->audio_ring = NULL;
+      atomic_store (&self->queued_bytes, 0);
     }
+  g_clear_pointer (&self->enqueue_times, g_free);
+  g_clear_pointer (&self->spool, deepgram_spool_free);
+  g_clear_pointer (&self->spool_dir, g_free);
+  g_clear_pointer (&self->record_to, g_free);
 
   G_OBJECT_CLASS (deepgram_ws_parent_class)->dispose (object);
 }
@@ -190,6 +794,101 @@ deepgram_ws_set_property (GObject* object, guint prop_id, const GValue* value,
     case PROP_WS_SILENT:
       self->silent = g_value_get_boolean (value);
       break;
+    case PROP_WS_ENDPOINT:
+      g_free (self->endpoint);
+      self->endpoint = g_value_dup_string (value);
+      break;
+    case PROP_WS_QUERY_PARAMS:
+      g_clear_pointer (&self->query_params, gst_structure_free);
+      self->query_params = g_value_dup_boxed (value);
+      break;
+    case PROP_WS_ENCODING:
+      self->encoding = g_value_get_enum (value);
+      break;
+    case PROP_WS_BITRATE:
+      self->bitrate = g_value_get_uint (value);
+      break;
+    case PROP_WS_CHANNELS:
+      self->channels = g_value_get_uint (value);
+      break;
+    case PROP_WS_MULTICHANNEL:
+      self->multichannel = g_value_get_boolean (value);
+      break;
+    case PROP_WS_STATS_INTERVAL:
+      g_mutex_lock (&self->lock);
+      self->stats_interval = g_value_get_uint64 (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_MAX_QUEUE_BYTES:
+      g_mutex_lock (&self->lock);
+      atomic_store (&self->max_queue_bytes, g_value_get_uint64 (value));
+      g_cond_broadcast (&self->space_cond);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_LEAKY:
+      g_mutex_lock (&self->lock);
+      atomic_store (&self->leaky, g_value_get_enum (value));
+      g_cond_broadcast (&self->space_cond);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_SPOOL_DIR:
+      g_free (self->spool_dir);
+      self->spool_dir = g_value_dup_string (value);
+      break;
+    case PROP_WS_RECORD_TO:
+      g_free (self->record_to);
+      self->record_to = g_value_dup_string (value);
+      break;
+    case PROP_WS_RECORD_AUDIO:
+      self->record_audio = g_value_get_boolean (value);
+      break;
+    case PROP_WS_TRANSPORT:
+      self->transport = g_value_get_enum (value);
+      break;
+    case PROP_WS_CHUNK_BYTES:
+      self->chunk_bytes = g_value_get_uint64 (value);
+      break;
+    case PROP_WS_MAX_UPLOADS:
+      self->max_uploads = g_value_get_uint (value);
+      break;
+    case PROP_WS_FRAME_BYTES:
+      g_mutex_lock (&self->lock);
+      self->frame_bytes = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_MAX_FRAME_DELAY:
+      g_mutex_lock (&self->lock);
+      self->max_frame_delay = g_value_get_uint64 (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_POLL_INTERVAL:
+      atomic_store (&self->poll_interval, g_value_get_uint64 (value));
+      break;
+    case PROP_WS_MAX_SEND_RATE:
+      g_mutex_lock (&self->lock);
+      self->max_send_rate = g_value_get_uint64 (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_KEEPALIVE_INTERVAL:
+      g_mutex_lock (&self->lock);
+      self->keepalive_interval = g_value_get_uint64 (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_DEDICATED_THREAD:
+      g_mutex_lock (&self->lock);
+      self->dedicated_thread = g_value_get_boolean (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_MAX_RECONNECTS:
+      g_mutex_lock (&self->lock);
+      self->max_reconnects = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_WS_REPLAY_BYTES:
+      g_mutex_lock (&self->lock);
+      self->replay_bytes = g_value_get_uint64 (value);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -213,6 +912,96 @@ deepgram_ws_get_property (GObject* object, guint prop_id, GValue* value,
     case PROP_WS_SILENT:
       g_value_set_boolean (value, self->silent);
       break;
+    case PROP_WS_ENDPOINT:
+      g_value_set_string (value, self->endpoint);
+      break;
+    case PROP_WS_QUERY_PARAMS:
+      g_value_set_boxed (value, self->query_params);
+      break;
+    case PROP_WS_ENCODING:
+      g_value_set_enum (value, self->encoding);
+      break;
+    case PROP_WS_BITRATE:
+      g_value_set_uint (value, self->bitrate);
+      break;
+    case PROP_WS_CHANNELS:
+      g_value_set_uint (value, self->channels);
+      break;
+    case PROP_WS_MULTICHANNEL:
+      g_value_set_boolean (value, self->multichannel);
+      break;
+    case PROP_WS_STATS:
+      g_value_take_boxed (value, deepgram_ws_get_stats (self));
+      break;
+    case PROP_WS_STATS_INTERVAL:
+      g_value_set_uint64 (value, self->stats_interval);
+      break;
+    case PROP_WS_BYTES_SENT:
+      g_value_set_uint64 (value, atomic_load (&self->framer.bytes_sent));
+      break;
+    case PROP_WS_ENCODE_TIME:
+      g_value_set_uint64 (value, atomic_load (&self->framer.encode_time));
+      break;
+    case PROP_WS_CHUNKS_COPIED:
+      g_value_set_uint64 (value, atomic_load (&self->chunks_copied));
+      break;
+    case PROP_WS_CHUNKS_ZERO_COPY:
+      g_value_set_uint64 (value, atomic_load (&self->chunks_zero_copy));
+      break;
+    case PROP_WS_MAX_QUEUE_BYTES:
+      g_value_set_uint64 (value, atomic_load (&self->max_queue_bytes));
+      break;
+    case PROP_WS_LEAKY:
+      g_value_set_enum (value, atomic_load (&self->leaky));
+      break;
+    case PROP_WS_SPOOL_DIR:
+      g_value_set_string (value, self->spool_dir);
+      break;
+    case PROP_WS_RECORD_TO:
+      g_value_set_string (value, self->record_to);
+      break;
+    case PROP_WS_RECORD_AUDIO:
+      g_value_set_boolean (value, self->record_audio);
+      break;
+    case PROP_WS_TRANSPORT:
+      g_value_set_enum (value, self->transport);
+      break;
+    case PROP_WS_CHUNK_BYTES:
+      g_value_set_uint64 (value, self->chunk_bytes);
+      break;
+    case PROP_WS_MAX_UPLOADS:
+      g_value_set_uint (value, self->max_uploads);
+      break;
+    case PROP_WS_FRAME_BYTES:
+      g_value_set_uint (value, self->frame_bytes);
+      break;
+    case PROP_WS_MAX_FRAME_DELAY:
+      g_value_set_uint64 (value, self->max_frame_delay);
+      break;
+    case PROP_WS_POLL_INTERVAL:
+      g_value_set_uint64 (value, atomic_load (&self->poll_interval));
+      break;
+    case PROP_WS_MAX_SEND_RATE:
+      g_value_set_uint64 (value, self->max_send_rate);
+      break;
+    case PROP_WS_KEEPALIVE_INTERVAL:
+      g_value_set_uint64 (value, self->keepalive_interval);
+      break;
+    case PROP_WS_DEDICATED_THREAD:
+      g_value_set_boolean (value, self->dedicated_thread);
+      break;
+    case PROP_WS_MAX_RECONNECTS:
+      g_value_set_uint (value, self->max_reconnects);
+      break;
+    case PROP_WS_REPLAY_BYTES:
+      g_value_set_uint64 (value, self->replay_bytes);
+      break;
+    case PROP_WS_RECONNECTS:
+      g_value_set_uint (value, atomic_load (&self->reconnects));
+      break;
+    case PROP_WS_OUTAGE_TIME:
+      g_value_set_uint64 (value, atomic_load (&self->outage_time));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -225,6 +1014,30 @@ deepgram_ws_new (void)
   return g_object_new (DEEPGRAM_TYPE_WS, NULL);
 }
 
+/* The upgrade request for a new session, authenticated with api-key. */
+static SoupMessage*
+deepgram_ws_new_message (DeepgramWS* self)
+{
+  gchar*       url = deepgram_ws_build_url (self);
+  SoupMessage* msg = soup_message_new (SOUP_METHOD_GET, url);
+  if (!msg)
+    {
+      g_printerr ("[DeepgramWS] Failed to create SoupMessage for %s\n", url);
+      g_free (url);
+      return NULL;
+    }
+
+  SoupMessageHeaders* headers  = soup_message_get_request_headers (msg);
+  gchar*              auth_val = g_strdup_printf ("Token %s", self->api_key);
+  soup_message_headers_append (headers, "Authorization", auth_val);
+  g_free (auth_val);
+
+  g_print ("[DeepgramWS] Connecting to: %s\n", url);
+  g_free (url);
+
+  return msg;
+}
+
 gboolean
 deepgram_ws_start (DeepgramWS* self)
 {
@@ -236,166 +1049,1673 @@ deepgram_ws_start (DeepgramWS* self)
       return FALSE;
     }
 
-  if (!self->soup_session)
+  g_mutex_lock (&self->lock);
+  gboolean running = self->running;
+  g_mutex_unlock (&self->lock);
+  if (running || self->worker)
+    {
+      g_printerr ("[DeepgramWS] Already started.\n");
+      return FALSE;
+    }
+
+  guint bytes_per_second, block_align;
+  deepgram_ws_get_audio_format (self, &bytes_per_second, &block_align);
+
+  /* Created here so an encoding the build or the audio format does not
+   * support fails the start instead of the connection. The worker owns it
+   * from now on. */
+  if (self->encoding != DEEPGRAM_ENCODING_LINEAR16)
+    {
+      self->encoder = deepgram_encoder_new (
+          self->encoding, bytes_per_second / block_align, block_align / 2,
+          self->bitrate);
+      if (!self->encoder)
+        {
+          g_printerr ("[DeepgramWS] ERROR: cannot send %s audio.\n",
+                      deepgram_encoding_get_name (self->encoding));
+          return FALSE;
+        }
+    }
+
+  /* Kept across restarts like the ring, with whatever is still in it. */
+  if (self->spool_dir && !self->spool)
     {
-      self->soup_session = soup_session_new ();
+      self->spool = deepgram_spool_new (self->spool_dir);
+      if (!self->spool)
+        {
+          g_clear_pointer (&self->encoder, deepgram_encoder_free);
+          return FALSE;
+        }
+    }
+
+  /* Sessions are recorded as WebSocket traffic, which http has none of. */
+  if (self->record_to && self->transport == DEEPGRAM_WS_TRANSPORT_WEBSOCKET)
+    {
+      self->record
+          = deepgram_session_log_new (self->record_to, self->record_audio);
+      if (!self->record)
+        {
+          g_clear_pointer (&self->encoder, deepgram_encoder_free);
+          return FALSE;
+        }
     }
 
-  self->stop_thread = FALSE;
-  if (pthread_create (&self->ws_thread, NULL, deepgram_ws_thread_func, self)
-      != 0)
+  SoupMessage* msg = NULL;
+  if (self->transport == DEEPGRAM_WS_TRANSPORT_WEBSOCKET
+      && !(msg = deepgram_ws_new_message (self)))
     {
-      g_printerr ("[DeepgramWS] Failed to create ws_thread.\n");
+      g_clear_pointer (&self->encoder, deepgram_encoder_free);
+      g_clear_pointer (&self->record, deepgram_session_log_free);
       return FALSE;
     }
 
+  atomic_store (&self->reconnects, 0);
+  atomic_store (&self->outage_time, 0);
+  atomic_store (&self->framer.bytes_sent, 0);
+  atomic_store (&self->framer.encode_time, 0);
+  atomic_store (&self->framer.frames_sent, 0);
+  atomic_store (&self->framer.send_time, 0);
+  atomic_store (&self->framer.send_time_max, 0);
+  atomic_store (&self->framer.wire_samples, 0);
+  atomic_store (&self->connect_time, 0);
+  atomic_store (&self->first_result_time, GST_CLOCK_TIME_NONE);
+  atomic_store (&self->result_lag, 0);
+  atomic_store (&self->result_lag_max, 0);
+  atomic_store (&self->parse_time, 0);
+  atomic_store (&self->messages_received, 0);
+
+  /* Audio still queued is the first of the new stream. */
+  atomic_store (&self->queued_end, atomic_load (&self->queued_bytes));
+
+  g_mutex_lock (&self->lock);
+  self->stats_rate = bytes_per_second;
+  atomic_store (&self->stopping, FALSE);
+  atomic_store (&self->drain_requested, FALSE);
+  self->running         = TRUE;
+  self->drained         = FALSE;
+  self->stream_finished = FALSE;
+  self->msg             = msg;
+  self->cancellable     = g_cancellable_new ();
+  self->worker          = self->dedicated_thread
+                              ? deepgram_pool_acquire_dedicated ()
+                              : deepgram_pool_acquire ();
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_invoke_full (deepgram_worker_get_context (self->worker),
+                              G_PRIORITY_DEFAULT, deepgram_ws_connect,
+                              g_object_ref (self), g_object_unref);
+
   return TRUE;
 }
 
+/* Closes the connection and waits until the worker has let go of it. When
+ * called from a handler running on the worker itself, the connection is
+ * torn down asynchronously after this returns. */
 void
 deepgram_ws_stop (DeepgramWS* self)
 {
   g_return_if_fail (DEEPGRAM_IS_WS (self));
 
   g_mutex_lock (&self->lock);
-  self->stop_thread = TRUE;
-  if (self->ws_conn)
+  if (!self->worker)
     {
-      soup_websocket_connection_close (self->ws_conn, 1000, "Normal closure");
+      g_mutex_unlock (&self->lock);
+      return;
     }
+
+  atomic_store (&self->stopping, TRUE);
+  g_cond_broadcast (&self->space_cond);
+  if (self->pump)
+    g_source_set_ready_time (self->pump, 0);
   g_mutex_unlock (&self->lock);
 
-  if (self->ws_thread)
+  g_cancellable_cancel (self->cancellable);
+
+  /* On the worker itself, the cancelled operations complete only after this
+   * returns; a dedicated worker must keep iterating until they have, so
+   * the teardown releases it once running drops. */
+  GMainContext* context  = deepgram_worker_get_context (self->worker);
+  gboolean      deferred = FALSE;
+  g_mutex_lock (&self->lock);
+  if (!g_main_context_is_owner (context))
     {
-      pthread_join (self->ws_thread, NULL);
-      self->ws_thread = 0;
+      while (self->running)
+        g_cond_wait (&self->cond, &self->lock);
     }
-
-  if (self->soup_session)
+  else if (self->running)
     {
-      g_object_unref (self->soup_session);
-      self->soup_session = NULL;
+      self->pending_release = self->worker;
+      deferred              = TRUE;
     }
+  g_mutex_unlock (&self->lock);
+
+  if (!deferred)
+    deepgram_pool_release (self->worker);
+  self->worker = NULL;
+  g_clear_object (&self->cancellable);
 }
 
 void
-deepgram_ws_push_audio (DeepgramWS* self, const guint8* data, gsize size)
+deepgram_ws_set_flushing (DeepgramWS* self, gboolean flushing)
 {
   g_return_if_fail (DEEPGRAM_IS_WS (self));
 
-  if (!data || size == 0)
-    return;
-
-  GBytes* chunk = g_bytes_new (data, size);
-
   g_mutex_lock (&self->lock);
-  g_queue_push_tail (self->audio_queue, chunk);
+  self->flushing = flushing;
+  g_cond_broadcast (&self->space_cond);
   g_mutex_unlock (&self->lock);
 }
 
-static void*
-deepgram_ws_thread_func (void* user_data)
+/* Whether a chunk of size bytes may be queued without exceeding
+ * max-queue-bytes or the ring capacity. A single chunk larger than the limit
+ * is still accepted once the queue is empty. */
+static gboolean
+deepgram_ws_has_room (DeepgramWS* self, gsize size)
 {
-  DeepgramWS* self = DEEPGRAM_WS (user_data);
+  guint length = deepgram_ring_length (self->audio_ring);
+  if (length >= deepgram_ring_capacity (self->audio_ring))
+    return FALSE;
+
+  guint64 max_bytes = atomic_load_explicit (&self->max_queue_bytes,
+                                            memory_order_relaxed);
+  if (max_bytes == 0 || length == 0)
+    return TRUE;
+
+  return atomic_load_explicit (&self->queued_bytes, memory_order_relaxed)
+             + size
+         <= max_bytes;
+}
 
-  GError*                  error = NULL;
-  SoupMessage*             msg   = NULL;
-  gchar*                   url   = NULL;
-  SoupWebsocketConnection* conn  = NULL;
+/* Schedules the pump on the worker; the lock keeps the source alive
+ * against a concurrent teardown. */
+static void
+deepgram_ws_schedule_pump (DeepgramWS* self)
+{
+  g_mutex_lock (&self->lock);
+  if (self->pump)
+    g_source_set_ready_time (self->pump, 0);
+  g_mutex_unlock (&self->lock);
+}
 
-  url = g_strdup_printf (
-      "wss://api.deepgram.com/v1/listen"
-      "?encoding=linear16&sample_rate=16000&channels=1&model=%s",
-      self->model ? self->model : "general");
+/* Wakes the pump if it went idle on an empty ring. Pairs with the
+ * sender_waiting store + fence in deepgram_ws_pump_idle(). */
+static void
+deepgram_ws_wake_sender (DeepgramWS* self)
+{
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load_explicit (&self->sender_waiting, memory_order_relaxed))
+    deepgram_ws_schedule_pump (self);
+}
+
+/* Wakes a producer blocked on a full queue. */
+static void
+deepgram_ws_wake_producer (DeepgramWS* self)
+{
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load_explicit (&self->producer_waiting, memory_order_relaxed))
+    {
+      g_mutex_lock (&self->lock);
+      g_cond_signal (&self->space_cond);
+      g_mutex_unlock (&self->lock);
+    }
+}
+
+/* Appends chunk to the spool and takes ownership of it. Fails, leaving the
+ * chunk to the ring and the leaky policy, if the write fails or there is no
+ * sender left to ever read it back. */
+static gboolean
+deepgram_ws_spill (DeepgramWS* self, GBytes* chunk)
+{
+  g_mutex_lock (&self->lock);
+  gboolean running = self->running;
+  g_mutex_unlock (&self->lock);
+  if (!running)
+    return FALSE;
+
+  gsize         size;
+  const guint8* data = g_bytes_get_data (chunk, &size);
+  if (!deepgram_spool_append (self->spool, data, size))
+    return FALSE;
+
+  g_bytes_unref (chunk);
+  atomic_fetch_add (&self->queued_end, size);
+  atomic_fetch_add_explicit (&self->chunks_pushed, 1, memory_order_relaxed);
+  deepgram_ws_wake_sender (self);
+
+  return TRUE;
+}
+
+/* Producer side, called from the streaming thread only. Takes ownership of
+ * chunk; copied tells whether the payload was duplicated on the way in.
+ * When the queue is full it goes to the spool if there is one; otherwise
+ * the leaky policy decides: block the caller until the sender makes room,
+ * drop the new chunk, or let the sender drop the oldest chunks (see
+ * deepgram_ws_pump()). */
+static GstFlowReturn
+deepgram_ws_enqueue (DeepgramWS* self, GBytes* chunk, gboolean copied)
+{
+  gsize   size       = g_bytes_get_size (chunk);
+  guint64 dropped    = 0;
+  guint64 removed    = 0;
+  guint64 removed_at = 0;
+  gint64  enqueued   = deepgram_monotonic_time ();
+
+  atomic_fetch_add_explicit (copied ? &self->chunks_copied
+                                    : &self->chunks_zero_copy,
+                             1, memory_order_relaxed);
+
+  if (self->spool
+      && (!deepgram_spool_is_empty (self->spool)
+          || !deepgram_ws_has_room (self, size))
+      && deepgram_ws_spill (self, chunk))
+    return GST_FLOW_OK;
+
+  while (chunk && !deepgram_ws_has_room (self, size))
+    {
+      gint leaky = atomic_load_explicit (&self->leaky, memory_order_relaxed);
+
+      if (leaky == DEEPGRAM_WS_LEAKY_DOWNSTREAM
+          && deepgram_ring_length (self->audio_ring)
+                 < deepgram_ring_capacity (self->audio_ring))
+        {
+          /* Over the byte limit, but the sender trims the head. */
+          break;
+        }
+
+      if (leaky != DEEPGRAM_WS_LEAKY_NO)
+        {
+          /* Never queued, so it is removed at the end of the queue. */
+          dropped    = size;
+          removed    = size;
+          removed_at = atomic_load (&self->queued_end);
+          g_bytes_unref (chunk);
+          chunk = NULL;
+          break;
+        }
+
+      g_mutex_lock (&self->lock);
+      if (self->flushing)
+        {
+          g_mutex_unlock (&self->lock);
+          g_bytes_unref (chunk);
+          return GST_FLOW_FLUSHING;
+        }
+
+      if (!self->running)
+        {
+          /* Without a sender there is nobody to make room; with the
+           * connection gone we are the only consumer, so drop old audio
+           * rather than blocking forever. */
+          GBytes* old = deepgram_ring_pop (self->audio_ring);
+          if (old)
+            {
+              self->ring_popped++;
+              atomic_fetch_add (&self->chunks_popped, 1);
+              gsize old_size = g_bytes_get_size (old);
+              if (removed == 0)
+                removed_at = atomic_load (&self->queued_end)
+                             - atomic_load (&self->queued_bytes);
+              atomic_fetch_sub (&self->queued_bytes, old_size);
+              atomic_fetch_sub (&self->queued_end, old_size);
+              dropped += old_size;
+              removed += old_size;
+              g_bytes_unref (old);
+            }
+          g_mutex_unlock (&self->lock);
+          continue;
+        }
+
+      atomic_store (&self->producer_waiting, TRUE);
+      atomic_thread_fence (memory_order_seq_cst);
+      if (!deepgram_ws_has_room (self, size))
+        g_cond_wait (&self->space_cond, &self->lock);
+      atomic_store (&self->producer_waiting, FALSE);
+      g_mutex_unlock (&self->lock);
+    }
+
+  if (removed > 0)
+    {
+      g_signal_emit (self, signals[SIGNAL_WS_AUDIO_REMOVED], 0, removed_at,
+                     removed);
+    }
+
+  if (chunk)
+    {
+      atomic_fetch_add (&self->queued_bytes, size);
+      atomic_fetch_add (&self->queued_end, size);
+      atomic_store_explicit (
+          &self->enqueue_times[self->ring_pushed++ % self->n_enqueue_times],
+          enqueued, memory_order_relaxed);
+      deepgram_ring_push (self->audio_ring, chunk);
+      atomic_fetch_add_explicit (&self->chunks_pushed, 1,
+                                 memory_order_relaxed);
+      deepgram_ws_wake_sender (self);
+    }
+
+  if (dropped > 0)
+    {
+      g_signal_emit (self, signals[SIGNAL_WS_AUDIO_DROPPED], 0, dropped);
+    }
+
+  return GST_FLOW_OK;
+}
+
+/* Called at end of stream, after the last audio has been queued: lets the
+ * sender put everything still queued on the wire, then send CloseStream,
+ * and waits until Deepgram has returned its final results (signalled by its
+ * trailing Metadata message or by closing the connection). Returns FALSE if
+ * that did not happen within timeout (ns). */
+gboolean
+deepgram_ws_drain (DeepgramWS* self, guint64 timeout)
+{
+  g_return_val_if_fail (DEEPGRAM_IS_WS (self), FALSE);
+
+  gint64 end_time = g_get_monotonic_time () + timeout / 1000;
+
+  g_mutex_lock (&self->lock);
+  if (!self->running)
+    {
+      g_mutex_unlock (&self->lock);
+      return FALSE;
+    }
+
+  atomic_store (&self->drain_requested, TRUE);
+  if (self->pump)
+    g_source_set_ready_time (self->pump, 0);
+
+  while (!self->stream_finished && self->running)
+    {
+      if (!g_cond_wait_until (&self->drain_cond, &self->lock, end_time))
+        break;
+    }
+
+  gboolean closed = self->stream_finished;
+  g_mutex_unlock (&self->lock);
+
+  return closed;
+}
+
+/* Producer side: once the audio queued so far is on the wire, ask Deepgram
+ * to return final results for it without waiting for more, e.g. when the
+ * speaker fell silent. The connection stays open. */
+void
+deepgram_ws_finalize (DeepgramWS* self)
+{
+  g_return_if_fail (DEEPGRAM_IS_WS (self));
+
+  atomic_store (&self->finalize_at, atomic_load (&self->chunks_pushed) + 1);
+  deepgram_ws_wake_sender (self);
+}
+
+/* Producer side (e.g. on FLUSH_STOP): forget everything queued so far,
+ * including a partially filled frame, without closing the connection. */
+void
+deepgram_ws_discard_queued (DeepgramWS* self)
+{
+  g_return_if_fail (DEEPGRAM_IS_WS (self));
+
+  atomic_store (&self->discard_until, atomic_load (&self->chunks_pushed));
+  deepgram_ws_wake_sender (self);
+}
+
+/* Whether the connection (or the attempt to open it) is still alive and
+ * has not been closed by an end-of-stream drain. */
+gboolean
+deepgram_ws_is_running (DeepgramWS* self)
+{
+  g_return_val_if_fail (DEEPGRAM_IS_WS (self), FALSE);
+
+  g_mutex_lock (&self->lock);
+  gboolean running = self->running && !self->stream_finished
+                     && !atomic_load (&self->drain_requested);
+  g_mutex_unlock (&self->lock);
+
+  return running;
+}
+
+static gint
+deepgram_compare_uint64 (gconstpointer a, gconstpointer b)
+{
+  guint64 x = *(const guint64*)a, y = *(const guint64*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* Median, 99th percentile and maximum of the enqueue-to-wire samples kept
+ * by the framer; all 0 before the first message. */
+static void
+deepgram_framer_get_wire_latency (DeepgramFramer* framer, guint64* p50,
+                                  guint64* p99, guint64* max)
+{
+  guint64 n = MIN (atomic_load (&framer->wire_samples),
+                   DEEPGRAM_FRAMER_WIRE_SAMPLES);
+  guint64 samples[DEEPGRAM_FRAMER_WIRE_SAMPLES];
+
+  *p50 = *p99 = *max = 0;
+  if (n == 0)
+    return;
+
+  for (guint64 i = 0; i < n; i++)
+    samples[i] = atomic_load_explicit (&framer->wire_latency[i],
+                                       memory_order_relaxed);
+  qsort (samples, n, sizeof (guint64), deepgram_compare_uint64);
+
+  *p50 = samples[n / 2];
+  *p99 = samples[MIN (n * 99 / 100, n - 1)];
+  *max = samples[n - 1];
+}
+
+/* Averages are per message; first-result-time is GST_CLOCK_TIME_NONE until
+ * Deepgram has answered. */
+GstStructure*
+deepgram_ws_get_stats (DeepgramWS* self)
+{
+  g_return_val_if_fail (DEEPGRAM_IS_WS (self), NULL);
+
+  g_mutex_lock (&self->lock);
+  guint rate = self->stats_rate;
+  g_mutex_unlock (&self->lock);
+
+  guint64 queued    = atomic_load (&self->queued_bytes);
+  guint64 frames    = atomic_load (&self->framer.frames_sent);
+  guint64 messages  = atomic_load (&self->messages_received);
+  guint64 send_time = atomic_load (&self->framer.send_time);
+  guint64 spooled
+      = self->spool ? deepgram_spool_get_pending (self->spool) : 0;
+  guint64 wire_p50, wire_p99, wire_max;
+  deepgram_framer_get_wire_latency (&self->framer, &wire_p50, &wire_p99,
+                                    &wire_max);
+
+  return gst_structure_new (
+      "deepgram-stats", "queued-bytes", G_TYPE_UINT64, queued, "queued-time",
+      G_TYPE_UINT64, gst_util_uint64_scale (queued, GST_SECOND, MAX (rate, 1)),
+      "spooled-bytes", G_TYPE_UINT64, spooled, "bytes-sent", G_TYPE_UINT64,
+      atomic_load (&self->framer.bytes_sent), "frames-sent", G_TYPE_UINT64,
+      frames, "send-time-avg", G_TYPE_UINT64,
+      frames > 0 ? send_time / frames : 0, "send-time-max", G_TYPE_UINT64,
+      atomic_load (&self->framer.send_time_max), "wire-latency-p50",
+      G_TYPE_UINT64, wire_p50, "wire-latency-p99", G_TYPE_UINT64, wire_p99,
+      "wire-latency-max", G_TYPE_UINT64, wire_max, "connect-time",
+      G_TYPE_UINT64, atomic_load (&self->connect_time), "first-result-time",
+      G_TYPE_UINT64, atomic_load (&self->first_result_time), "result-lag",
+      G_TYPE_UINT64, atomic_load (&self->result_lag), "result-lag-max",
+      G_TYPE_UINT64, atomic_load (&self->result_lag_max), "parse-time-avg",
+      G_TYPE_UINT64,
+      messages > 0 ? atomic_load (&self->parse_time) / messages : 0,
+      "messages-received", G_TYPE_UINT64, messages, "reconnects",
+      G_TYPE_UINT, atomic_load (&self->reconnects), "outage-time",
+      G_TYPE_UINT64, atomic_load (&self->outage_time), NULL);
+}
+
+GstFlowReturn
+deepgram_ws_push_audio (DeepgramWS* self, const guint8* data, gsize size)
+{
+  g_return_val_if_fail (DEEPGRAM_IS_WS (self), GST_FLOW_ERROR);
+
+  if (!data || size == 0)
+    return GST_FLOW_OK;
+
+  return deepgram_ws_enqueue (self, g_bytes_new (data, size), TRUE);
+}
+
+typedef struct
+{
+  GstBuffer* buffer;
+  GstMapInfo map;
+} DeepgramMappedBuffer;
+
+static void
+deepgram_mapped_buffer_free (gpointer user_data)
+{
+  DeepgramMappedBuffer* mb = (DeepgramMappedBuffer*)user_data;
+
+  gst_buffer_unmap (mb->buffer, &mb->map);
+  gst_buffer_unref (mb->buffer);
+  g_free (mb);
+}
+
+/* Queues the buffer's memory as-is: the returned GBytes points into the
+ * mapping and holds a ref on the buffer until the sender has handed the
+ * payload to soup_websocket_connection_send_binary(). A buffer spanning
+ * several memories is merged by the map, which counts as a copy. */
+GstFlowReturn
+deepgram_ws_push_buffer (DeepgramWS* self, GstBuffer* buffer)
+{
+  g_return_val_if_fail (DEEPGRAM_IS_WS (self), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
+
+  DeepgramMappedBuffer* mb = g_new (DeepgramMappedBuffer, 1);
+  mb->buffer               = gst_buffer_ref (buffer);
+
+  if (!gst_buffer_map (mb->buffer, &mb->map, GST_MAP_READ))
+    {
+      g_printerr ("[DeepgramWS] Failed to map buffer.\n");
+      gst_buffer_unref (mb->buffer);
+      g_free (mb);
+      return GST_FLOW_ERROR;
+    }
+
+  if (mb->map.size == 0)
+    {
+      deepgram_mapped_buffer_free (mb);
+      return GST_FLOW_OK;
+    }
+
+  gboolean copied = gst_buffer_n_memory (mb->buffer) > 1;
+  GBytes*  chunk  = g_bytes_new_with_free_func (
+      mb->map.data, mb->map.size, deepgram_mapped_buffer_free, mb);
+
+  return deepgram_ws_enqueue (self, chunk, copied);
+}
+
+static gboolean
+deepgram_ws_conn_writable (SoupWebsocketConnection* conn)
+{
+  GIOStream*     io  = soup_websocket_connection_get_io_stream (conn);
+  GOutputStream* out = io ? g_io_stream_get_output_stream (io) : NULL;
+
+  if (out && G_IS_POLLABLE_OUTPUT_STREAM (out))
+    return g_pollable_output_stream_is_writable (
+        G_POLLABLE_OUTPUT_STREAM (out));
+
+  return TRUE;
+}
+
+static void
+deepgram_replay_append (DeepgramReplay* replay, const guint8* data,
+                        gsize size)
+{
+  replay->end += size;
+  if (replay->capacity == 0)
+    return;
+
+  if (size > replay->capacity)
+    {
+      data += size - replay->capacity;
+      size = replay->capacity;
+    }
+
+  gsize pos   = (replay->end - size) % replay->capacity;
+  gsize first = MIN (size, replay->capacity - pos);
+  memcpy (replay->data + pos, data, first);
+  memcpy (replay->data, data + first, size - first);
+}
+
+/* Stream offset of the oldest byte still held. */
+static guint64
+deepgram_replay_first (DeepgramReplay* replay)
+{
+  return replay->end - MIN (replay->end, replay->capacity);
+}
+
+/* When the next chunk may be handed to the socket: now, or later if the
+ * socket is still busy or max_rate has been reached. libsoup queues whatever
+ * it cannot write without limit, so frames are only handed over while the
+ * socket accepts data; a stalled connection then backs up into the bounded
+ * audio queue, where max-queue-bytes applies. */
+static gint64
+deepgram_framer_next_send_time (DeepgramFramer* framer, gint64 now)
+{
+  SoupWebsocketConnection* conn = framer->conn;
+
+  if (soup_websocket_connection_get_state (conn) == SOUP_WEBSOCKET_STATE_OPEN
+      && !deepgram_ws_conn_writable (conn))
+    return now + DEEPGRAM_WS_WRITABLE_POLL_US;
+
+  if (framer->max_rate > 0 && framer->paced_bytes > 0)
+    {
+      gint64 due = framer->pace_start
+                   + (gint64)(framer->paced_bytes * G_USEC_PER_SEC
+                              / framer->max_rate);
+      if (now < due)
+        return due;
+    }
+
+  return now;
+}
+
+static gint64
+deepgram_thread_cpu_time (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (gint64)ts.tv_sec * GST_SECOND + ts.tv_nsec;
+}
+
+/* g_get_monotonic_time() in ns, for timing calls that take microseconds. */
+static gint64
+deepgram_monotonic_time (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * GST_SECOND + ts.tv_nsec;
+}
+
+/* enqueued is when the oldest audio in the message was queued, or 0 if it
+ * is not to be counted (replayed audio, the encoder's tail). */
+static void
+deepgram_framer_write (DeepgramFramer* framer, gconstpointer data, gsize size,
+                       gint64 enqueued)
+{
+  if (size == 0)
+    return;
+
+  gint64 start = deepgram_monotonic_time ();
+  soup_websocket_connection_send_binary (framer->conn, data, size);
+  guint64 took = deepgram_monotonic_time () - start;
+
+  if (enqueued > 0)
+    {
+      guint64 n = atomic_fetch_add (&framer->wire_samples, 1);
+      atomic_store_explicit (
+          &framer->wire_latency[n % DEEPGRAM_FRAMER_WIRE_SAMPLES],
+          (guint64)MAX (start - enqueued, 0), memory_order_relaxed);
+    }
+
+  /* Only the worker writes these, so no compare-and-swap is needed. */
+  if (atomic_fetch_add (&framer->frames_sent, 1) == 0)
+    framer->first_send = start;
+  atomic_fetch_add (&framer->send_time, took);
+  if (took > atomic_load (&framer->send_time_max))
+    atomic_store (&framer->send_time_max, took);
+
+  atomic_fetch_add (&framer->bytes_sent, size);
+  framer->last_send = g_get_monotonic_time ();
+
+  if (framer->record)
+    deepgram_session_log_write (framer->record, DEEPGRAM_SESSION_SENT_AUDIO,
+                                data, size);
+}
+
+/* For control messages; the caller checks the connection is open. */
+static void
+deepgram_framer_send_text (DeepgramFramer* framer, const gchar* text)
+{
+  soup_websocket_connection_send_text (framer->conn, text);
+
+  if (framer->record)
+    deepgram_session_log_write (framer->record, DEEPGRAM_SESSION_SENT_TEXT,
+                                text, strlen (text));
+}
+
+static void
+deepgram_framer_send (DeepgramFramer* framer, gconstpointer data, gsize size,
+                      gint64 enqueued)
+{
+  SoupWebsocketConnection* conn = framer->conn;
+
+  if (size == 0 || !conn)
+    return;
+
+  if (framer->max_rate > 0)
+    {
+      gint64 now = g_get_monotonic_time ();
+      gint64 due = framer->pace_start
+                   + (gint64)(framer->paced_bytes * G_USEC_PER_SEC
+                              / framer->max_rate);
+
+      /* Restart the schedule after an idle period instead of bursting to
+       * catch up. */
+      if (framer->paced_bytes == 0 || now > due + G_USEC_PER_SEC)
+        {
+          framer->pace_start  = now;
+          framer->paced_bytes = 0;
+        }
+      framer->paced_bytes += size;
+    }
+
+  if (soup_websocket_connection_get_state (conn) != SOUP_WEBSOCKET_STATE_OPEN)
+    return;
+
+  if (framer->encoder)
+    {
+      /* The encoder holds back less than a codec frame, so this may send
+       * nothing; the next frame catches up. */
+      gint64 start = deepgram_thread_cpu_time ();
+      data = deepgram_encoder_encode (framer->encoder, data, size, &size);
+      atomic_fetch_add (&framer->encode_time,
+                        deepgram_thread_cpu_time () - start);
+    }
+
+  deepgram_framer_write (framer, data, size, enqueued);
+}
+
+/* Encodes what the encoder still holds and ends the compressed stream, so
+ * the last words are not cut off. */
+static void
+deepgram_framer_finish (DeepgramFramer* framer)
+{
+  if (!framer->encoder
+      || soup_websocket_connection_get_state (framer->conn)
+             != SOUP_WEBSOCKET_STATE_OPEN)
+    return;
+
+  gsize         size;
+  gint64        start = deepgram_thread_cpu_time ();
+  const guint8* data  = deepgram_encoder_finish (framer->encoder, &size);
+  atomic_fetch_add (&framer->encode_time, deepgram_thread_cpu_time () - start);
+
+  deepgram_framer_write (framer, data, size, 0);
+}
+
+/* Keeps an idle connection from being closed by Deepgram. */
+static void
+deepgram_framer_keepalive (DeepgramFramer* framer)
+{
+  if (soup_websocket_connection_get_state (framer->conn)
+      == SOUP_WEBSOCKET_STATE_OPEN)
+    {
+      deepgram_framer_send_text (framer, DEEPGRAM_WS_KEEPALIVE);
+    }
+  framer->last_send = g_get_monotonic_time ();
+}
+
+/* Sends the partially filled staging frame, if any. */
+static void
+deepgram_framer_flush (DeepgramFramer* framer)
+{
+  deepgram_framer_send (framer, framer->staging, framer->staged,
+                        framer->staged_enqueued);
+  framer->staged = 0;
+}
+
+/* Whole frames are sent straight from the chunk's memory; only the bytes
+ * that straddle a frame boundary are copied into the staging frame. */
+static void
+deepgram_framer_push (DeepgramFramer* framer, const guint8* data, gsize size,
+                      gint64 enqueued)
+{
+  if (framer->frame_bytes == 0)
+    {
+      deepgram_framer_send (framer, data, size, enqueued);
+      return;
+    }
+
+  if (framer->staged > 0)
+    {
+      gsize take = MIN (framer->frame_bytes - framer->staged, size);
+      memcpy (framer->staging + framer->staged, data, take);
+      framer->staged += take;
+      data += take;
+      size -= take;
+
+      if (framer->staged < framer->frame_bytes)
+        return;
+
+      deepgram_framer_flush (framer);
+    }
+
+  while (size >= framer->frame_bytes)
+    {
+      deepgram_framer_send (framer, data, framer->frame_bytes, enqueued);
+      data += framer->frame_bytes;
+      size -= framer->frame_bytes;
+    }
+
+  if (size > 0)
+    {
+      memcpy (framer->staging, data, size);
+      framer->staged          = size;
+      framer->staged_since    = g_get_monotonic_time ();
+      framer->staged_enqueued = enqueued;
+    }
+}
+
+static gboolean
+deepgram_ws_append_query_param (GQuark field_id, const GValue* value,
+                                gpointer user_data)
+{
+  GString* url = (GString*)user_data;
+  gchar*   str;
+
+  if (G_VALUE_HOLDS_STRING (value))
+    str = g_value_dup_string (value);
+  else if (G_VALUE_HOLDS_BOOLEAN (value))
+    str = g_strdup (g_value_get_boolean (value) ? "true" : "false");
+  else
+    str = gst_value_serialize (value);
+
+  if (!str)
+    return TRUE;
+
+  gchar* escaped = g_uri_escape_string (str, NULL, FALSE);
+  g_string_append_printf (url, "&%s=%s", g_quark_to_string (field_id),
+                          escaped);
+  g_free (escaped);
+  g_free (str);
+
+  return TRUE;
+}
+
+/* Byte rate and frame size of linear16 at the sample_rate and channels
+ * announced in the URL; used to turn result times into stream offsets. */
+static void
+deepgram_ws_get_audio_format (DeepgramWS* self, guint* bytes_per_second,
+                              guint* block_align)
+{
+  gint rate     = 16000;
+  gint channels = self->channels;
+
+  if (self->query_params)
+    {
+      gst_structure_get_int (self->query_params, "sample_rate", &rate);
+      gst_structure_get_int (self->query_params, "channels", &channels);
+    }
+
+  *block_align      = MAX (channels, 1) * 2;
+  *bytes_per_second = MAX (rate, 1) * *block_align;
+}
+
+/* endpoint + the audio format the sink sends + model, followed by every
+ * field of query-params. Fields in query-params that repeat one of the
+ * built-in parameters replace it. */
+static gchar*
+deepgram_ws_build_url (DeepgramWS* self)
+{
+  GstStructure* params = gst_structure_new (
+      "params", "encoding", G_TYPE_STRING,
+      deepgram_encoding_get_name (self->encoding), "sample_rate",
+      G_TYPE_INT, 16000, "channels", G_TYPE_INT, self->channels, "model",
+      G_TYPE_STRING, self->model ? self->model : "general", NULL);
+  if (self->multichannel)
+    gst_structure_set (params, "multichannel", G_TYPE_BOOLEAN, TRUE, NULL);
+
+  if (self->query_params)
+    {
+      for (gint i = 0; i < gst_structure_n_fields (self->query_params); i++)
+        {
+          const gchar* name
+              = gst_structure_nth_field_name (self->query_params, i);
+          gst_structure_set_value (
+              params, name,
+              gst_structure_get_value (self->query_params, name));
+        }
+    }
+
+  GString* url = g_string_new (self->endpoint && *self->endpoint
+                                   ? self->endpoint
+                                   : DEEPGRAM_WS_DEFAULT_ENDPOINT);
+  gsize    query_start = url->len;
+  gboolean has_query   = strchr (url->str, '?') != NULL;
+
+  /* Every parameter is appended as "&key=value"; the first one starts the
+   * query string unless the endpoint already carries one. */
+  gst_structure_foreach (params, deepgram_ws_append_query_param, url);
+  if (url->len > query_start && !has_query)
+    url->str[query_start] = '?';
+
+  gst_structure_free (params);
+  return g_string_free (url, FALSE);
+}
+
+static void     deepgram_ws_schedule_reconnect (DeepgramWS* self);
+static gboolean deepgram_ws_attach_pump (DeepgramWS* self,
+                                         GSourceFunc pump_func,
+                                         guint64     stats_interval);
+
+/* Marks the stream as transcribed for good up to bytes, on every channel. */
+static void
+deepgram_ws_set_acked (DeepgramWS* self, guint64 bytes)
+{
+  self->acked_bytes = bytes;
+  for (guint i = 0; i < self->n_acked; i++)
+    self->channel_acked[i] = bytes;
+}
+
+/* A close we did not ask for, before Deepgram's final Metadata, is an
+ * outage: audio keeps queueing while the worker reconnects. */
+static void
+deepgram_ws_on_closed (SoupWebsocketConnection* conn, gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
+
+  g_mutex_lock (&self->lock);
+  gboolean reconnect = !self->stream_finished && self->max_reconnects > 0
+                       && !atomic_load (&self->stopping);
+  if (!reconnect)
+    {
+      self->stream_finished = TRUE;
+      g_cond_broadcast (&self->drain_cond);
+    }
+  g_mutex_unlock (&self->lock);
+
+  if (reconnect && !self->reconnecting)
+    {
+      g_printerr ("[DeepgramWS] Connection lost (%d), reconnecting.\n",
+                  soup_websocket_connection_get_close_code (conn));
+      self->reconnecting      = TRUE;
+      self->reconnect_attempt = 0;
+      self->outage_start      = g_get_monotonic_time ();
+      deepgram_ws_schedule_reconnect (self);
+    }
+}
+
+/* Runs on the worker once the connection is gone (or never came up): drops
+ * everything the worker owns, then lets deepgram_ws_stop() return. */
+static void
+deepgram_ws_teardown (DeepgramWS* self)
+{
+  SoupWebsocketConnection* conn = self->ws_conn;
+
+  /* Destroying the pump drops its reference on self. */
+  g_object_ref (self);
+
+  if (conn
+      && soup_websocket_connection_get_state (conn)
+             == SOUP_WEBSOCKET_STATE_OPEN)
+    {
+      soup_websocket_connection_close (conn, 1000, "Normal closure");
+    }
+
+  g_mutex_lock (&self->lock);
+  GSource* pump = self->pump;
+  self->pump    = NULL;
+  self->ws_conn = NULL;
+  g_mutex_unlock (&self->lock);
+
+  /* Invalidates reconnects still in flight. */
+  self->generation++;
+  self->reconnecting = FALSE;
+  if (self->reconnect_source)
+    {
+      g_source_destroy (self->reconnect_source);
+      g_clear_pointer (&self->reconnect_source, g_source_unref);
+    }
+
+  if (pump)
+    {
+      g_source_destroy (pump);
+      g_source_unref (pump);
+    }
+
+  if (self->stats_source)
+    {
+      g_source_destroy (self->stats_source);
+      g_clear_pointer (&self->stats_source, g_source_unref);
+    }
+
+  if (conn)
+    {
+      g_signal_handlers_disconnect_by_data (conn, self);
+      g_object_unref (conn);
+    }
+
+  if (self->encoder)
+    {
+      guint64 sent = atomic_load (&self->framer.bytes_sent);
+      g_print ("[DeepgramWS] Sent %" G_GUINT64_FORMAT " bytes of %s for %"
+               G_GUINT64_FORMAT " bytes of audio (%.1f%%), encoding took "
+               "%.1f ms of CPU.\n",
+               sent, deepgram_encoding_get_name (self->encoding),
+               self->replay.end,
+               self->replay.end ? 100.0 * sent / self->replay.end : 0.0,
+               atomic_load (&self->framer.encode_time) / 1e6);
+    }
+
+  g_clear_object (&self->msg);
+  g_clear_pointer (&self->framer.staging, g_free);
+  g_clear_pointer (&self->replay.data, g_free);
+  g_clear_pointer (&self->channel_acked, g_free);
+  g_clear_pointer (&self->http, deepgram_http_free);
+  g_clear_pointer (&self->encoder, deepgram_encoder_free);
+  g_clear_pointer (&self->record, deepgram_session_log_free);
+  self->framer.encoder = NULL;
+  self->framer.conn    = NULL;
+  self->framer.record  = NULL;
+
+  g_print ("[DeepgramWS] Connection released.\n");
+
+  g_mutex_lock (&self->lock);
+  DeepgramWorker* worker = self->pending_release;
+  self->pending_release  = NULL;
+  self->running          = FALSE;
+  g_cond_broadcast (&self->cond);
+  g_cond_broadcast (&self->space_cond);
+  g_cond_broadcast (&self->drain_cond);
+  g_mutex_unlock (&self->lock);
+
+  if (worker)
+    deepgram_pool_release (worker);
+
+  g_object_unref (self);
+}
+
+static gboolean
+deepgram_ws_pump_dispatch (GSource* source, GSourceFunc callback,
+                           gpointer user_data)
+{
+  return callback (user_data);
+}
+
+/* Never ready on its own: deepgram_ws_pump() arms it through
+ * g_source_set_ready_time(), producers through deepgram_ws_wake_sender(). */
+static GSourceFuncs deepgram_ws_pump_funcs = {
+  NULL, NULL, deepgram_ws_pump_dispatch, NULL, NULL, NULL,
+};
+
+static gboolean
+deepgram_ws_emit_stats (gpointer user_data)
+{
+  DeepgramWS*   self  = DEEPGRAM_WS (user_data);
+  GstStructure* stats = deepgram_ws_get_stats (self);
+
+  g_signal_emit (self, signals[SIGNAL_WS_STATS], 0, stats);
+  gst_structure_free (stats);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Starts a new connection in the session log, with its URL. */
+static void
+deepgram_ws_record_connected (DeepgramWS* self)
+{
+  if (!self->record)
+    return;
+
+  gchar* url = g_uri_to_string (soup_message_get_uri (self->msg));
+  deepgram_session_log_write (self->record, DEEPGRAM_SESSION_CONNECTED, url,
+                              strlen (url));
+  g_free (url);
+}
+
+static void
+deepgram_ws_connect_cb (GObject* source_object, GAsyncResult* res,
+                        gpointer user_data)
+{
+  DeepgramWS* self  = DEEPGRAM_WS (user_data);
+  GError*     error = NULL;
+
+  SoupWebsocketConnection* conn = soup_session_websocket_connect_finish (
+      SOUP_SESSION (source_object), res, &error);
+  if (!conn)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("[DeepgramWS] WebSocket connect error: %s\n",
+                    error ? error->message : "unknown");
+      g_clear_error (&error);
+      deepgram_ws_teardown (self);
+      g_object_unref (self);
+      return;
+    }
+
+  atomic_store (&self->connect_time,
+                deepgram_monotonic_time () - self->connect_start);
+
+  self->ws_conn = conn;
+  g_signal_connect (conn, "message", G_CALLBACK (deepgram_ws_on_message), self);
+  g_signal_connect (conn, "closed", G_CALLBACK (deepgram_ws_on_closed), self);
+
+  DeepgramFramer* framer = &self->framer;
+  framer->staged         = 0;
+  framer->staged_since   = 0;
+  framer->pace_start     = 0;
+  framer->paced_bytes    = 0;
+
+  g_mutex_lock (&self->lock);
+  framer->encoder      = self->encoder;
+  framer->conn         = conn;
+  framer->frame_bytes  = self->frame_bytes;
+  framer->max_delay_us = self->max_frame_delay / 1000;
+  framer->max_rate     = self->max_send_rate;
+  framer->keepalive_us = self->keepalive_interval / 1000;
+  framer->last_send    = g_get_monotonic_time ();
+  framer->record       = self->record;
+
+  guint64 stats_interval = self->stats_interval;
+  g_mutex_unlock (&self->lock);
+
+  deepgram_ws_record_connected (self);
+  if (framer->frame_bytes > 0)
+    framer->staging = g_malloc (framer->frame_bytes);
+
+  deepgram_ws_get_audio_format (self, &self->bytes_per_second,
+                                &self->block_align);
+
+  /* Whole frames only, so a replay never starts mid-sample. */
+  g_mutex_lock (&self->lock);
+  self->replay.capacity
+      = self->replay_bytes - self->replay_bytes % self->block_align;
+  g_mutex_unlock (&self->lock);
+  self->replay.end    = 0;
+  self->replay.data   = self->replay.capacity > 0
+                            ? g_malloc (self->replay.capacity)
+                            : NULL;
+  self->n_acked       = self->multichannel ? self->block_align / 2 : 1;
+  self->channel_acked = g_new0 (guint64, self->n_acked);
+  self->session_base  = 0;
+  deepgram_ws_set_acked (self, 0);
+
+  self->discarded = atomic_load (&self->discard_until);
+
+  if (deepgram_ws_attach_pump (self, deepgram_ws_pump, stats_interval))
+    g_print ("[DeepgramWS] WebSocket connected.\n");
+  else
+    deepgram_ws_teardown (self);
+
+  g_object_unref (self);
+}
+
+/* Starts the pump and the stats timer on the worker; FALSE if
+ * deepgram_ws_stop() got in first, in which case the caller tears down. */
+static gboolean
+deepgram_ws_attach_pump (DeepgramWS* self, GSourceFunc pump_func,
+                         guint64 stats_interval)
+{
+  GSource* pump = g_source_new (&deepgram_ws_pump_funcs, sizeof (GSource));
+  g_source_set_name (pump, "DeepgramWS pump");
+  g_source_set_callback (pump, pump_func, g_object_ref (self),
+                         g_object_unref);
+  g_source_set_ready_time (pump, 0);
+
+  /* Publish the pump unless deepgram_ws_stop() got in first; it only
+   * cancels a connection that has no pump yet. */
+  g_mutex_lock (&self->lock);
+  gboolean stopping = atomic_load (&self->stopping);
+  if (!stopping)
+    {
+      self->pump = pump;
+      g_source_attach (pump, g_main_context_get_thread_default ());
+    }
+  g_mutex_unlock (&self->lock);
+
+  /* Destroyed by deepgram_ws_teardown() on this worker, so it needs no
+   * reference of its own. */
+  if (!stopping && stats_interval > 0)
+    {
+      self->stats_source
+          = g_timeout_source_new (MAX (stats_interval / GST_MSECOND, 1));
+      g_source_set_name (self->stats_source, "DeepgramWS stats");
+      g_source_set_callback (self->stats_source, deepgram_ws_emit_stats, self,
+                             NULL);
+      g_source_attach (self->stats_source,
+                       g_main_context_get_thread_default ());
+    }
+
+  if (stopping)
+    g_source_unref (pump);
+
+  return !stopping;
+}
+
+static void deepgram_ws_open_http (DeepgramWS* self);
+
+/* Runs on the worker, which has pushed its context as the thread-default,
+ * so the connection and its signals are bound to that context. */
+static gboolean
+deepgram_ws_connect (gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
 
-  msg = soup_message_new (SOUP_METHOD_GET, url);
-  if (!msg)
+  if (atomic_load (&self->stopping))
     {
-      g_printerr ("[DeepgramWS] Failed to create SoupMessage.\n");
-      goto done;
+      deepgram_ws_teardown (self);
+      return G_SOURCE_REMOVE;
     }
 
-  {
-    SoupMessageHeaders* headers  = soup_message_get_request_headers (msg);
-    gchar*              auth_val = g_strdup_printf ("Token %s", self->api_key);
-    soup_message_headers_append (headers, "Authorization", auth_val);
-    g_free (auth_val);
-  }
+  if (self->transport == DEEPGRAM_WS_TRANSPORT_HTTP)
+    {
+      deepgram_ws_open_http (self);
+      return G_SOURCE_REMOVE;
+    }
 
-  g_print ("[DeepgramWS] Connecting to: %s\n", url);
+  self->connect_start = deepgram_monotonic_time ();
+  soup_session_websocket_connect_async (
+      deepgram_worker_get_session (self->worker), self->msg, NULL, NULL,
+      G_PRIORITY_DEFAULT, self->cancellable, deepgram_ws_connect_cb,
+      g_object_ref (self));
 
-  conn = deepgram_ws_connect_sync (self->soup_session, msg, NULL, NULL, &error);
-  if (!conn)
+  return G_SOURCE_REMOVE;
+}
+
+typedef struct
+{
+  DeepgramWS* ws;
+  guint       generation;
+} DeepgramReconnect;
+
+/* Installs the new connection and replays the audio Deepgram had not
+ * returned final results for, so nothing falls into the outage. Results of
+ * the new session are shifted by the replay start (see session_base). */
+static void
+deepgram_ws_resume (DeepgramWS* self, SoupWebsocketConnection* conn)
+{
+  DeepgramFramer*          framer = &self->framer;
+  SoupWebsocketConnection* old    = self->ws_conn;
+
+  g_signal_handlers_disconnect_by_data (old, self);
+  g_object_unref (old);
+
+  atomic_store (&self->connect_time,
+                deepgram_monotonic_time () - self->connect_start);
+
+  self->ws_conn = conn;
+  g_signal_connect (conn, "message", G_CALLBACK (deepgram_ws_on_message), self);
+  g_signal_connect (conn, "closed", G_CALLBACK (deepgram_ws_on_closed), self);
+
+  framer->conn        = conn;
+  framer->staged      = 0;
+  framer->paced_bytes = 0;
+  framer->last_send   = g_get_monotonic_time ();
+  deepgram_ws_record_connected (self);
+
+  /* A new session needs a new compressed stream, headers first. */
+  if (framer->encoder)
+    deepgram_encoder_reset (framer->encoder);
+
+  guint64 from
+      = MAX (self->acked_bytes, deepgram_replay_first (&self->replay));
+  guint64 replayed = self->replay.end - from;
+  if (from > self->acked_bytes)
+    g_printerr ("[DeepgramWS] Replay buffer too small, %" G_GUINT64_FORMAT
+                " bytes of audio lost.\n",
+                from - self->acked_bytes);
+
+  self->session_base = from;
+  while (from < self->replay.end)
     {
-      g_printerr ("[DeepgramWS] WebSocket connect error: %s\n",
-                  error ? error->message : "unknown");
-      if (error)
-        {
-          g_error_free (error);
-          error = NULL;
-        }
-      goto done;
+      gsize pos  = from % self->replay.capacity;
+      gsize size = MIN (self->replay.end - from, self->replay.capacity - pos);
+      deepgram_framer_push (framer, self->replay.data + pos, size, 0);
+      from += size;
     }
 
+  gint64 outage_us = g_get_monotonic_time () - self->outage_start;
+  guint  attempts  = self->reconnect_attempt + 1;
+  atomic_fetch_add (&self->reconnects, 1);
+  atomic_fetch_add (&self->outage_time, (guint64)outage_us * 1000);
+
+  self->reconnecting      = FALSE;
+  self->reconnect_attempt = 0;
+
   g_mutex_lock (&self->lock);
-  self->ws_conn = conn;
+  /* CloseStream went to the old session; send it again after the replay. */
+  self->drained = FALSE;
   g_mutex_unlock (&self->lock);
 
-  g_signal_connect (conn, "message", G_CALLBACK (deepgram_ws_on_message), self);
+  g_print ("[DeepgramWS] Reconnected after %.2f s, replaying %" G_GUINT64_FORMAT
+           " bytes.\n",
+           outage_us / (gdouble)G_USEC_PER_SEC, replayed);
+
+  g_signal_emit (self, signals[SIGNAL_WS_RECONNECTED], 0, attempts,
+                 (guint64)outage_us * 1000, replayed);
+
+  g_source_set_ready_time (self->pump, 0);
+}
+
+static void
+deepgram_ws_reconnect_cb (GObject* source_object, GAsyncResult* res,
+                          gpointer user_data)
+{
+  DeepgramReconnect* rc    = (DeepgramReconnect*)user_data;
+  DeepgramWS*        self  = rc->ws;
+  GError*            error = NULL;
 
-  g_print ("[DeepgramWS] WebSocket connected.\n");
+  SoupWebsocketConnection* conn = soup_session_websocket_connect_finish (
+      SOUP_SESSION (source_object), res, &error);
 
-  while (TRUE)
+  if (rc->generation != self->generation || atomic_load (&self->stopping))
     {
-      g_mutex_lock (&self->lock);
-      if (self->stop_thread)
+      /* Torn down meanwhile. */
+      if (conn)
         {
-          g_mutex_unlock (&self->lock);
-          break;
+          soup_websocket_connection_close (conn, 1000, "Normal closure");
+          g_object_unref (conn);
         }
+    }
+  else if (conn)
+    {
+      deepgram_ws_resume (self, conn);
+    }
+  else
+    {
+      self->reconnect_attempt++;
+      g_printerr ("[DeepgramWS] Reconnect attempt %u failed: %s\n",
+                  self->reconnect_attempt, error ? error->message : "unknown");
 
-      GBytes* chunk = NULL;
-      if (!g_queue_is_empty (self->audio_queue))
+      g_mutex_lock (&self->lock);
+      gboolean give_up = self->reconnect_attempt >= self->max_reconnects;
+      if (give_up)
         {
-          chunk = g_queue_pop_head (self->audio_queue);
+          self->stream_finished = TRUE;
+          g_cond_broadcast (&self->drain_cond);
         }
       g_mutex_unlock (&self->lock);
 
-      if (chunk)
+      if (give_up)
         {
-          gsize         size = 0;
-          gconstpointer data = g_bytes_get_data (chunk, &size);
-          if (size > 0 && conn)
-            {
-              soup_websocket_connection_send_binary (conn, data, size);
-            }
-          g_bytes_unref (chunk);
+          /* Back to the old behaviour: audio is discarded on the dead
+           * connection instead of piling up. */
+          g_printerr ("[DeepgramWS] Giving up after %u attempts.\n",
+                      self->reconnect_attempt);
+          self->reconnecting = FALSE;
+          g_source_set_ready_time (self->pump, 0);
         }
       else
         {
-          g_usleep (100000);
+          deepgram_ws_schedule_reconnect (self);
         }
     }
 
-  if (conn
-      && soup_websocket_connection_get_state (conn)
-             == SOUP_WEBSOCKET_STATE_OPEN)
+  g_clear_error (&error);
+  g_object_unref (self);
+  g_free (rc);
+}
+
+static gboolean
+deepgram_ws_reconnect (gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
+
+  g_clear_pointer (&self->reconnect_source, g_source_unref);
+  if (atomic_load (&self->stopping))
+    return G_SOURCE_REMOVE;
+
+  SoupMessage* msg = deepgram_ws_new_message (self);
+  if (!msg)
+    return G_SOURCE_REMOVE;
+
+  g_clear_object (&self->msg);
+  self->msg = msg;
+
+  DeepgramReconnect* rc = g_new (DeepgramReconnect, 1);
+  rc->ws                = g_object_ref (self);
+  rc->generation        = self->generation;
+
+  self->connect_start = deepgram_monotonic_time ();
+  soup_session_websocket_connect_async (
+      deepgram_worker_get_session (self->worker), msg, NULL, NULL,
+      G_PRIORITY_DEFAULT, self->cancellable, deepgram_ws_reconnect_cb, rc);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+deepgram_ws_schedule_reconnect (DeepgramWS* self)
+{
+  guint delay_ms = DEEPGRAM_WS_RECONNECT_MIN_MS
+                   << MIN (self->reconnect_attempt, 8);
+
+  self->reconnect_source
+      = g_timeout_source_new (MIN (delay_ms, DEEPGRAM_WS_RECONNECT_MAX_MS));
+  g_source_set_callback (self->reconnect_source, deepgram_ws_reconnect, self,
+                         NULL);
+  g_source_attach (self->reconnect_source, g_main_context_get_thread_default ());
+}
+
+/* Ring first: anything spooled is newer than what is in the ring. enqueued
+ * is set to when a chunk from the ring was queued, 0 for spooled ones. */
+static GBytes*
+deepgram_ws_pop_chunk (DeepgramWS* self, gboolean* spooled, gint64* enqueued)
+{
+  GBytes* chunk = deepgram_ring_pop (self->audio_ring);
+
+  *spooled  = FALSE;
+  *enqueued = 0;
+  if (chunk)
     {
-      soup_websocket_connection_close (conn, 1000, "Normal closure");
+      *enqueued = atomic_load_explicit (
+          &self->enqueue_times[self->ring_popped++ % self->n_enqueue_times],
+          memory_order_relaxed);
+    }
+  else if (self->spool)
+    {
+      chunk    = deepgram_spool_pop (self->spool);
+      *spooled = chunk != NULL;
     }
 
-done:
-  g_clear_object (&msg);
-  g_free (url);
+  return chunk;
+}
 
-  g_mutex_lock (&self->lock);
-  self->ws_conn = NULL;
-  g_mutex_unlock (&self->lock);
+static gboolean
+deepgram_ws_has_queued (DeepgramWS* self)
+{
+  return deepgram_ring_length (self->audio_ring) > 0
+         || (self->spool && !deepgram_spool_is_empty (self->spool));
+}
+
+/* Pops the next chunk to send, skipping what must not go out: chunks queued
+ * before a flush, the empty chunks the spool returns for audio it lost (an
+ * empty binary message would end the stream) and, with leaky=downstream,
+ * the head of a backlog over max-queue-bytes. NULL once the queue is
+ * empty; enqueued is as for deepgram_ws_pop_chunk(). */
+static GBytes*
+deepgram_ws_pop_sendable (DeepgramWS* self, gint64* enqueued)
+{
+  gboolean spooled;
+  GBytes*  chunk;
+  guint64  removed = 0;
+  guint64  dropped = 0;
+
+  while ((chunk = deepgram_ws_pop_chunk (self, &spooled, enqueued)))
+    {
+      /* Spooled audio is not counted in queued_bytes and never trimmed. */
+      gsize   size  = g_bytes_get_size (chunk);
+      guint64 total
+          = spooled ? 0 : atomic_fetch_sub (&self->queued_bytes, size);
+      guint64 seq = atomic_fetch_add (&self->chunks_popped, 1) + 1;
+      deepgram_ws_wake_producer (self);
+
+      if (seq <= atomic_load (&self->discard_until) || size == 0)
+        {
+          removed += size;
+          g_bytes_unref (chunk);
+          continue;
+        }
+
+      guint64 max_bytes = atomic_load (&self->max_queue_bytes);
+      if (atomic_load (&self->leaky) == DEEPGRAM_WS_LEAKY_DOWNSTREAM
+          && max_bytes > 0 && total > max_bytes)
+        {
+          /* Drop from the head until the backlog fits the limit again. */
+          removed += size;
+          dropped += size;
+          g_bytes_unref (chunk);
+          continue;
+        }
+
+      break;
+    }
+
+  /* Whatever was skipped sat right after what the stream holds so far;
+   * reported once per call, so an outage's backlog is not announced chunk
+   * by chunk. */
+  if (removed > 0)
+    {
+      atomic_fetch_sub (&self->queued_end, removed);
+      g_signal_emit (self, signals[SIGNAL_WS_AUDIO_REMOVED], 0,
+                     self->replay.end, removed);
+    }
+  if (dropped > 0)
+    g_signal_emit (self, signals[SIGNAL_WS_AUDIO_DROPPED], 0, dropped);
+
+  return chunk;
+}
+
+/* The queue is empty: flush an overdue partial frame, keep the connection
+ * alive, finish a drain, then re-arm the pump for the next deadline. */
+static void
+deepgram_ws_pump_idle (DeepgramWS* self, gint64 now)
+{
+  DeepgramFramer* framer   = &self->framer;
+  gboolean        draining = atomic_load (&self->drain_requested);
+
+  if (framer->staged > 0
+      && (draining || now >= framer->staged_since + framer->max_delay_us))
+    {
+      deepgram_framer_flush (framer);
+    }
+
+  guint64 finalize_at = atomic_load (&self->finalize_at);
+  if (finalize_at != self->finalized && !draining
+      && atomic_load (&self->chunks_popped) + 1 >= finalize_at)
+    {
+      /* The audio queued before the request is on the wire. */
+      deepgram_framer_flush (framer);
+      if (soup_websocket_connection_get_state (framer->conn)
+          == SOUP_WEBSOCKET_STATE_OPEN)
+        deepgram_framer_send_text (framer, DEEPGRAM_WS_FINALIZE);
+      framer->last_send = now;
+      self->finalized   = finalize_at;
+    }
+
+  if (framer->keepalive_us > 0 && !draining
+      && now >= framer->last_send + framer->keepalive_us)
+    {
+      deepgram_framer_keepalive (framer);
+    }
+
+  if (draining && !self->drained)
+    {
+      /* Everything queued is on the wire; ask for the final results. */
+      deepgram_framer_finish (framer);
+      if (soup_websocket_connection_get_state (framer->conn)
+          == SOUP_WEBSOCKET_STATE_OPEN)
+        deepgram_framer_send_text (framer, DEEPGRAM_WS_CLOSE_STREAM);
+      g_mutex_lock (&self->lock);
+      self->drained = TRUE;
+      g_cond_broadcast (&self->drain_cond);
+      g_mutex_unlock (&self->lock);
+    }
+
+  /* Sleep until a producer, deepgram_ws_drain() or deepgram_ws_stop()
+   * wakes us, so a chunk goes out as soon as it is queued. A partial frame
+   * bounds the sleep by max-frame-delay, and an idle connection by
+   * keepalive-interval. */
+  gint64 wake_at = -1;
+  if (framer->staged > 0)
+    wake_at = framer->staged_since + framer->max_delay_us;
+  if (framer->keepalive_us > 0 && !draining)
+    {
+      gint64 idle_end = framer->last_send + framer->keepalive_us;
+      wake_at         = wake_at < 0 ? idle_end : MIN (wake_at, idle_end);
+    }
+
+  guint64 poll_interval = atomic_load (&self->poll_interval);
+  if (poll_interval > 0)
+    {
+      /* Benchmark baseline: sleep a fixed interval without asking to be
+       * woken; deepgram_ws_stop() still wakes us. */
+      gint64 poll_at = now + (gint64)(poll_interval / 1000);
+      g_source_set_ready_time (self->pump,
+                               wake_at < 0 ? poll_at : MIN (wake_at, poll_at));
+      return;
+    }
+  g_source_set_ready_time (self->pump, wake_at);
+
+  atomic_store (&self->sender_waiting, TRUE);
+  atomic_thread_fence (memory_order_seq_cst);
+  if (deepgram_ws_has_queued (self)
+      || atomic_load (&self->discard_until) != self->discarded
+      || atomic_load (&self->finalize_at) != self->finalized
+      || (atomic_load (&self->drain_requested) && !self->drained)
+      || atomic_load (&self->stopping))
+    {
+      g_source_set_ready_time (self->pump, 0);
+    }
+}
+
+/* Sender side, dispatched on the worker: moves queued audio onto the
+ * socket without ever blocking the worker. Waits for the socket or the
+ * rate limit are expressed as the pump's next ready time. */
+static gboolean
+deepgram_ws_pump (gpointer user_data)
+{
+  DeepgramWS*     self   = DEEPGRAM_WS (user_data);
+  DeepgramFramer* framer = &self->framer;
+
+  if (atomic_load (&self->stopping))
+    {
+      deepgram_ws_teardown (self);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (self->reconnecting)
+    {
+      /* Audio stays queued until deepgram_ws_resume(). */
+      g_source_set_ready_time (self->pump, -1);
+      return G_SOURCE_CONTINUE;
+    }
+
+  atomic_store (&self->sender_waiting, FALSE);
+
+  for (guint n = 0; n < DEEPGRAM_WS_PUMP_BUDGET; n++)
+    {
+      guint64 discard_until = atomic_load (&self->discard_until);
+      if (discard_until != self->discarded)
+        {
+          /* A flush happened; the partial frame and anything kept for
+           * replay are stale too. The partial frame never went out, so it
+           * leaves the stream again. */
+          guint64 staged = framer->staged;
+          framer->staged = 0;
+          self->replay.end -= staged;
+          self->discarded = discard_until;
+          deepgram_ws_set_acked (self, self->replay.end);
+          if (staged > 0)
+            {
+              atomic_fetch_sub (&self->queued_end, staged);
+              g_signal_emit (self, signals[SIGNAL_WS_AUDIO_REMOVED], 0,
+                             self->replay.end, staged);
+            }
+        }
+
+      gint64 now     = g_get_monotonic_time ();
+      gint64 send_at = deepgram_framer_next_send_time (framer, now);
+      if (send_at > now && deepgram_ws_has_queued (self))
+        {
+          g_source_set_ready_time (self->pump, send_at);
+          return G_SOURCE_CONTINUE;
+        }
+
+      gint64  enqueued;
+      GBytes* chunk = deepgram_ws_pop_sendable (self, &enqueued);
+      if (!chunk)
+        {
+          deepgram_ws_pump_idle (self, now);
+          return G_SOURCE_CONTINUE;
+        }
+
+      gsize         size;
+      const guint8* data = g_bytes_get_data (chunk, &size);
+      deepgram_replay_append (&self->replay, data, size);
+      deepgram_framer_push (framer, data, size, enqueued);
+      g_bytes_unref (chunk);
+    }
+
+  /* Budget used up: let the worker's other connections run first. */
+  g_source_set_ready_time (self->pump, 0);
+  return G_SOURCE_CONTINUE;
+}
+
+/* Time from the first audio sent to the first result, and how far results
+ * trail the audio: what is on the wire minus the end of what the result
+ * covers, both on the stream's timeline. */
+static void
+deepgram_ws_update_result_stats (DeepgramWS* self, DeepgramResult* result,
+                                 gdouble offset, gint64 now)
+{
+  DeepgramFramer* framer = &self->framer;
+
+  if (atomic_load (&self->first_result_time) == GST_CLOCK_TIME_NONE
+      && atomic_load (&framer->frames_sent) > 0)
+    atomic_store (&self->first_result_time, now - framer->first_send);
+
+  if (!result->has_range)
+    return;
+
+  gdouble sent = (gdouble)(self->replay.end - framer->staged)
+                 / self->bytes_per_second;
+  gdouble end = offset + result->start + result->duration;
+  guint64 lag = sent > end ? (guint64)((sent - end) * GST_SECOND) : 0;
 
-  g_print ("[DeepgramWS] ws_thread exiting.\n");
-  return NULL;
+  atomic_store (&self->result_lag, lag);
+  if (lag > atomic_load (&self->result_lag_max))
+    atomic_store (&self->result_lag_max, lag);
 }
 
+static void deepgram_ws_emit_result (DeepgramWS* self, DeepgramResult* result,
+                                     gdouble offset, gint64 now);
+
 static void
 deepgram_ws_on_message (SoupWebsocketConnection* conn, gint type,
                         GBytes* message, gpointer user_data)
@@ -412,128 +2732,329 @@ deepgram_ws_on_message (SoupWebsocketConnection* conn, gint type,
 
   g_debug ("[DeepgramWS] Raw message:\n%.*s\n", (int)size, (const char*)data);
 
-  JsonParser* parser = json_parser_new ();
-  GError*     error  = NULL;
+  if (self->record)
+    deepgram_session_log_write (self->record, DEEPGRAM_SESSION_RECEIVED, data,
+                                size);
+
+  /* The streaming parser handles everything Deepgram normally sends;
+   * json-glib is only used for what it rejects, to report errors and to
+   * tolerate unusual value types as before. */
+  DeepgramResult* result      = self->result;
+  gint64          parse_start = deepgram_monotonic_time ();
+  gboolean        parsed      = deepgram_result_parse (result, data, size);
+  GError*         error       = NULL;
 
-  if (!json_parser_load_from_data (parser, data, size, &error))
+  if (!parsed)
+    parsed = deepgram_result_parse_json_glib (result, data, size, &error);
+
+  gint64 now = deepgram_monotonic_time ();
+  atomic_fetch_add (&self->parse_time, now - parse_start);
+  atomic_fetch_add (&self->messages_received, 1);
+
+  if (!parsed)
     {
       g_printerr ("[DeepgramWS] JSON parse error: %s\n",
                   error ? error->message : "unknown");
-      if (error)
-        {
-          g_error_free (error);
-          error = NULL;
-        }
-      g_object_unref (parser);
+      g_clear_error (&error);
       return;
     }
 
-  JsonNode* root = json_parser_get_root (parser);
+  if (result->type == DEEPGRAM_RESULT_METADATA)
+    {
+      /* Deepgram's last message after CloseStream, following the final
+       * results. */
+      g_mutex_lock (&self->lock);
+      self->stream_finished = TRUE;
+      g_cond_broadcast (&self->drain_cond);
+      g_mutex_unlock (&self->lock);
+      return;
+    }
 
-  JsonObject* root_obj = json_node_get_object (root);
+  /* Times are relative to the start of the current session, which began
+   * session_base bytes into the stream. */
+  deepgram_ws_emit_result (
+      self, result, (gdouble)self->session_base / self->bytes_per_second,
+      now);
+}
 
-  if (!json_object_has_member (root_obj, "channel"))
+/* Hands a result out through the signals, its times shifted by offset (s)
+ * onto the stream's timeline. */
+static void
+deepgram_ws_emit_result (DeepgramWS* self, DeepgramResult* result,
+                         gdouble offset, gint64 now)
+{
+  if (result->type == DEEPGRAM_RESULT_RESULTS)
+    deepgram_ws_update_result_stats (self, result, offset, now);
+
+  /* Per-word emission costs a marshal per word on every interim update;
+   * skip it unless somebody listens. */
+  gboolean emit_word
+      = g_signal_has_handler_pending (self, signals[SIGNAL_WS_WORD], 0, FALSE);
+
+  gdouble  transcript_start_time = 0.0;
+  gdouble  transcript_end_time   = 0.0;
+  gboolean has_start_time        = FALSE;
+  for (guint i = 0; i < result->words->len; i++)
     {
-      g_object_unref (parser);
-      return;
+      DeepgramWord* word
+          = &g_array_index (result->words, DeepgramWord, i);
+
+      /* Shifted in place, so "words" hands out the result's own array. */
+      word->start += offset;
+      word->end += offset;
+
+      if (!has_start_time)
+        {
+          has_start_time        = TRUE;
+          transcript_start_time = word->start;
+        }
+      if (word->end > transcript_end_time)
+        {
+          transcript_end_time = word->end;
+        }
+
+      if (emit_word && word->text && *word->text)
+        {
+          g_signal_emit (self, signals[SIGNAL_WS_WORD], 0, word->text,
+                         word->start, word->end, word->confidence,
+                         result->channel);
+        }
     }
 
-  JsonObject* channel_obj = json_object_get_object_member (root_obj, "channel");
-  if (!channel_obj)
+  if (result->words->len > 0)
     {
-      g_object_unref (parser);
-      return;
+      g_signal_emit (self, signals[SIGNAL_WS_WORDS], 0, result->words,
+                     result->is_final, result->channel);
     }
 
-  if (!json_object_has_member (channel_obj, "alternatives"))
+  /* A final result covers [start, start + duration) for good; audio up to
+   * there need not be replayed after a reconnect. offset puts it on the
+   * stream's timeline: the session's base, or an HTTP chunk's start. */
+  if (result->is_final && result->has_range)
     {
-      g_object_unref (parser);
-      return;
+      gdouble end   = offset + result->start + result->duration;
+      guint64 acked = (guint64)(end * self->bytes_per_second + 0.5);
+      acked -= acked % self->block_align;
+
+      /* With multichannel each channel is finalised on its own; the
+       * stream is only done up to where all of them are. */
+      guint channel = MIN (result->channel, self->n_acked - 1);
+      self->channel_acked[channel]
+          = MAX (self->channel_acked[channel], acked);
+      for (guint i = 0; i < self->n_acked; i++)
+        acked = MIN (acked, self->channel_acked[i]);
+      self->acked_bytes = MAX (self->acked_bytes, acked);
     }
 
-  JsonArray* alt_arr
-      = json_object_get_array_member (channel_obj, "alternatives");
-  if (!alt_arr || json_array_get_length (alt_arr) == 0)
+  const gchar* transcript = result->transcript;
+  if (transcript && *transcript)
     {
-      g_object_unref (parser);
-      return;
+      if (!self->silent)
+        {
+          g_print ("[DeepgramWS] => %s: %s\n",
+                   result->is_final ? "Final" : "Partial", transcript);
+        }
+      g_signal_emit (self, signals[SIGNAL_WS_TRANSCRIPT], 0, transcript,
+                     result->is_final, transcript_start_time,
+                     transcript_end_time, result->channel);
+    }
+}
+
+/* transport=http: a chunk's results arrive once, final, in stream order. */
+static void
+deepgram_ws_on_http_result (DeepgramResult* result, gdouble offset,
+                            gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
+
+  atomic_fetch_add (&self->messages_received, 1);
+  deepgram_ws_emit_result (self, result, offset, deepgram_monotonic_time ());
+}
+
+/* An upload counts as a frame, its round trip as its send time. */
+static void
+deepgram_ws_on_http_uploaded (gsize size, guint64 time, gboolean ok,
+                              gpointer user_data)
+{
+  DeepgramWS*     self   = DEEPGRAM_WS (user_data);
+  DeepgramFramer* framer = &self->framer;
+
+  atomic_fetch_add (&framer->frames_sent, 1);
+  atomic_fetch_add (&framer->bytes_sent, size);
+  atomic_fetch_add (&framer->send_time, time);
+  if (time > atomic_load (&framer->send_time_max))
+    atomic_store (&framer->send_time_max, time);
+
+  /* There is room for another chunk, or a drain may be complete. */
+  if (self->pump)
+    g_source_set_ready_time (self->pump, 0);
+}
+
+static void
+deepgram_ws_on_http_failed (gdouble start, gdouble duration,
+                            gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
+
+  g_signal_emit (self, signals[SIGNAL_WS_CHUNK_FAILED], 0, start, duration);
+}
+
+static const DeepgramHttpCallbacks deepgram_ws_http_callbacks = {
+  deepgram_ws_on_http_result,
+  deepgram_ws_on_http_uploaded,
+  deepgram_ws_on_http_failed,
+};
+
+/* The queue is empty: finish a drain once everything has been answered,
+ * then sleep until there is more to do. Finalize needs nothing, since the
+ * chunks end at quiet points and every answer is final. */
+static void
+deepgram_ws_http_idle (DeepgramWS* self)
+{
+  self->finalized = atomic_load (&self->finalize_at);
+
+  if (atomic_load (&self->drain_requested) && !self->drained)
+    {
+      /* Everything queued has been handed over; upload the rest. */
+      deepgram_http_flush (self->http);
+      g_mutex_lock (&self->lock);
+      self->drained = TRUE;
+      g_cond_broadcast (&self->drain_cond);
+      g_mutex_unlock (&self->lock);
     }
 
-  JsonObject* first_alt = json_array_get_object_element (alt_arr, 0);
-  if (!first_alt)
+  if (self->drained && deepgram_http_is_done (self->http))
     {
-      g_object_unref (parser);
-      return;
+      g_mutex_lock (&self->lock);
+      self->stream_finished = TRUE;
+      g_cond_broadcast (&self->drain_cond);
+      g_mutex_unlock (&self->lock);
     }
 
-  gdouble    transcript_start_time = 0.0;
-  gdouble    transcript_end_time   = 0.0;
-  gboolean   has_start_time        = FALSE;
-  JsonArray* words_arr = json_object_get_array_member (first_alt, "words");
-  if (words_arr)
+  g_source_set_ready_time (self->pump, -1);
+
+  atomic_store (&self->sender_waiting, TRUE);
+  atomic_thread_fence (memory_order_seq_cst);
+  if (deepgram_ws_has_queued (self)
+      || atomic_load (&self->discard_until) != self->discarded
+      || (atomic_load (&self->drain_requested) && !self->drained)
+      || atomic_load (&self->stopping))
     {
-      for (guint i = 0; i < json_array_get_length (words_arr); i++)
-        {
-          JsonObject* word_obj = json_array_get_object_element (words_arr, i);
-          if (!word_obj)
-            continue;
+      g_source_set_ready_time (self->pump, 0);
+    }
+}
 
-          const gchar* word_text  = NULL;
-          gdouble      start_time = 0.0;
-          gdouble      end_time   = 0.0;
+/* deepgram_ws_pump() for transport=http: hands queued audio to the
+ * uploader while it has room for another chunk, and otherwise waits for an
+ * upload to be answered. */
+static gboolean
+deepgram_ws_http_pump (gpointer user_data)
+{
+  DeepgramWS* self = DEEPGRAM_WS (user_data);
 
-          if (json_object_has_member (word_obj, "word"))
-            {
-              word_text = json_object_get_string_member (word_obj, "word");
-            }
-          if (json_object_has_member (word_obj, "start"))
-            {
-              start_time = json_object_get_double_member (word_obj, "start");
-              if (!has_start_time)
-                {
-                  has_start_time        = TRUE;
-                  transcript_start_time = start_time;
-                }
-            }
-          if (json_object_has_member (word_obj, "end"))
-            {
-              end_time = json_object_get_double_member (word_obj, "end");
-              if (end_time > transcript_end_time)
-                {
-                  transcript_end_time = end_time;
-                }
-            }
+  if (atomic_load (&self->stopping))
+    {
+      deepgram_ws_teardown (self);
+      return G_SOURCE_REMOVE;
+    }
 
-          if (word_text && *word_text)
+  atomic_store (&self->sender_waiting, FALSE);
+
+  for (guint n = 0; n < DEEPGRAM_WS_PUMP_BUDGET; n++)
+    {
+      guint64 discard_until = atomic_load (&self->discard_until);
+      if (discard_until != self->discarded)
+        {
+          gsize pending = deepgram_http_discard (self->http);
+          self->replay.end -= pending;
+          self->discarded = discard_until;
+          if (pending > 0)
             {
-              g_signal_emit (self, signals[SIGNAL_WS_WORD], 0, word_text,
-                             start_time, end_time);
+              atomic_fetch_sub (&self->queued_end, pending);
+              g_signal_emit (self, signals[SIGNAL_WS_AUDIO_REMOVED], 0,
+                             self->replay.end, (guint64)pending);
             }
         }
-    }
 
-  const gchar* transcript = NULL;
-  if (json_object_has_member (first_alt, "transcript"))
-    {
-      transcript = json_object_get_string_member (first_alt, "transcript");
+      /* Audio stays queued, where max-queue-bytes applies, until an
+       * upload is answered. */
+      if (!deepgram_http_can_push (self->http))
+        {
+          g_source_set_ready_time (self->pump, -1);
+          return G_SOURCE_CONTINUE;
+        }
+
+      gint64  enqueued;
+      GBytes* chunk = deepgram_ws_pop_sendable (self, &enqueued);
+      if (!chunk)
+        {
+          deepgram_ws_http_idle (self);
+          return G_SOURCE_CONTINUE;
+        }
+
+      gsize         size;
+      const guint8* data = g_bytes_get_data (chunk, &size);
+      if (self->replay.end == 0)
+        self->framer.first_send = deepgram_monotonic_time ();
+      deepgram_replay_append (&self->replay, data, size);
+      deepgram_http_push (self->http, data, size);
+      g_bytes_unref (chunk);
     }
 
-  gboolean is_final = FALSE;
-  if (json_object_has_member (root_obj, "is_final"))
+  g_source_set_ready_time (self->pump, 0);
+  return G_SOURCE_CONTINUE;
+}
+
+/* transport=http: nothing to connect to; the pump feeds an uploader that
+ * POSTs to the endpoint with its scheme changed to http(s). */
+static void
+deepgram_ws_open_http (DeepgramWS* self)
+{
+  gchar* url = deepgram_ws_build_url (self);
+  if (g_str_has_prefix (url, "ws://") || g_str_has_prefix (url, "wss://"))
     {
-      is_final = json_object_get_boolean_member (root_obj, "is_final");
+      gchar* http_url = g_strconcat ("http", url + 2, NULL);
+      g_free (url);
+      url = http_url;
     }
 
-  if (transcript && *transcript)
+  deepgram_ws_get_audio_format (self, &self->bytes_per_second,
+                                &self->block_align);
+
+  g_print ("[DeepgramWS] Uploading to: %s\n", url);
+  self->http = deepgram_http_new (
+      deepgram_worker_get_session (self->worker), url, self->api_key,
+      self->bytes_per_second, self->block_align, &deepgram_ws_http_callbacks,
+      self);
+  g_free (url);
+  if (!self->http)
     {
-      if (!self->silent)
-        {
-          g_print ("[DeepgramWS] => %s: %s\n", is_final ? "Final" : "Partial",
-                   transcript);
-        }
-      g_signal_emit (self, signals[SIGNAL_WS_TRANSCRIPT], 0, transcript,
-                     is_final, transcript_start_time, transcript_end_time);
+      deepgram_ws_teardown (self);
+      return;
     }
 
-  g_object_unref (parser);
+  g_mutex_lock (&self->lock);
+  guint   max_retries    = self->max_reconnects;
+  guint64 stats_interval = self->stats_interval;
+  g_mutex_unlock (&self->lock);
+
+  deepgram_http_set_chunking (self->http, self->chunk_bytes,
+                              self->max_uploads);
+  deepgram_http_set_max_retries (self->http, max_retries);
+  if (self->encoder)
+    deepgram_http_set_encoder (self->http, self->encoding, self->encoder);
+
+  /* Nothing is ever replayed, but results are acknowledged the same way. */
+  self->framer.staged   = 0;
+  self->replay.capacity = 0;
+  self->replay.end      = 0;
+  self->n_acked         = self->multichannel ? self->block_align / 2 : 1;
+  self->channel_acked   = g_new0 (guint64, self->n_acked);
+  self->session_base    = 0;
+  deepgram_ws_set_acked (self, 0);
+
+  self->discarded = atomic_load (&self->discard_until);
+
+  if (!deepgram_ws_attach_pump (self, deepgram_ws_http_pump, stats_interval))
+    deepgram_ws_teardown (self);
 }
@@ -2,9 +2,32 @@
 #define __DEEPGRAM_WS_H__
 
 #include <glib-object.h>
+#include <gst/gst.h>
+
+#include "deepgramencode.h"
+#include "deepgramresult.h"
 
 G_BEGIN_DECLS
 
+typedef enum {
+  DEEPGRAM_WS_LEAKY_NO,
+  DEEPGRAM_WS_LEAKY_UPSTREAM,
+  DEEPGRAM_WS_LEAKY_DOWNSTREAM,
+} DeepgramWSLeaky;
+
+#define DEEPGRAM_TYPE_WS_LEAKY (deepgram_ws_leaky_get_type())
+GType deepgram_ws_leaky_get_type(void);
+
+/* How audio reaches Deepgram: streamed over a WebSocket, or cut into
+ * chunks posted to the prerecorded API concurrently (for files). */
+typedef enum {
+  DEEPGRAM_WS_TRANSPORT_WEBSOCKET,
+  DEEPGRAM_WS_TRANSPORT_HTTP,
+} DeepgramWSTransport;
+
+#define DEEPGRAM_TYPE_WS_TRANSPORT (deepgram_ws_transport_get_type())
+GType deepgram_ws_transport_get_type(void);
+
 #define DEEPGRAM_TYPE_WS (deepgram_ws_get_type())
 G_DECLARE_FINAL_TYPE (DeepgramWS, deepgram_ws, DEEPGRAM, WS, GObject)
 
@@ -14,17 +37,72 @@ gboolean deepgram_ws_start(DeepgramWS *self);
 
 void deepgram_ws_stop(DeepgramWS *self);
 
-void deepgram_ws_push_audio(DeepgramWS *self, const guint8 *data, gsize size);
+GstFlowReturn deepgram_ws_push_audio(DeepgramWS *self, const guint8 *data,
+                                     gsize size);
+
+GstFlowReturn deepgram_ws_push_buffer(DeepgramWS *self, GstBuffer *buffer);
+
+void deepgram_ws_set_flushing(DeepgramWS *self, gboolean flushing);
+
+gboolean deepgram_ws_drain(DeepgramWS *self, guint64 timeout);
+
+void deepgram_ws_finalize(DeepgramWS *self);
+
+/* Forgets the audio queued so far; "audio-removed" reports where it was
+ * taken out of the stream once the worker has done so. */
+void deepgram_ws_discard_queued(DeepgramWS *self);
+
+gboolean deepgram_ws_is_running(DeepgramWS *self);
+
+/* A deepgram-stats structure describing the stream so far; callable from
+ * any thread. */
+GstStructure * deepgram_ws_get_stats(DeepgramWS *self);
 
 enum {
   PROP_WS_API_KEY = 1,
   PROP_WS_MODEL,
   PROP_WS_SILENT,
+  PROP_WS_CHUNKS_COPIED,
+  PROP_WS_CHUNKS_ZERO_COPY,
+  PROP_WS_MAX_QUEUE_BYTES,
+  PROP_WS_LEAKY,
+  PROP_WS_FRAME_BYTES,
+  PROP_WS_MAX_FRAME_DELAY,
+  PROP_WS_ENDPOINT,
+  PROP_WS_QUERY_PARAMS,
+  PROP_WS_MAX_SEND_RATE,
+  PROP_WS_KEEPALIVE_INTERVAL,
+  PROP_WS_MAX_RECONNECTS,
+  PROP_WS_REPLAY_BYTES,
+  PROP_WS_RECONNECTS,
+  PROP_WS_OUTAGE_TIME,
+  PROP_WS_DEDICATED_THREAD,
+  PROP_WS_ENCODING,
+  PROP_WS_BITRATE,
+  PROP_WS_BYTES_SENT,
+  PROP_WS_ENCODE_TIME,
+  PROP_WS_CHANNELS,
+  PROP_WS_MULTICHANNEL,
+  PROP_WS_STATS,
+  PROP_WS_STATS_INTERVAL,
+  PROP_WS_SPOOL_DIR,
+  PROP_WS_RECORD_TO,
+  PROP_WS_RECORD_AUDIO,
+  PROP_WS_TRANSPORT,
+  PROP_WS_CHUNK_BYTES,
+  PROP_WS_MAX_UPLOADS,
+  PROP_WS_POLL_INTERVAL,
 };
 
 enum {
   SIGNAL_WS_TRANSCRIPT,
   SIGNAL_WS_WORD,
+  SIGNAL_WS_AUDIO_DROPPED,
+  SIGNAL_WS_RECONNECTED,
+  SIGNAL_WS_WORDS,
+  SIGNAL_WS_STATS,
+  SIGNAL_WS_CHUNK_FAILED,
+  SIGNAL_WS_AUDIO_REMOVED,
   N_WS_SIGNALS
 };
 
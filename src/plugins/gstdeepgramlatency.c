@@ -0,0 +1,102 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#include "gstdeepgramlatency.h"
+
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+
+GST_DEBUG_CATEGORY_STATIC (gst_deepgram_latency_debug);
+#define GST_CAT_DEFAULT gst_deepgram_latency_debug
+
+/* Logs the capture-to-transcript latency of every deepgramsink result, as
+ * reported by its "transcript-latency" signal, through the tracing
+ * framework. Enabled with GST_TRACERS=deepgram-latency; the records show
+ * up in the GST_TRACER debug category at TRACE level. */
+typedef struct
+{
+  GstTracer parent_instance;
+} GstDeepgramLatencyTracer;
+
+typedef struct
+{
+  GstTracerClass parent_class;
+} GstDeepgramLatencyTracerClass;
+
+G_DEFINE_TYPE (GstDeepgramLatencyTracer, gst_deepgram_latency_tracer,
+               GST_TYPE_TRACER)
+
+static GstTracerRecord* tr_latency = NULL;
+
+static void
+gst_deepgram_latency_tracer_on_latency (GstElement* sink, guint64 latency,
+                                        guint64 running_time, gboolean is_final,
+                                        guint channel, gpointer user_data)
+{
+  gchar* name = gst_object_get_name (GST_OBJECT (sink));
+
+  gst_tracer_record_log (tr_latency, name, latency, running_time, is_final,
+                         channel);
+  g_free (name);
+}
+
+/* Only deepgramsink has the signal, so nothing else is touched. */
+static void
+gst_deepgram_latency_tracer_element_new (GObject* self, GstClockTime ts,
+                                         GstElement* element)
+{
+  if (g_signal_lookup ("transcript-latency", G_OBJECT_TYPE (element)) == 0)
+    return;
+
+  GST_DEBUG_OBJECT (self, "Tracing %" GST_PTR_FORMAT, element);
+  g_signal_connect (element, "transcript-latency",
+                    G_CALLBACK (gst_deepgram_latency_tracer_on_latency), self);
+}
+
+static GstStructure*
+gst_deepgram_latency_tracer_value (GType type, const gchar* description)
+{
+  return gst_structure_new ("value", "type", G_TYPE_GTYPE, type, "description",
+                            G_TYPE_STRING, description, NULL);
+}
+
+static void
+gst_deepgram_latency_tracer_class_init (GstDeepgramLatencyTracerClass* klass)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_deepgram_latency_debug, "deepgramlatency", 0,
+                           "Deepgram transcript latency tracer");
+
+  tr_latency = gst_tracer_record_new (
+      "deepgram-latency.class", "element", GST_TYPE_STRUCTURE,
+      gst_structure_new ("scope", "type", G_TYPE_GTYPE, G_TYPE_STRING,
+                         "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+                         GST_TRACER_VALUE_SCOPE_ELEMENT, NULL),
+      "latency", GST_TYPE_STRUCTURE,
+      gst_deepgram_latency_tracer_value (
+          G_TYPE_UINT64, "time from rendering the audio at the end of a "
+                         "result to receiving the result (ns)"),
+      "running-time", GST_TYPE_STRUCTURE,
+      gst_deepgram_latency_tracer_value (
+          G_TYPE_UINT64, "running time of the audio at the end of the "
+                         "result"),
+      "is-final", GST_TYPE_STRUCTURE,
+      gst_deepgram_latency_tracer_value (G_TYPE_BOOLEAN,
+                                         "whether the result is final"),
+      "channel", GST_TYPE_STRUCTURE,
+      gst_deepgram_latency_tracer_value (G_TYPE_UINT,
+                                         "input channel of the result"),
+      NULL);
+  GST_OBJECT_FLAG_SET (tr_latency, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_deepgram_latency_tracer_init (GstDeepgramLatencyTracer* self)
+{
+  gst_tracing_register_hook (
+      GST_TRACER (self), "element-new",
+      G_CALLBACK (gst_deepgram_latency_tracer_element_new));
+}
+
+#endif /* GST_DISABLE_GST_TRACER_HOOKS */
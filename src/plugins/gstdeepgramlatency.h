@@ -0,0 +1,15 @@
+#ifndef __GST_DEEPGRAM_LATENCY_H__
+#define __GST_DEEPGRAM_LATENCY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Registered as the "deepgram-latency" tracer unless GStreamer was built
+ * without tracer hooks. */
+#define GST_TYPE_DEEPGRAM_LATENCY_TRACER (gst_deepgram_latency_tracer_get_type())
+GType gst_deepgram_latency_tracer_get_type(void);
+
+G_END_DECLS
+
+#endif /* __GST_DEEPGRAM_LATENCY_H__ */
@@ -6,7 +6,11 @@
 #include <gst/base/gstbasesink.h>
 #include <gst/gst.h>
 
+#include "deepgramconvert.h"
+#include "deepgramvad.h"
 #include "deepgramws.h"
+#include "gstdeepgramlatency.h"
+#include "gstdeepgramtranscribe.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_deepgram_sink_debug);
 #define GST_CAT_DEFAULT gst_deepgram_sink_debug
@@ -15,15 +19,173 @@ GST_DEBUG_CATEGORY_STATIC (gst_deepgram_sink_debug);
 G_DECLARE_FINAL_TYPE (GstDeepgramSink, gst_deepgram_sink, GST, DEEPGRAM_SINK,
                       GstBaseSink)
 
+typedef enum
+{
+  GST_DEEPGRAM_SINK_MODE_LIVE,
+  GST_DEEPGRAM_SINK_MODE_BATCH,
+} GstDeepgramSinkMode;
+
+#define GST_TYPE_DEEPGRAM_SINK_MODE (gst_deepgram_sink_mode_get_type ())
+
+static GType
+gst_deepgram_sink_mode_get_type (void)
+{
+  static gsize            mode_type = 0;
+  static const GEnumValue values[]  = {
+    { GST_DEEPGRAM_SINK_MODE_LIVE, "Send audio in real time (sync to clock)",
+      "live" },
+    { GST_DEEPGRAM_SINK_MODE_BATCH,
+      "Send audio as fast as the connection allows (for files)", "batch" },
+    { 0, NULL, NULL },
+  };
+
+  if (g_once_init_enter (&mode_type))
+    {
+      GType type = g_enum_register_static ("GstDeepgramSinkMode", values);
+      g_once_init_leave (&mode_type, type);
+    }
+
+  return mode_type;
+}
+
 struct _GstDeepgramSink
 {
-  GstBaseSink parent;
-  gchar*      api_key;
-  gchar*      model;
-  gboolean    silent;
+  GstBaseSink   parent;
+  gchar*        api_key;
+  gchar*        model;
+  gboolean      silent;
+  gchar*        endpoint;
+  GstStructure* query_params;
+  guint64       max_queue_time;
+  gint          leaky;
+  guint64       dropped_bytes; /* under the object lock */
+  guint64       frame_duration;
+  guint64       max_frame_delay;
+  gint          mode;
+  gdouble       max_rate;
+  guint64       drain_timeout;
+  guint64       last_drain_time;
+  gboolean      prewarm;
+  guint64       keepalive_interval;
+  guint         max_reconnects;
+  guint64       replay_duration;
+  guint         reconnects;
+  guint64       outage_time;
+  gboolean      dedicated_thread;
+  gint          encoding;
+  guint         bitrate;
+  gdouble       vad_threshold;
+  guint64       vad_hangover;
+  gboolean      multichannel;
+  guint64       stats_interval;
+  gchar*        spool_dir;
+  gchar*        record_to;
+  gboolean      record_audio;
+  gint          transport;
+  guint64       chunk_duration;
+  guint         max_uploads;
+
+  /* Replaced under the object lock, so the stats property can take a
+   * reference from any thread. */
   DeepgramWS* ws;
+
+  /* Channels sent to Deepgram: the input's with multichannel, else 1. Only
+   * changes in set_caps, with the connection reopened around it. */
+  guint out_channels;
+
+  /* Set up by set_caps unless the input already is what Deepgram is sent:
+   * one converter downmixing everything, or one per channel with
+   * multichannel. Only used on the streaming thread. */
+  GPtrArray* converters;
+  guint      in_bpf;
+
+  /* Silence gating, on the streaming thread. Offsets are bytes of
+   * converted audio since the connection opened: in_bytes seen, sent_bytes
+   * handed to the connection, next_original where the next sent byte would
+   * be in the input if nothing more is held back. in_bytes and
+   * suppressed_bytes are read by the properties under the object lock.
+   * sent_bytes is on the connection's stream timeline: audio it drops or
+   * discards before sending is taken out again, from either thread, so it
+   * is only accessed with gaps_lock held. */
+  DeepgramVad* vad;
+  GArray*      vad_runs;
+  guint64      in_bytes;
+  guint64      sent_bytes;
+  guint64      suppressed_bytes;
+  guint64      next_original;
+
+  /* GstDeepgramSinkGap per stretch of held-back audio, oldest first;
+   * appended on the streaming thread, read by the result handlers on the
+   * connection's worker. */
+  GMutex  gaps_lock;
+  GArray* gaps;
+
+  /* GstDeepgramSinkMark per buffer sent, oldest first, used and pruned
+   * like gaps; marks_lock nests inside gaps_lock. latency and latency_max
+   * (ns) of the results so far are read by the properties under the object
+   * lock. */
+  GMutex       marks_lock;
+  GArray*      marks;
+  GstClockTime latency;
+  GstClockTime latency_max;
 };
 
+/* From sent bytes into the connection on, the audio is that from original
+ * bytes into the input. */
+typedef struct
+{
+  guint64 sent;
+  guint64 original;
+} GstDeepgramSinkGap;
+
+/* The first sent bytes of the connection were rendered at rendered
+ * (monotonic clock, ns) and end at running_time in the input. */
+typedef struct
+{
+  guint64      sent;
+  GstClockTime running_time;
+  gint64       rendered;
+} GstDeepgramSinkMark;
+
+/* Bounds the marks kept when no final results prune them, e.g. with
+ * multichannel. */
+#define DEEPGRAM_SINK_MAX_MARKS 4096
+
+/* Whatever the input caps, Deepgram is sent S16LE 16 kHz, mono unless
+ * multichannel is set. */
+#define DEEPGRAM_SINK_RATE             16000
+#define DEEPGRAM_SINK_BYTES_PER_SAMPLE 2
+#define DEEPGRAM_SINK_MAX_CHANNELS     8
+
+#define DEFAULT_ENDPOINT       "wss://api.deepgram.com/v1/listen"
+#define DEFAULT_MAX_QUEUE_TIME (5 * GST_SECOND)
+#define DEFAULT_LEAKY          DEEPGRAM_WS_LEAKY_NO
+#define DEFAULT_FRAME_DURATION  0
+#define DEFAULT_MAX_FRAME_DELAY (20 * GST_MSECOND)
+#define DEFAULT_MODE            GST_DEEPGRAM_SINK_MODE_LIVE
+#define DEFAULT_MAX_RATE        0.0
+#define DEFAULT_DRAIN_TIMEOUT   (10 * GST_SECOND)
+#define DEFAULT_PREWARM         FALSE
+#define DEFAULT_KEEPALIVE       (5 * GST_SECOND)
+#define DEFAULT_MAX_RECONNECTS  5
+#define DEFAULT_REPLAY_DURATION (10 * GST_SECOND)
+#define DEFAULT_DEDICATED_THREAD FALSE
+#define DEFAULT_ENCODING        DEEPGRAM_ENCODING_LINEAR16
+#define DEFAULT_BITRATE         32000
+#define DEFAULT_VAD_THRESHOLD   -100.0
+#define DEFAULT_VAD_HANGOVER    (500 * GST_MSECOND)
+#define DEFAULT_MULTICHANNEL    FALSE
+#define DEFAULT_STATS_INTERVAL  0
+#define DEFAULT_TRANSPORT       DEEPGRAM_WS_TRANSPORT_WEBSOCKET
+#define DEFAULT_CHUNK_DURATION  (60 * GST_SECOND)
+#define DEFAULT_MAX_UPLOADS     8
+
+/* vad-threshold at or below this turns gating off. */
+#define DEEPGRAM_SINK_VAD_OFF -100.0
+
+/* Silence sent ahead of speech, so soft onsets are not clipped. */
+#define DEEPGRAM_SINK_VAD_PREROLL (100 * GST_MSECOND)
+
 G_DEFINE_TYPE (GstDeepgramSink, gst_deepgram_sink, GST_TYPE_BASE_SINK)
 
 enum
@@ -31,13 +193,46 @@ enum
   PROP_0,
   PROP_API_KEY,
   PROP_MODEL,
-  PROP_SILENT
+  PROP_SILENT,
+  PROP_ENDPOINT,
+  PROP_QUERY_PARAMS,
+  PROP_MAX_QUEUE_TIME,
+  PROP_LEAKY,
+  PROP_FRAME_DURATION,
+  PROP_MAX_FRAME_DELAY,
+  PROP_MODE,
+  PROP_MAX_RATE,
+  PROP_DRAIN_TIMEOUT,
+  PROP_LAST_DRAIN_TIME,
+  PROP_PREWARM,
+  PROP_KEEPALIVE_INTERVAL,
+  PROP_MAX_RECONNECTS,
+  PROP_REPLAY_DURATION,
+  PROP_RECONNECTS,
+  PROP_OUTAGE_TIME,
+  PROP_DEDICATED_THREAD,
+  PROP_ENCODING,
+  PROP_BITRATE,
+  PROP_VAD_THRESHOLD,
+  PROP_VAD_HANGOVER,
+  PROP_VAD_SUPPRESSED,
+  PROP_MULTICHANNEL,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
+  PROP_SPOOL_DIR,
+  PROP_RECORD_TO,
+  PROP_RECORD_AUDIO,
+  PROP_TRANSPORT,
+  PROP_CHUNK_DURATION,
+  PROP_MAX_UPLOADS
 };
 
 enum
 {
   SIGNAL_TRANSCRIPT,
   SIGNAL_WORD,
+  SIGNAL_WORDS,
+  SIGNAL_TRANSCRIPT_LATENCY,
   N_SIGNALS
 };
 
@@ -46,29 +241,62 @@ static guint gst_deepgram_sink_signals[N_SIGNALS] = { 0 };
 static GstStaticPadTemplate sink_template
     = GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
                                GST_STATIC_CAPS ("audio/x-raw, "
-                                                "format = (string) S16LE, "
-                                                "rate = (int) 16000, "
-                                                "channels = (int) 1"));
+                                                "format = (string) { S16LE, "
+                                                "F32LE }, "
+                                                "rate = (int) { 8000, 16000, "
+                                                "44100, 48000 }, "
+                                                "channels = (int) [ 1, 8 ], "
+                                                "layout = (string) "
+                                                "interleaved"));
 
+static void     gst_deepgram_sink_finalize (GObject* object);
 static void     gst_deepgram_sink_set_property (GObject* object, guint prop_id,
                                                 const GValue* value,
                                                 GParamSpec*   pspec);
 static void     gst_deepgram_sink_get_property (GObject* object, guint prop_id,
                                                 GValue* value, GParamSpec* pspec);
+static GstStateChangeReturn
+gst_deepgram_sink_change_state (GstElement* element, GstStateChange transition);
 static gboolean gst_deepgram_sink_start (GstBaseSink* basesink);
 static gboolean gst_deepgram_sink_stop (GstBaseSink* basesink);
+static gboolean gst_deepgram_sink_event (GstBaseSink* basesink, GstEvent* event);
+static gboolean gst_deepgram_sink_set_caps (GstBaseSink* basesink,
+                                            GstCaps*     caps);
+static gboolean gst_deepgram_sink_unlock (GstBaseSink* basesink);
+static gboolean gst_deepgram_sink_unlock_stop (GstBaseSink* basesink);
 static GstFlowReturn gst_deepgram_sink_render (GstBaseSink* basesink,
                                                GstBuffer*   buffer);
+static void gst_deepgram_sink_on_deepgram_audio_dropped (DeepgramWS* ws,
+                                                         guint64     bytes,
+                                                         gpointer user_data);
+static void gst_deepgram_sink_on_deepgram_audio_removed (DeepgramWS* ws,
+                                                         guint64     offset,
+                                                         guint64     bytes,
+                                                         gpointer user_data);
+static void gst_deepgram_sink_on_deepgram_reconnected (DeepgramWS* ws,
+                                                       guint       attempts,
+                                                       guint64     outage,
+                                                       guint64     replayed,
+                                                       gpointer    user_data);
+static void gst_deepgram_sink_on_deepgram_chunk_failed (DeepgramWS* ws,
+                                                        gdouble     start,
+                                                        gdouble     duration,
+                                                        gpointer user_data);
 static void
 gst_deepgram_sink_on_deepgram_transcript (DeepgramWS* ws, const gchar* text,
                                           gboolean is_final, gdouble start_time,
-                                          gdouble end_time, gpointer user_data);
+                                          gdouble end_time, guint channel,
+                                          gpointer user_data);
+
+static void gst_deepgram_sink_on_deepgram_stats (DeepgramWS*   ws,
+                                                 GstStructure* stats,
+                                                 gpointer      user_data);
 
-static void gst_deepgram_sink_on_deepgram_word (DeepgramWS*  ws,
-                                                const gchar* word,
-                                                gdouble      start_time,
-                                                gdouble      end_time,
-                                                gpointer     user_data);
+static void gst_deepgram_sink_on_deepgram_words (DeepgramWS* ws,
+                                                 GArray*     words,
+                                                 gboolean    is_final,
+                                                 guint       channel,
+                                                 gpointer    user_data);
 
 static void
 gst_deepgram_sink_class_init (GstDeepgramSinkClass* klass)
@@ -77,6 +305,7 @@ gst_deepgram_sink_class_init (GstDeepgramSinkClass* klass)
   GstElementClass*  element_class  = GST_ELEMENT_CLASS (klass);
   GstBaseSinkClass* basesink_class = GST_BASE_SINK_CLASS (klass);
 
+  gobject_class->finalize     = gst_deepgram_sink_finalize;
   gobject_class->set_property = gst_deepgram_sink_set_property;
   gobject_class->get_property = gst_deepgram_sink_get_property;
 
@@ -98,14 +327,284 @@ gst_deepgram_sink_class_init (GstDeepgramSinkClass* klass)
                             "Suppress console logging of transcripts", FALSE,
                             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (
+      gobject_class, PROP_ENDPOINT,
+      g_param_spec_string ("endpoint", "Endpoint",
+                           "Deepgram streaming endpoint URL (e.g. a local "
+                           "mock server)",
+                           DEFAULT_ENDPOINT,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_QUERY_PARAMS,
+      g_param_spec_boxed ("query-params", "Query Parameters",
+                          "Extra Deepgram query parameters, e.g. "
+                          "\"params,interim_results=true,smart_format=true\"",
+                          GST_TYPE_STRUCTURE,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max. queue time (ns)",
+                           "Max. amount of audio waiting to be sent to "
+                           "Deepgram (0 = unlimited)",
+                           0, G_MAXUINT64, DEFAULT_MAX_QUEUE_TIME,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_LEAKY,
+      g_param_spec_enum ("leaky", "Leaky",
+                         "Where to drop audio when the queue is full",
+                         DEEPGRAM_TYPE_WS_LEAKY, DEFAULT_LEAKY,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_SPOOL_DIR,
+      g_param_spec_string ("spool-dir", "Spool directory",
+                           "In live mode, write audio beyond max-queue-time "
+                           "to a file in this directory instead of dropping "
+                           "it, and send it once the connection recovers "
+                           "(NULL = off)",
+                           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_RECORD_TO,
+      g_param_spec_string ("record-to", "Record to",
+                           "Log every message exchanged with Deepgram to this "
+                           "file, for replaying the session offline; "
+                           "rewritten whenever the connection is opened "
+                           "(NULL = off)",
+                           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_RECORD_AUDIO,
+      g_param_spec_boolean ("record-audio", "Record audio",
+                            "Include the audio sent in the record-to log, "
+                            "not just the size of each message",
+                            FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_FRAME_DURATION,
+      g_param_spec_uint64 ("frame-duration", "Frame duration (ns)",
+                           "Duration of audio per WebSocket message; buffers "
+                           "are merged or split to fit (0 = one message per "
+                           "buffer)",
+                           0, 10 * GST_SECOND, DEFAULT_FRAME_DURATION,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_FRAME_DELAY,
+      g_param_spec_uint64 ("max-frame-delay", "Max. frame delay (ns)",
+                           "Max. time a partial frame is held back waiting "
+                           "for more audio when frame-duration is set",
+                           0, 10 * GST_SECOND, DEFAULT_MAX_FRAME_DELAY,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+                         "live syncs to the clock; batch (for files) pushes "
+                         "audio as fast as the connection and max-rate allow",
+                         GST_TYPE_DEEPGRAM_SINK_MODE, DEFAULT_MODE,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_RATE,
+      g_param_spec_double ("max-rate", "Max. rate",
+                           "Cap on the send speed in batch mode, as a multiple "
+                           "of real time (0 = unlimited)",
+                           0.0, G_MAXDOUBLE, DEFAULT_MAX_RATE,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_TRANSPORT,
+      g_param_spec_enum ("transport", "Transport",
+                         "websocket streams; http (for files, with "
+                         "mode=batch) uploads chunks cut at quiet points to "
+                         "the prerecorded API, several at a time",
+                         DEEPGRAM_TYPE_WS_TRANSPORT, DEFAULT_TRANSPORT,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_CHUNK_DURATION,
+      g_param_spec_uint64 ("chunk-duration", "Chunk duration (ns)",
+                           "With transport=http, audio per upload; the chunk "
+                           "ends at the quietest point of its last quarter "
+                           "(0 = upload the whole stream at EOS)",
+                           0, 3600 * GST_SECOND, DEFAULT_CHUNK_DURATION,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_UPLOADS,
+      g_param_spec_uint ("max-uploads", "Max. uploads",
+                         "With transport=http, chunks uploaded at the same "
+                         "time",
+                         1, 256, DEFAULT_MAX_UPLOADS,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_DRAIN_TIMEOUT,
+      g_param_spec_uint64 ("drain-timeout", "Drain timeout (ns)",
+                           "Max. time EOS waits for queued audio to be sent "
+                           "and the final transcripts to arrive (0 = don't "
+                           "wait)",
+                           0, G_MAXUINT64, DEFAULT_DRAIN_TIMEOUT,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_LAST_DRAIN_TIME,
+      g_param_spec_uint64 ("last-drain-time", "Last drain time (ns)",
+                           "How long the last EOS drain took", 0,
+                           G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_PREWARM,
+      g_param_spec_boolean ("prewarm", "Pre-warm",
+                            "Connect to Deepgram when going to READY and keep "
+                            "the connection until NULL, instead of "
+                            "reconnecting on every start",
+                            DEFAULT_PREWARM,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_KEEPALIVE_INTERVAL,
+      g_param_spec_uint64 ("keepalive-interval", "KeepAlive interval (ns)",
+                           "Send a KeepAlive message when no audio was sent "
+                           "for this long, so an idle connection stays open "
+                           "(0 = never)",
+                           0, G_MAXUINT64, DEFAULT_KEEPALIVE,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_RECONNECTS,
+      g_param_spec_uint ("max-reconnects", "Max. reconnects",
+                         "Attempts to re-establish a dropped connection "
+                         "before giving up (0 = don't reconnect)",
+                         0, G_MAXUINT, DEFAULT_MAX_RECONNECTS,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_REPLAY_DURATION,
+      g_param_spec_uint64 ("replay-duration", "Replay duration (ns)",
+                           "Audio kept after sending so that what Deepgram "
+                           "had not transcribed yet can be re-sent after a "
+                           "reconnect",
+                           0, 60 * GST_SECOND, DEFAULT_REPLAY_DURATION,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_RECONNECTS,
+      g_param_spec_uint ("reconnects", "Reconnects",
+                         "Number of times the connection was re-established",
+                         0, G_MAXUINT, 0,
+                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_OUTAGE_TIME,
+      g_param_spec_uint64 ("outage-time", "Outage time (ns)",
+                           "Total time spent reconnecting", 0, G_MAXUINT64, 0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_DEDICATED_THREAD,
+      g_param_spec_boolean ("dedicated-thread", "Dedicated thread",
+                            "Serve this stream's connection from a thread of "
+                            "its own instead of the shared worker pool",
+                            DEFAULT_DEDICATED_THREAD,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_ENCODING,
+      g_param_spec_enum ("encoding", "Encoding",
+                         "Send the audio as 16-bit PCM, or compress it to "
+                         "Opus or FLAC first to save bandwidth",
+                         DEEPGRAM_TYPE_ENCODING, DEFAULT_ENCODING,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate",
+                         "Opus target bitrate in bits per second", 6000,
+                         256000, DEFAULT_BITRATE,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_VAD_THRESHOLD,
+      g_param_spec_double ("vad-threshold", "VAD threshold (dBFS)",
+                           "Level below which audio counts as silence and is "
+                           "not sent; KeepAlive keeps the connection open "
+                           "meanwhile (-100 = send everything)",
+                           DEEPGRAM_SINK_VAD_OFF, 0.0, DEFAULT_VAD_THRESHOLD,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_VAD_HANGOVER,
+      g_param_spec_uint64 ("vad-hangover", "VAD hangover (ns)",
+                           "How long audio keeps being sent after the level "
+                           "drops below vad-threshold",
+                           0, 10 * GST_SECOND, DEFAULT_VAD_HANGOVER,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_VAD_SUPPRESSED,
+      g_param_spec_double ("vad-suppressed", "VAD suppressed",
+                           "Fraction of the audio held back as silence since "
+                           "the connection opened",
+                           0.0, 1.0, 0.0,
+                           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MULTICHANNEL,
+      g_param_spec_boolean ("multichannel", "Multichannel",
+                            "Send every input channel and have each one "
+                            "transcribed on its own, instead of downmixing "
+                            "to mono",
+                            DEFAULT_MULTICHANNEL,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+                          "Live statistics of the connection (queue, sends, "
+                          "result lag, parsing, reconnects) as a "
+                          "deepgram-stats structure; NULL when not connected",
+                          GST_TYPE_STRUCTURE,
+                          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint64 ("stats-interval", "Stats interval (ns)",
+                           "Post the stats as a deepgram-stats element "
+                           "message this often while connected (0 = never)",
+                           0, G_MAXUINT64, DEFAULT_STATS_INTERVAL,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /* Each result signal ends with the input channel the result is for; it
+   * is always 0 without multichannel. */
   gst_deepgram_sink_signals[SIGNAL_TRANSCRIPT] = g_signal_new (
       "transcript", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
-      NULL, G_TYPE_NONE, 4, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_DOUBLE,
-      G_TYPE_DOUBLE);
+      NULL, G_TYPE_NONE, 5, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE, G_TYPE_UINT);
 
   gst_deepgram_sink_signals[SIGNAL_WORD] = g_signal_new (
       "word", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
-      G_TYPE_NONE, 3, G_TYPE_STRING, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+      G_TYPE_NONE, 4, G_TYPE_STRING, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+      G_TYPE_UINT);
+
+  /* One emission per result instead of one per word: an a(sddd) GVariant of
+   * (word, start, end, confidence), and whether the result is final. */
+  gst_deepgram_sink_signals[SIGNAL_WORDS] = g_signal_new (
+      "words", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+      NULL, G_TYPE_NONE, 3, G_TYPE_VARIANT, G_TYPE_BOOLEAN, G_TYPE_UINT);
+
+  /* Emitted right before "transcript": how long (ns) after the audio at the
+   * result's end was rendered the result arrived, that audio's running
+   * time (GST_CLOCK_TIME_NONE without timestamps), is_final and channel. */
+  gst_deepgram_sink_signals[SIGNAL_TRANSCRIPT_LATENCY] = g_signal_new (
+      "transcript-latency", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, 0,
+      NULL, NULL, NULL, G_TYPE_NONE, 4, G_TYPE_UINT64, G_TYPE_UINT64,
+      G_TYPE_BOOLEAN, G_TYPE_UINT);
 
   gst_element_class_set_static_metadata (
       element_class, "DeepgramSink", "Sink/Audio",
@@ -115,9 +614,16 @@ gst_deepgram_sink_class_init (GstDeepgramSinkClass* klass)
   gst_element_class_add_pad_template (
       element_class, gst_static_pad_template_get (&sink_template));
 
+  element_class->change_state
+      = GST_DEBUG_FUNCPTR (gst_deepgram_sink_change_state);
+
   basesink_class->start  = GST_DEBUG_FUNCPTR (gst_deepgram_sink_start);
   basesink_class->stop   = GST_DEBUG_FUNCPTR (gst_deepgram_sink_stop);
-  basesink_class->render = GST_DEBUG_FUNCPTR (gst_deepgram_sink_render);
+  basesink_class->event       = GST_DEBUG_FUNCPTR (gst_deepgram_sink_event);
+  basesink_class->set_caps    = GST_DEBUG_FUNCPTR (gst_deepgram_sink_set_caps);
+  basesink_class->unlock      = GST_DEBUG_FUNCPTR (gst_deepgram_sink_unlock);
+  basesink_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_deepgram_sink_unlock_stop);
+  basesink_class->render      = GST_DEBUG_FUNCPTR (gst_deepgram_sink_render);
 
   GST_DEBUG_CATEGORY_INIT (gst_deepgram_sink_debug, "deepgramsink", 0,
                            "Deepgram sink plugin");
@@ -130,9 +636,117 @@ gst_deepgram_sink_init (GstDeepgramSink* self)
   self->model   = g_strdup ("general");
   self->silent  = FALSE;
   self->ws      = NULL;
+
+  self->endpoint     = g_strdup (DEFAULT_ENDPOINT);
+  self->query_params = NULL;
+
+  self->max_queue_time  = DEFAULT_MAX_QUEUE_TIME;
+  self->leaky           = DEFAULT_LEAKY;
+  self->dropped_bytes   = 0;
+  self->frame_duration  = DEFAULT_FRAME_DURATION;
+  self->max_frame_delay = DEFAULT_MAX_FRAME_DELAY;
+  self->mode            = DEFAULT_MODE;
+  self->max_rate        = DEFAULT_MAX_RATE;
+  self->drain_timeout   = DEFAULT_DRAIN_TIMEOUT;
+  self->last_drain_time = 0;
+  self->prewarm            = DEFAULT_PREWARM;
+  self->keepalive_interval = DEFAULT_KEEPALIVE;
+  self->max_reconnects     = DEFAULT_MAX_RECONNECTS;
+  self->replay_duration    = DEFAULT_REPLAY_DURATION;
+  self->reconnects         = 0;
+  self->outage_time        = 0;
+  self->dedicated_thread   = DEFAULT_DEDICATED_THREAD;
+  self->encoding           = DEFAULT_ENCODING;
+  self->bitrate            = DEFAULT_BITRATE;
+  self->vad_threshold      = DEFAULT_VAD_THRESHOLD;
+  self->vad_hangover       = DEFAULT_VAD_HANGOVER;
+  self->multichannel       = DEFAULT_MULTICHANNEL;
+  self->stats_interval     = DEFAULT_STATS_INTERVAL;
+  self->spool_dir          = NULL;
+  self->record_to          = NULL;
+  self->record_audio       = FALSE;
+  self->transport          = DEFAULT_TRANSPORT;
+  self->chunk_duration     = DEFAULT_CHUNK_DURATION;
+  self->max_uploads        = DEFAULT_MAX_UPLOADS;
+  self->out_channels       = 1;
+  self->converters         = NULL;
+  self->in_bpf             = DEEPGRAM_SINK_BYTES_PER_SAMPLE;
+  self->vad                = NULL;
+  self->vad_runs = g_array_new (FALSE, FALSE, sizeof (DeepgramVadRun));
+  self->gaps     = g_array_new (FALSE, FALSE, sizeof (GstDeepgramSinkGap));
+  self->marks    = g_array_new (FALSE, FALSE, sizeof (GstDeepgramSinkMark));
+  g_mutex_init (&self->gaps_lock);
+  g_mutex_init (&self->marks_lock);
+  self->latency     = GST_CLOCK_TIME_NONE;
+  self->latency_max = GST_CLOCK_TIME_NONE;
   gst_base_sink_set_sync (GST_BASE_SINK (self), TRUE);
 }
 
+static gboolean
+gst_deepgram_sink_vad_enabled (GstDeepgramSink* self)
+{
+  return self->vad_threshold > DEEPGRAM_SINK_VAD_OFF;
+}
+
+/* Of the audio as sent, all channels together. */
+static guint
+gst_deepgram_sink_block_align (GstDeepgramSink* self)
+{
+  return DEEPGRAM_SINK_BYTES_PER_SAMPLE * self->out_channels;
+}
+
+static guint
+gst_deepgram_sink_bytes_per_second (GstDeepgramSink* self)
+{
+  return DEEPGRAM_SINK_RATE * gst_deepgram_sink_block_align (self);
+}
+
+static guint64
+gst_deepgram_sink_max_queue_bytes (GstDeepgramSink* self)
+{
+  return gst_util_uint64_scale (self->max_queue_time,
+                                gst_deepgram_sink_bytes_per_second (self),
+                                GST_SECOND);
+}
+
+static void
+gst_deepgram_sink_finalize (GObject* object)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (object);
+
+  g_free (self->api_key);
+  g_free (self->model);
+  g_free (self->endpoint);
+  g_free (self->spool_dir);
+  g_free (self->record_to);
+  g_clear_pointer (&self->query_params, gst_structure_free);
+  g_clear_pointer (&self->converters, g_ptr_array_unref);
+  g_clear_pointer (&self->vad, deepgram_vad_free);
+  g_array_unref (self->vad_runs);
+  g_array_unref (self->gaps);
+  g_array_unref (self->marks);
+  g_mutex_clear (&self->gaps_lock);
+  g_mutex_clear (&self->marks_lock);
+
+  G_OBJECT_CLASS (gst_deepgram_sink_parent_class)->finalize (object);
+}
+
+/* Rounded down to whole sample frames so frames never split a sample. */
+static guint
+gst_deepgram_sink_frame_bytes (GstDeepgramSink* self)
+{
+  guint   align = gst_deepgram_sink_block_align (self);
+  guint64 bytes = gst_util_uint64_scale (
+      self->frame_duration, gst_deepgram_sink_bytes_per_second (self),
+      GST_SECOND);
+
+  bytes -= bytes % align;
+  if (self->frame_duration > 0 && bytes == 0)
+    bytes = align;
+
+  return (guint)MIN (bytes, G_MAXUINT);
+}
+
 static void
 gst_deepgram_sink_set_property (GObject* object, guint prop_id,
                                 const GValue* value, GParamSpec* pspec)
@@ -152,12 +766,113 @@ gst_deepgram_sink_set_property (GObject* object, guint prop_id,
     case PROP_SILENT:
       self->silent = g_value_get_boolean (value);
       break;
+    case PROP_ENDPOINT:
+      g_free (self->endpoint);
+      self->endpoint = g_value_dup_string (value);
+      break;
+    case PROP_QUERY_PARAMS:
+      g_clear_pointer (&self->query_params, gst_structure_free);
+      self->query_params = g_value_dup_boxed (value);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      self->max_queue_time = g_value_get_uint64 (value);
+      if (self->ws)
+        g_object_set (self->ws, "max-queue-bytes",
+                      gst_deepgram_sink_max_queue_bytes (self), NULL);
+      break;
+    case PROP_LEAKY:
+      self->leaky = g_value_get_enum (value);
+      if (self->ws)
+        g_object_set (self->ws, "leaky", self->leaky, NULL);
+      break;
+    case PROP_SPOOL_DIR:
+      g_free (self->spool_dir);
+      self->spool_dir = g_value_dup_string (value);
+      break;
+    case PROP_RECORD_TO:
+      g_free (self->record_to);
+      self->record_to = g_value_dup_string (value);
+      break;
+    case PROP_RECORD_AUDIO:
+      self->record_audio = g_value_get_boolean (value);
+      break;
+    case PROP_FRAME_DURATION:
+      self->frame_duration = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_FRAME_DELAY:
+      self->max_frame_delay = g_value_get_uint64 (value);
+      break;
+    case PROP_MODE:
+      self->mode = g_value_get_enum (value);
+      gst_base_sink_set_sync (GST_BASE_SINK (self),
+                              self->mode == GST_DEEPGRAM_SINK_MODE_LIVE);
+      break;
+    case PROP_MAX_RATE:
+      self->max_rate = g_value_get_double (value);
+      break;
+    case PROP_TRANSPORT:
+      self->transport = g_value_get_enum (value);
+      break;
+    case PROP_CHUNK_DURATION:
+      self->chunk_duration = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_UPLOADS:
+      self->max_uploads = g_value_get_uint (value);
+      break;
+    case PROP_DRAIN_TIMEOUT:
+      self->drain_timeout = g_value_get_uint64 (value);
+      break;
+    case PROP_PREWARM:
+      self->prewarm = g_value_get_boolean (value);
+      break;
+    case PROP_KEEPALIVE_INTERVAL:
+      self->keepalive_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_RECONNECTS:
+      self->max_reconnects = g_value_get_uint (value);
+      break;
+    case PROP_REPLAY_DURATION:
+      self->replay_duration = g_value_get_uint64 (value);
+      break;
+    case PROP_DEDICATED_THREAD:
+      self->dedicated_thread = g_value_get_boolean (value);
+      break;
+    case PROP_ENCODING:
+      self->encoding = g_value_get_enum (value);
+      break;
+    case PROP_BITRATE:
+      self->bitrate = g_value_get_uint (value);
+      break;
+    case PROP_VAD_THRESHOLD:
+      self->vad_threshold = g_value_get_double (value);
+      break;
+    case PROP_VAD_HANGOVER:
+      self->vad_hangover = g_value_get_uint64 (value);
+      break;
+    case PROP_MULTICHANNEL:
+      self->multichannel = g_value_get_boolean (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      self->stats_interval = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
     }
 }
 
+/* Adds what the sink measures itself to the connection's statistics. */
+static void
+gst_deepgram_sink_add_stats (GstDeepgramSink* self, GstStructure* stats)
+{
+  GST_OBJECT_LOCK (self);
+  gst_structure_set (stats, "latency", G_TYPE_UINT64, (guint64)self->latency,
+                     "latency-max", G_TYPE_UINT64, (guint64)self->latency_max,
+                     "dropped-bytes", G_TYPE_UINT64, self->dropped_bytes,
+                     NULL);
+  GST_OBJECT_UNLOCK (self);
+}
+
 static void
 gst_deepgram_sink_get_property (GObject* object, guint prop_id, GValue* value,
                                 GParamSpec* pspec)
@@ -175,48 +890,360 @@ gst_deepgram_sink_get_property (GObject* object, guint prop_id, GValue* value,
     case PROP_SILENT:
       g_value_set_boolean (value, self->silent);
       break;
+    case PROP_ENDPOINT:
+      g_value_set_string (value, self->endpoint);
+      break;
+    case PROP_QUERY_PARAMS:
+      g_value_set_boxed (value, self->query_params);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_value_set_uint64 (value, self->max_queue_time);
+      break;
+    case PROP_LEAKY:
+      g_value_set_enum (value, self->leaky);
+      break;
+    case PROP_SPOOL_DIR:
+      g_value_set_string (value, self->spool_dir);
+      break;
+    case PROP_RECORD_TO:
+      g_value_set_string (value, self->record_to);
+      break;
+    case PROP_RECORD_AUDIO:
+      g_value_set_boolean (value, self->record_audio);
+      break;
+    case PROP_FRAME_DURATION:
+      g_value_set_uint64 (value, self->frame_duration);
+      break;
+    case PROP_MAX_FRAME_DELAY:
+      g_value_set_uint64 (value, self->max_frame_delay);
+      break;
+    case PROP_MODE:
+      g_value_set_enum (value, self->mode);
+      break;
+    case PROP_MAX_RATE:
+      g_value_set_double (value, self->max_rate);
+      break;
+    case PROP_TRANSPORT:
+      g_value_set_enum (value, self->transport);
+      break;
+    case PROP_CHUNK_DURATION:
+      g_value_set_uint64 (value, self->chunk_duration);
+      break;
+    case PROP_MAX_UPLOADS:
+      g_value_set_uint (value, self->max_uploads);
+      break;
+    case PROP_DRAIN_TIMEOUT:
+      g_value_set_uint64 (value, self->drain_timeout);
+      break;
+    case PROP_LAST_DRAIN_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->last_drain_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PREWARM:
+      g_value_set_boolean (value, self->prewarm);
+      break;
+    case PROP_KEEPALIVE_INTERVAL:
+      g_value_set_uint64 (value, self->keepalive_interval);
+      break;
+    case PROP_MAX_RECONNECTS:
+      g_value_set_uint (value, self->max_reconnects);
+      break;
+    case PROP_REPLAY_DURATION:
+      g_value_set_uint64 (value, self->replay_duration);
+      break;
+    case PROP_DEDICATED_THREAD:
+      g_value_set_boolean (value, self->dedicated_thread);
+      break;
+    case PROP_ENCODING:
+      g_value_set_enum (value, self->encoding);
+      break;
+    case PROP_BITRATE:
+      g_value_set_uint (value, self->bitrate);
+      break;
+    case PROP_VAD_THRESHOLD:
+      g_value_set_double (value, self->vad_threshold);
+      break;
+    case PROP_VAD_HANGOVER:
+      g_value_set_uint64 (value, self->vad_hangover);
+      break;
+    case PROP_MULTICHANNEL:
+      g_value_set_boolean (value, self->multichannel);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint64 (value, self->stats_interval);
+      break;
+    case PROP_STATS:
+      {
+        GST_OBJECT_LOCK (self);
+        DeepgramWS* ws = self->ws ? g_object_ref (self->ws) : NULL;
+        GST_OBJECT_UNLOCK (self);
+
+        GstStructure* stats = ws ? deepgram_ws_get_stats (ws) : NULL;
+        if (stats)
+          gst_deepgram_sink_add_stats (self, stats);
+        g_value_take_boxed (value, stats);
+        g_clear_object (&ws);
+        break;
+      }
+    case PROP_VAD_SUPPRESSED:
+      GST_OBJECT_LOCK (self);
+      g_value_set_double (value, self->in_bytes > 0
+                                     ? (gdouble)self->suppressed_bytes
+                                           / self->in_bytes
+                                     : 0.0);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_RECONNECTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->reconnects);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_OUTAGE_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->outage_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
     }
 }
 
+/* Creates the DeepgramWS from the current properties and starts connecting
+ * on its thread. */
 static gboolean
-gst_deepgram_sink_start (GstBaseSink* basesink)
+gst_deepgram_sink_open_ws (GstDeepgramSink* self)
 {
-  GstDeepgramSink* self = GST_DEEPGRAM_SINK (basesink);
-
-  g_print ("[deepgramsink] Starting\n");
-
   if (!self->api_key || strlen (self->api_key) == 0)
     {
       g_printerr ("[deepgramsink] ERROR: no Deepgram API key set.\n");
       return FALSE;
     }
 
-  self->ws = deepgram_ws_new ();
+  DeepgramWS* ws = deepgram_ws_new ();
+  GST_OBJECT_LOCK (self);
+  self->ws = ws;
+  GST_OBJECT_UNLOCK (self);
 
   g_object_set (self->ws, "api-key", self->api_key, NULL);
   g_object_set (self->ws, "model", self->model, NULL);
   g_object_set (self->ws, "silent", self->silent, NULL);
+  g_object_set (self->ws, "endpoint", self->endpoint, NULL);
+  g_object_set (self->ws, "query-params", self->query_params, NULL);
+  g_object_set (self->ws, "max-queue-bytes",
+                gst_deepgram_sink_max_queue_bytes (self), NULL);
+  if (self->mode == GST_DEEPGRAM_SINK_MODE_BATCH)
+    {
+      /* A file must never lose audio: block upstream instead of dropping,
+       * and let the queue limit pace the source. */
+      g_object_set (self->ws, "leaky", DEEPGRAM_WS_LEAKY_NO, NULL);
+      g_object_set (self->ws, "max-send-rate",
+                    (guint64)(self->max_rate
+                              * gst_deepgram_sink_bytes_per_second (self)),
+                    NULL);
+    }
+  else
+    {
+      /* Live audio cannot wait; with a spool it is not dropped either. A
+       * file does not need one, it is paced by the queue limit instead. */
+      g_object_set (self->ws, "leaky", self->leaky, NULL);
+      g_object_set (self->ws, "spool-dir", self->spool_dir, NULL);
+    }
+  g_object_set (self->ws, "frame-bytes", gst_deepgram_sink_frame_bytes (self),
+                NULL);
+  g_object_set (self->ws, "max-frame-delay", self->max_frame_delay, NULL);
+  /* With silence held back, KeepAlive is all that keeps Deepgram from
+   * closing the connection between utterances. */
+  g_object_set (self->ws, "keepalive-interval",
+                self->keepalive_interval == 0
+                        && gst_deepgram_sink_vad_enabled (self)
+                    ? DEFAULT_KEEPALIVE
+                    : self->keepalive_interval,
+                NULL);
+  g_object_set (self->ws, "max-reconnects", self->max_reconnects, NULL);
+  g_object_set (self->ws, "dedicated-thread", self->dedicated_thread, NULL);
+  g_object_set (self->ws, "encoding", self->encoding, NULL);
+  g_object_set (self->ws, "bitrate", self->bitrate, NULL);
+  g_object_set (self->ws, "replay-bytes",
+                gst_util_uint64_scale (
+                    self->replay_duration,
+                    gst_deepgram_sink_bytes_per_second (self), GST_SECOND),
+                NULL);
+  g_object_set (self->ws, "channels", self->out_channels, NULL);
+  g_object_set (self->ws, "multichannel", self->out_channels > 1, NULL);
+  g_object_set (self->ws, "stats-interval", self->stats_interval, NULL);
+  g_object_set (self->ws, "record-to", self->record_to, NULL);
+  g_object_set (self->ws, "record-audio", self->record_audio, NULL);
+  g_object_set (self->ws, "transport", self->transport, NULL);
+  g_object_set (self->ws, "chunk-bytes",
+                gst_util_uint64_scale (
+                    self->chunk_duration,
+                    gst_deepgram_sink_bytes_per_second (self), GST_SECOND),
+                NULL);
+  g_object_set (self->ws, "max-uploads", self->max_uploads, NULL);
+
+  GST_OBJECT_LOCK (self);
+  self->reconnects       = 0;
+  self->outage_time      = 0;
+  self->in_bytes         = 0;
+  self->suppressed_bytes = 0;
+  self->next_original    = 0;
+  self->latency          = GST_CLOCK_TIME_NONE;
+  self->latency_max      = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->gaps_lock);
+  self->sent_bytes = 0;
+  g_array_set_size (self->gaps, 0);
+  g_mutex_unlock (&self->gaps_lock);
+
+  g_mutex_lock (&self->marks_lock);
+  g_array_set_size (self->marks, 0);
+  g_mutex_unlock (&self->marks_lock);
 
   g_signal_connect (self->ws, "transcript",
                     G_CALLBACK (gst_deepgram_sink_on_deepgram_transcript),
                     self);
 
-  g_signal_connect (self->ws, "word",
-                    G_CALLBACK (gst_deepgram_sink_on_deepgram_word), self);
+  g_signal_connect (self->ws, "words",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_words), self);
+
+  g_signal_connect (self->ws, "audio-dropped",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_audio_dropped),
+                    self);
+
+  g_signal_connect (self->ws, "audio-removed",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_audio_removed),
+                    self);
+
+  g_signal_connect (self->ws, "reconnected",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_reconnected),
+                    self);
+
+  g_signal_connect (self->ws, "chunk-failed",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_chunk_failed),
+                    self);
+
+  g_signal_connect (self->ws, "stats",
+                    G_CALLBACK (gst_deepgram_sink_on_deepgram_stats), self);
 
   if (!deepgram_ws_start (self->ws))
     {
       g_printerr ("[deepgramsink] Failed to start DeepgramWS.\n");
-      g_clear_object (&self->ws);
+      GST_OBJECT_LOCK (self);
+      self->ws = NULL;
+      GST_OBJECT_UNLOCK (self);
+      g_object_unref (ws);
       return FALSE;
     }
 
   return TRUE;
 }
 
+static void
+gst_deepgram_sink_close_ws (GstDeepgramSink* self)
+{
+  GST_OBJECT_LOCK (self);
+  DeepgramWS* ws = g_steal_pointer (&self->ws);
+  GST_OBJECT_UNLOCK (self);
+
+  if (ws)
+    {
+      deepgram_ws_stop (ws);
+      g_object_unref (ws);
+    }
+}
+
+static GstStateChangeReturn
+gst_deepgram_sink_change_state (GstElement* element, GstStateChange transition)
+{
+  GstDeepgramSink*     self = GST_DEEPGRAM_SINK (element);
+  GstStateChangeReturn ret;
+
+  /* Pre-warming pays the TLS handshake and HTTP upgrade while the rest of
+   * the pipeline is still being set up, so the first audio buffer can go
+   * out immediately. */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY && self->prewarm)
+    {
+      g_print ("[deepgramsink] Pre-warming connection\n");
+      if (!gst_deepgram_sink_open_ws (self))
+        return GST_STATE_CHANGE_FAILURE;
+    }
+
+  ret = GST_ELEMENT_CLASS (gst_deepgram_sink_parent_class)
+            ->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_READY_TO_NULL
+      || (transition == GST_STATE_CHANGE_NULL_TO_READY
+          && ret == GST_STATE_CHANGE_FAILURE))
+    {
+      gst_deepgram_sink_close_ws (self);
+    }
+
+  return ret;
+}
+
+/* Throws away the audio still queued on the connection and anything the
+ * VAD holds back. Results for it will not come, so the marks and gaps kept
+ * for them go as well; the next audio sent is the input's from in_bytes
+ * on. Where the connection takes the queued audio out of its stream is
+ * reported by "audio-removed", which moves that point along. */
+static void
+gst_deepgram_sink_realign (GstDeepgramSink* self)
+{
+  deepgram_ws_discard_queued (self->ws);
+  if (self->vad)
+    deepgram_vad_reset (self->vad);
+
+  GST_OBJECT_LOCK (self);
+  guint64 in_bytes = self->in_bytes;
+  GST_OBJECT_UNLOCK (self);
+  self->next_original = in_bytes;
+
+  g_mutex_lock (&self->gaps_lock);
+  GstDeepgramSinkGap gap = { self->sent_bytes, in_bytes };
+  g_array_set_size (self->gaps, 0);
+  g_array_append_val (self->gaps, gap);
+  g_mutex_lock (&self->marks_lock);
+  g_array_set_size (self->marks, 0);
+  g_mutex_unlock (&self->marks_lock);
+  g_mutex_unlock (&self->gaps_lock);
+}
+
+static gboolean
+gst_deepgram_sink_start (GstBaseSink* basesink)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (basesink);
+
+  g_print ("[deepgramsink] Starting\n");
+
+  GST_OBJECT_LOCK (self);
+  self->dropped_bytes = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  /* Reuse a pre-warmed (or kept) connection unless it was closed by an EOS
+   * drain or by the server. The audio of a previous run was discarded by
+   * stop; this run's input starts at the connection's current offset and
+   * its statistics start from scratch. */
+  if (self->ws && deepgram_ws_is_running (self->ws))
+    {
+      GST_OBJECT_LOCK (self);
+      self->in_bytes         = 0;
+      self->suppressed_bytes = 0;
+      self->latency          = GST_CLOCK_TIME_NONE;
+      self->latency_max      = GST_CLOCK_TIME_NONE;
+      GST_OBJECT_UNLOCK (self);
+
+      gst_deepgram_sink_realign (self);
+      return TRUE;
+    }
+
+  gst_deepgram_sink_close_ws (self);
+
+  return gst_deepgram_sink_open_ws (self);
+}
+
 static gboolean
 gst_deepgram_sink_stop (GstBaseSink* basesink)
 {
@@ -224,15 +1251,388 @@ gst_deepgram_sink_stop (GstBaseSink* basesink)
 
   g_print ("[deepgramsink] Stopping\n");
 
-  if (self->ws)
+  g_clear_pointer (&self->converters, g_ptr_array_unref);
+
+  if (self->vad)
     {
-      deepgram_ws_stop (self->ws);
-      g_clear_object (&self->ws);
+      GST_OBJECT_LOCK (self);
+      guint64 in_bytes   = self->in_bytes;
+      guint64 suppressed = self->suppressed_bytes;
+      GST_OBJECT_UNLOCK (self);
+
+      g_print ("[deepgramsink] VAD held back %.1f%% of %.1f s of audio\n",
+               in_bytes > 0 ? 100.0 * suppressed / in_bytes : 0.0,
+               (gdouble)in_bytes / gst_deepgram_sink_bytes_per_second (self));
+      g_clear_pointer (&self->vad, deepgram_vad_free);
     }
 
+  if (self->prewarm && self->ws)
+    {
+      /* Keep the connection for the next start; only the queued audio of
+       * this run is stale. */
+      gst_deepgram_sink_realign (self);
+      return TRUE;
+    }
+
+  gst_deepgram_sink_close_ws (self);
+
   return TRUE;
 }
 
+/* Sends whatever is still queued plus CloseStream and waits (up to
+ * drain-timeout) for the final transcripts, so the tail of the stream is not
+ * lost when EOS tears the connection down. */
+static void
+gst_deepgram_sink_drain (GstDeepgramSink* self)
+{
+  GST_INFO_OBJECT (self, "EOS, draining queued audio");
+
+  gint64   start    = g_get_monotonic_time ();
+  gboolean finished = deepgram_ws_drain (self->ws, self->drain_timeout);
+  guint64  elapsed  = (g_get_monotonic_time () - start) * GST_USECOND;
+
+  GST_OBJECT_LOCK (self);
+  self->last_drain_time = elapsed;
+  GST_OBJECT_UNLOCK (self);
+
+  if (finished)
+    GST_INFO_OBJECT (self, "Drained in %" GST_TIME_FORMAT,
+                     GST_TIME_ARGS (elapsed));
+  else
+    GST_WARNING_OBJECT (self,
+                        "Timed out waiting for final transcripts after %"
+                        GST_TIME_FORMAT,
+                        GST_TIME_ARGS (elapsed));
+
+  gst_element_post_message (
+      GST_ELEMENT (self),
+      gst_message_new_element (
+          GST_OBJECT (self),
+          gst_structure_new ("deepgram-drained", "drain-time", G_TYPE_UINT64,
+                             elapsed, "timed-out", G_TYPE_BOOLEAN, !finished,
+                             NULL)));
+}
+
+static gboolean
+gst_deepgram_sink_event (GstBaseSink* basesink, GstEvent* event)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (basesink);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS && self->ws
+      && self->drain_timeout > 0)
+    {
+      gst_deepgram_sink_drain (self);
+    }
+
+  /* A flushing seek keeps the connection; only audio queued before the
+   * seek is thrown away. */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP && self->ws)
+    gst_deepgram_sink_realign (self);
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP && self->converters)
+    g_ptr_array_foreach (self->converters, (GFunc)deepgram_converter_reset,
+                         NULL);
+
+  return GST_BASE_SINK_CLASS (gst_deepgram_sink_parent_class)
+      ->event (basesink, event);
+}
+
+/* S16LE at 16 kHz goes out as is if it is mono, or with multichannel;
+ * anything else is downmixed (or split into channels), converted and
+ * resampled in one pass per buffer, saving the audioconvert !
+ * audioresample chain otherwise needed in front. */
+static gboolean
+gst_deepgram_sink_set_caps (GstBaseSink* basesink, GstCaps* caps)
+{
+  GstDeepgramSink* self      = GST_DEEPGRAM_SINK (basesink);
+  GstStructure*    structure = gst_caps_get_structure (caps, 0);
+  const gchar*     format    = gst_structure_get_string (structure, "format");
+  gint             rate      = 0;
+  gint             channels  = 0;
+
+  if (!format || !gst_structure_get_int (structure, "rate", &rate)
+      || !gst_structure_get_int (structure, "channels", &channels))
+    {
+      GST_ERROR_OBJECT (self, "Invalid caps %" GST_PTR_FORMAT, caps);
+      return FALSE;
+    }
+
+  DeepgramSampleFormat sample_format = g_str_equal (format, "F32LE")
+                                           ? DEEPGRAM_SAMPLE_F32LE
+                                           : DEEPGRAM_SAMPLE_S16LE;
+
+  guint out_channels = self->multichannel ? (guint)channels : 1;
+  if (out_channels != self->out_channels)
+    {
+      /* The channel count is part of the connection URL. */
+      self->out_channels = out_channels;
+      if (self->ws)
+        {
+          GST_INFO_OBJECT (self, "Reconnecting for %u channels", out_channels);
+          gst_deepgram_sink_close_ws (self);
+          if (!gst_deepgram_sink_open_ws (self))
+            return FALSE;
+        }
+    }
+
+  g_clear_pointer (&self->converters, g_ptr_array_unref);
+  self->in_bpf = channels
+                 * (sample_format == DEEPGRAM_SAMPLE_F32LE
+                        ? 4
+                        : DEEPGRAM_SINK_BYTES_PER_SAMPLE);
+
+  if (sample_format != DEEPGRAM_SAMPLE_S16LE || rate != DEEPGRAM_SINK_RATE
+      || (guint)channels != out_channels)
+    {
+      self->converters = g_ptr_array_new_with_free_func (
+          (GDestroyNotify)deepgram_converter_free);
+      if (out_channels == 1)
+        g_ptr_array_add (self->converters,
+                         deepgram_converter_new (sample_format, rate, channels,
+                                                 DEEPGRAM_SINK_RATE));
+      for (guint c = 0; out_channels > 1 && c < out_channels; c++)
+        g_ptr_array_add (self->converters,
+                         deepgram_converter_new_channel (
+                             sample_format, rate, channels, c,
+                             DEEPGRAM_SINK_RATE));
+
+      GST_INFO_OBJECT (self, "Converting %s %d Hz x%d to S16LE %d Hz x%u (%s)",
+                       format, rate, channels, DEEPGRAM_SINK_RATE,
+                       out_channels, deepgram_converter_get_simd ());
+    }
+
+  g_clear_pointer (&self->vad, deepgram_vad_free);
+  if (gst_deepgram_sink_vad_enabled (self))
+    {
+      self->vad = deepgram_vad_new (DEEPGRAM_SINK_RATE, out_channels,
+                                    self->vad_threshold, self->vad_hangover,
+                                    DEEPGRAM_SINK_VAD_PREROLL);
+      GST_INFO_OBJECT (self, "Holding back audio below %.1f dBFS (%s)",
+                       self->vad_threshold, deepgram_vad_get_simd ());
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gst_deepgram_sink_unlock (GstBaseSink* basesink)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (basesink);
+
+  if (self->ws)
+    deepgram_ws_set_flushing (self->ws, TRUE);
+
+  return TRUE;
+}
+
+static gboolean
+gst_deepgram_sink_unlock_stop (GstBaseSink* basesink)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (basesink);
+
+  if (self->ws)
+    deepgram_ws_set_flushing (self->ws, FALSE);
+
+  return TRUE;
+}
+
+/* Hands size bytes of audio, starting original bytes into the input, to
+ * the connection, noting a gap if audio before it was held back. */
+static void
+gst_deepgram_sink_note_sent (GstDeepgramSink* self, guint64 original,
+                             gsize size)
+{
+  g_mutex_lock (&self->gaps_lock);
+  if (original != self->next_original)
+    {
+      GstDeepgramSinkGap gap = { self->sent_bytes, original };
+      guint              n   = self->gaps->len;
+      if (n > 0
+          && g_array_index (self->gaps, GstDeepgramSinkGap, n - 1).sent
+                 == gap.sent)
+        g_array_index (self->gaps, GstDeepgramSinkGap, n - 1) = gap;
+      else
+        g_array_append_val (self->gaps, gap);
+    }
+  self->sent_bytes += size;
+  g_mutex_unlock (&self->gaps_lock);
+
+  self->next_original = original + size;
+}
+
+/* Sends the stretches of buffer the VAD lets through, as sub-buffers
+ * sharing its memory. When the gate closes, Deepgram is asked to finalize
+ * what it has instead of waiting for audio that will not come. */
+static GstFlowReturn
+gst_deepgram_sink_send_gated (GstDeepgramSink* self, GstBuffer* buffer)
+{
+  GstMapInfo    map;
+  const guint8* preroll;
+  gsize         preroll_size;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return GST_FLOW_ERROR;
+
+  gboolean was_open = deepgram_vad_is_open (self->vad);
+  g_array_set_size (self->vad_runs, 0);
+  deepgram_vad_process (self->vad, map.data, map.size, self->vad_runs,
+                        &preroll, &preroll_size);
+
+  guint64       base       = self->in_bytes;
+  gint64        suppressed = 0;
+  GstFlowReturn ret        = GST_FLOW_OK;
+
+  if (preroll_size > 0)
+    {
+      /* Held back with an earlier buffer, sent after all. */
+      gst_deepgram_sink_note_sent (self, base - preroll_size, preroll_size);
+      ret = deepgram_ws_push_audio (self->ws, preroll, preroll_size);
+      suppressed -= (gint64)preroll_size;
+    }
+  gst_buffer_unmap (buffer, &map);
+
+  for (guint i = 0; i < self->vad_runs->len && ret == GST_FLOW_OK; i++)
+    {
+      DeepgramVadRun* run = &g_array_index (self->vad_runs, DeepgramVadRun, i);
+
+      if (!run->send)
+        {
+          suppressed += run->size;
+          continue;
+        }
+
+      gst_deepgram_sink_note_sent (self, base + run->offset, run->size);
+      if (run->size == map.size)
+        {
+          ret = deepgram_ws_push_buffer (self->ws, buffer);
+        }
+      else
+        {
+          GstBuffer* part = gst_buffer_copy_region (
+              buffer, GST_BUFFER_COPY_MEMORY, run->offset, run->size);
+          ret = deepgram_ws_push_buffer (self->ws, part);
+          gst_buffer_unref (part);
+        }
+    }
+
+  GST_OBJECT_LOCK (self);
+  self->in_bytes += map.size;
+  self->suppressed_bytes += suppressed;
+  GST_OBJECT_UNLOCK (self);
+
+  if (ret == GST_FLOW_OK && (was_open || self->vad_runs->len > 1)
+      && !deepgram_vad_is_open (self->vad))
+    {
+      GST_LOG_OBJECT (self, "Silence, finalizing");
+      deepgram_ws_finalize (self->ws);
+    }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_deepgram_sink_send (GstDeepgramSink* self, GstBuffer* buffer)
+{
+  if (self->vad)
+    return gst_deepgram_sink_send_gated (self, buffer);
+
+  g_mutex_lock (&self->gaps_lock);
+  self->sent_bytes += gst_buffer_get_size (buffer);
+  g_mutex_unlock (&self->gaps_lock);
+
+  GST_OBJECT_LOCK (self);
+  self->in_bytes += gst_buffer_get_size (buffer);
+  GST_OBJECT_UNLOCK (self);
+
+  return deepgram_ws_push_buffer (self->ws, buffer);
+}
+
+/* The converted audio is handed over without another copy. With several
+ * channels, each converter's output is interleaved into place; they all
+ * see the same input, so they produce the same number of frames. */
+static GstFlowReturn
+gst_deepgram_sink_render_converted (GstDeepgramSink* self, GstBuffer* buffer)
+{
+  GstMapInfo map;
+  guint      n_out = self->converters->len;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return GST_FLOW_ERROR;
+
+  gsize in_frames = map.size / self->in_bpf;
+  gsize max_out   = deepgram_converter_get_max_output (
+      g_ptr_array_index (self->converters, 0), in_frames);
+  gint16* out        = g_new (gint16, max_out * n_out);
+  gsize   out_frames = 0;
+
+  if (n_out == 1)
+    {
+      out_frames = deepgram_converter_process (
+          g_ptr_array_index (self->converters, 0), map.data, in_frames, out);
+    }
+  else
+    {
+      gint16* mono = g_new (gint16, max_out);
+      for (guint c = 0; c < n_out; c++)
+        {
+          out_frames = deepgram_converter_process (
+              g_ptr_array_index (self->converters, c), map.data, in_frames,
+              mono);
+          for (gsize i = 0; i < out_frames; i++)
+            out[i * n_out + c] = mono[i];
+        }
+      g_free (mono);
+    }
+  gst_buffer_unmap (buffer, &map);
+
+  if (out_frames == 0)
+    {
+      g_free (out);
+      return GST_FLOW_OK;
+    }
+
+  GstBuffer* converted = gst_buffer_new_wrapped (
+      out, out_frames * gst_deepgram_sink_block_align (self));
+  GstFlowReturn ret = gst_deepgram_sink_send (self, converted);
+  gst_buffer_unref (converted);
+
+  return ret;
+}
+
+/* Remembers when the audio sent so far was rendered, and where it ends in
+ * running time, for the latency of the results that cover it. */
+static void
+gst_deepgram_sink_mark_sent (GstDeepgramSink* self, GstBuffer* buffer)
+{
+  GstClockTime end = GST_BUFFER_PTS (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (end) && GST_BUFFER_DURATION_IS_VALID (buffer))
+    end += GST_BUFFER_DURATION (buffer);
+
+  GstDeepgramSinkMark mark = {
+    0,
+    gst_segment_to_running_time (&GST_BASE_SINK (self)->segment,
+                                 GST_FORMAT_TIME, end),
+    g_get_monotonic_time () * 1000,
+  };
+
+  /* Audio the connection dropped meanwhile is already taken out of
+   * sent_bytes; gaps_lock keeps it from moving until the mark is in. */
+  g_mutex_lock (&self->gaps_lock);
+  mark.sent = self->sent_bytes;
+  g_mutex_lock (&self->marks_lock);
+  guint n = self->marks->len;
+  if (n == 0
+      || g_array_index (self->marks, GstDeepgramSinkMark, n - 1).sent
+             < mark.sent)
+    {
+      if (n >= DEEPGRAM_SINK_MAX_MARKS)
+        g_array_remove_range (self->marks, 0, n / 2);
+      g_array_append_val (self->marks, mark);
+    }
+  g_mutex_unlock (&self->marks_lock);
+  g_mutex_unlock (&self->gaps_lock);
+}
+
 static GstFlowReturn
 gst_deepgram_sink_render (GstBaseSink* basesink, GstBuffer* buffer)
 {
@@ -241,51 +1641,393 @@ gst_deepgram_sink_render (GstBaseSink* basesink, GstBuffer* buffer)
   if (!self->ws)
     return GST_FLOW_OK;
 
-  GstMapInfo map;
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+  GstFlowReturn ret;
+  if (self->converters)
+    ret = gst_deepgram_sink_render_converted (self, buffer);
+  else
+    ret = gst_deepgram_sink_send (self, buffer);
+
+  if (ret == GST_FLOW_OK)
+    gst_deepgram_sink_mark_sent (self, buffer);
+
+  if (ret == GST_FLOW_ERROR)
     {
-      return GST_FLOW_ERROR;
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+                         ("Failed to map audio buffer"));
     }
 
-  deepgram_ws_push_audio (self->ws, map.data, map.size);
+  return ret;
+}
 
-  gst_buffer_unmap (buffer, &map);
-  return GST_FLOW_OK;
+/* Called whenever the bounded queue drops audio: from the streaming thread
+ * when it is full, or from the connection's worker when leaky=downstream
+ * trims the backlog. */
+static void
+gst_deepgram_sink_on_deepgram_audio_dropped (DeepgramWS* ws, guint64 bytes,
+                                             gpointer user_data)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
+
+  GST_OBJECT_LOCK (self);
+  self->dropped_bytes += bytes;
+  guint64 total = self->dropped_bytes;
+  GST_OBJECT_UNLOCK (self);
+
+  guint64 duration = gst_util_uint64_scale (
+      bytes, GST_SECOND, gst_deepgram_sink_bytes_per_second (self));
+
+  GST_WARNING_OBJECT (self, "Queue full, dropped %" G_GUINT64_FORMAT
+                      " bytes (%" GST_TIME_FORMAT ")",
+                      bytes, GST_TIME_ARGS (duration));
+
+  gst_element_post_message (
+      GST_ELEMENT (self),
+      gst_message_new_element (
+          GST_OBJECT (self),
+          gst_structure_new ("deepgram-audio-dropped", "bytes", G_TYPE_UINT64,
+                             bytes, "duration", G_TYPE_UINT64, duration,
+                             "total-bytes", G_TYPE_UINT64, total,
+                             NULL)));
+}
+
+/* Number of gaps starting at or (with is_end, strictly) before sent bytes
+ * into the connection's stream. Called with gaps_lock held. */
+static guint
+gst_deepgram_sink_count_gaps_at (GstDeepgramSink* self, guint64 bytes,
+                                 gboolean is_end)
+{
+  guint lo = 0;
+  guint hi = self->gaps->len;
+
+  while (lo < hi)
+    {
+      guint   mid  = (lo + hi) / 2;
+      guint64 sent = g_array_index (self->gaps, GstDeepgramSinkGap, mid).sent;
+      if (sent < bytes || (!is_end && sent == bytes))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/* Called from the streaming thread or the connection's worker when bytes
+ * of queued audio at offset on the connection's stream never reached
+ * Deepgram. Its times leave them out, so what was sent after them moves
+ * up; a mark ending inside them ends where they were. From offset on, the
+ * stream carries the input that followed them, noted as a gap replacing
+ * those inside them. */
+static void
+gst_deepgram_sink_on_deepgram_audio_removed (DeepgramWS* ws, guint64 offset,
+                                             guint64 bytes, gpointer user_data)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
+  guint64          end  = offset + bytes;
+
+  g_mutex_lock (&self->gaps_lock);
+  self->sent_bytes = self->sent_bytes > bytes ? self->sent_bytes - bytes : 0;
+
+  guint first = gst_deepgram_sink_count_gaps_at (self, offset, TRUE);
+  guint last  = gst_deepgram_sink_count_gaps_at (self, end, FALSE);
+
+  GstDeepgramSinkGap gap = { offset, end };
+  if (last > 0)
+    {
+      GstDeepgramSinkGap* prev
+          = &g_array_index (self->gaps, GstDeepgramSinkGap, last - 1);
+      gap.original = prev->original + (end - prev->sent);
+    }
+  g_array_remove_range (self->gaps, first, last - first);
+  g_array_insert_val (self->gaps, first, gap);
+  for (guint i = first + 1; i < self->gaps->len; i++)
+    g_array_index (self->gaps, GstDeepgramSinkGap, i).sent -= bytes;
+
+  g_mutex_lock (&self->marks_lock);
+  for (guint i = self->marks->len; i > 0; i--)
+    {
+      GstDeepgramSinkMark* mark
+          = &g_array_index (self->marks, GstDeepgramSinkMark, i - 1);
+      if (mark->sent <= offset)
+        break;
+      mark->sent = mark->sent > offset + bytes ? mark->sent - bytes : offset;
+    }
+  g_mutex_unlock (&self->marks_lock);
+  g_mutex_unlock (&self->gaps_lock);
+}
+
+/* Called from the connection's worker thread. */
+static void
+gst_deepgram_sink_on_deepgram_reconnected (DeepgramWS* ws, guint attempts,
+                                           guint64 outage, guint64 replayed,
+                                           gpointer user_data)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
+
+  GST_OBJECT_LOCK (self);
+  self->reconnects++;
+  self->outage_time += outage;
+  guint reconnects = self->reconnects;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_WARNING_OBJECT (self,
+                      "Reconnected after %u attempt(s), outage %" GST_TIME_FORMAT,
+                      attempts, GST_TIME_ARGS (outage));
+
+  gst_element_post_message (
+      GST_ELEMENT (self),
+      gst_message_new_element (
+          GST_OBJECT (self),
+          gst_structure_new (
+              "deepgram-reconnected", "attempts", G_TYPE_UINT, attempts,
+              "outage", G_TYPE_UINT64, outage, "replayed-bytes",
+              G_TYPE_UINT64, replayed, "reconnects", G_TYPE_UINT, reconnects,
+              NULL)));
+}
+
+/* Called from the connection's worker thread every stats-interval. */
+static void
+gst_deepgram_sink_on_deepgram_stats (DeepgramWS* ws, GstStructure* stats,
+                                     gpointer user_data)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
+  GstStructure*    copy = gst_structure_copy (stats);
+
+  gst_deepgram_sink_add_stats (self, copy);
+  gst_element_post_message (GST_ELEMENT (self),
+                            gst_message_new_element (GST_OBJECT (self), copy));
+}
+
+/* Number of gaps before time on the connection's timeline; an end time
+ * right at a gap still belongs to the audio before it. Called with
+ * gaps_lock held. */
+static guint
+gst_deepgram_sink_count_gaps (GstDeepgramSink* self, gdouble time,
+                              gboolean is_end)
+{
+  guint64 bytes
+      = (guint64)(MAX (time, 0.0) * gst_deepgram_sink_bytes_per_second (self));
+
+  return gst_deepgram_sink_count_gaps_at (self, bytes, is_end);
+}
+
+/* Deepgram's times leave out the audio the VAD held back and any the
+ * connection dropped; moves them back onto the input's timeline. */
+static gdouble
+gst_deepgram_sink_input_time (GstDeepgramSink* self, gdouble time,
+                              gboolean is_end)
+{
+  g_mutex_lock (&self->gaps_lock);
+  guint n = gst_deepgram_sink_count_gaps (self, time, is_end);
+  if (n > 0)
+    {
+      GstDeepgramSinkGap* gap
+          = &g_array_index (self->gaps, GstDeepgramSinkGap, n - 1);
+      time += (gdouble)(gap->original - gap->sent)
+              / gst_deepgram_sink_bytes_per_second (self);
+    }
+  g_mutex_unlock (&self->gaps_lock);
+
+  return time;
+}
+
+/* Called from the connection's worker thread when transport=http gave up
+ * on a chunk; its audio will never be transcribed. */
+static void
+gst_deepgram_sink_on_deepgram_chunk_failed (DeepgramWS* ws, gdouble start,
+                                            gdouble duration,
+                                            gpointer user_data)
+{
+  GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
+
+  gdouble end = gst_deepgram_sink_input_time (self, start + duration, TRUE);
+  start       = gst_deepgram_sink_input_time (self, start, FALSE);
+
+  GstClockTime start_time = (GstClockTime)(start * GST_SECOND);
+  GstClockTime length     = (GstClockTime)((end - start) * GST_SECOND);
+
+  GST_WARNING_OBJECT (self,
+                      "Upload failed, no transcript for %" GST_TIME_FORMAT
+                      " at %" GST_TIME_FORMAT,
+                      GST_TIME_ARGS (length), GST_TIME_ARGS (start_time));
+
+  gst_element_post_message (
+      GST_ELEMENT (self),
+      gst_message_new_element (
+          GST_OBJECT (self),
+          gst_structure_new ("deepgram-chunk-failed", "start", G_TYPE_UINT64,
+                             start_time, "duration", G_TYPE_UINT64, length,
+                             NULL)));
+}
+
+/* Results never reach back before the last final one, so neither do the
+ * gaps needed. */
+static void
+gst_deepgram_sink_prune_gaps (GstDeepgramSink* self, gdouble start_time)
+{
+  g_mutex_lock (&self->gaps_lock);
+  guint n = gst_deepgram_sink_count_gaps (self, start_time, FALSE);
+  if (n > 1)
+    g_array_remove_range (self->gaps, 0, n - 1);
+  g_mutex_unlock (&self->gaps_lock);
+}
+
+/* Capture-to-transcript latency: the time since the buffer holding the
+ * audio at end_time (on the connection's timeline) was rendered. Final
+ * results release the marks before them, as for the gaps. */
+static void
+gst_deepgram_sink_measure_latency (GstDeepgramSink* self, gdouble end_time,
+                                   gboolean is_final, guint channel)
+{
+  guint   rate = gst_deepgram_sink_bytes_per_second (self);
+  guint64 end  = (guint64)(MAX (end_time, 0.0) * rate);
+  gint64  now  = g_get_monotonic_time () * 1000;
+
+  g_mutex_lock (&self->marks_lock);
+  guint lo = 0;
+  guint hi = self->marks->len;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (g_array_index (self->marks, GstDeepgramSinkMark, mid).sent < end)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo == self->marks->len)
+    {
+      g_mutex_unlock (&self->marks_lock);
+      return;
+    }
+
+  GstDeepgramSinkMark mark = g_array_index (self->marks, GstDeepgramSinkMark,
+                                            lo);
+  if (is_final && self->out_channels == 1 && lo > 0)
+    g_array_remove_range (self->marks, 0, lo);
+  g_mutex_unlock (&self->marks_lock);
+
+  GstClockTime latency      = now > mark.rendered ? now - mark.rendered : 0;
+  GstClockTime running_time = mark.running_time;
+  if (GST_CLOCK_TIME_IS_VALID (running_time))
+    {
+      GstClockTime back
+          = gst_util_uint64_scale (mark.sent - end, GST_SECOND, rate);
+      running_time = running_time > back ? running_time - back : 0;
+    }
+
+  GST_OBJECT_LOCK (self);
+  self->latency = latency;
+  if (!GST_CLOCK_TIME_IS_VALID (self->latency_max)
+      || latency > self->latency_max)
+    self->latency_max = latency;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_LOG_OBJECT (self,
+                  "Result up to %" GST_TIME_FORMAT " after %" GST_TIME_FORMAT,
+                  GST_TIME_ARGS (running_time), GST_TIME_ARGS (latency));
+
+  g_signal_emit (self, gst_deepgram_sink_signals[SIGNAL_TRANSCRIPT_LATENCY], 0,
+                 (guint64)latency, (guint64)running_time, is_final, channel);
 }
 
 static void
 gst_deepgram_sink_on_deepgram_transcript (DeepgramWS* ws, const gchar* text,
                                           gboolean is_final, gdouble start_time,
-                                          gdouble end_time, gpointer user_data)
+                                          gdouble end_time, guint channel,
+                                          gpointer user_data)
 {
   GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
 
-  if (!self->silent)
+  /* Channels are finalised independently, so one channel's final result
+   * says nothing about another's; keep every gap then. */
+  gst_deepgram_sink_measure_latency (self, end_time, is_final, channel);
+
+  if (is_final && self->out_channels == 1)
+    gst_deepgram_sink_prune_gaps (self, start_time);
+  start_time = gst_deepgram_sink_input_time (self, start_time, FALSE);
+  end_time   = gst_deepgram_sink_input_time (self, end_time, TRUE);
+
+  if (!self->silent && self->out_channels > 1)
+    {
+      g_print ("[deepgramsink] => %s [%u]: %s\n",
+               is_final ? "Final" : "Partial", channel, text);
+    }
+  else if (!self->silent)
     {
       g_print ("[deepgramsink] => %s: %s\n", is_final ? "Final" : "Partial",
                text);
     }
 
   g_signal_emit (self, gst_deepgram_sink_signals[SIGNAL_TRANSCRIPT], 0, text,
-                 is_final, start_time, end_time);
+                 is_final, start_time, end_time, channel);
 }
 
+/* Re-emits a result's words in whichever form the application listens
+ * for; with no handlers connected nothing is marshalled at all. */
 static void
-gst_deepgram_sink_on_deepgram_word (DeepgramWS* ws, const gchar* word,
-                                    gdouble start_time, gdouble end_time,
-                                    gpointer user_data)
+gst_deepgram_sink_on_deepgram_words (DeepgramWS* ws, GArray* words,
+                                     gboolean is_final, guint channel,
+                                     gpointer user_data)
 {
   GstDeepgramSink* self = GST_DEEPGRAM_SINK (user_data);
 
-  g_signal_emit (self, gst_deepgram_sink_signals[SIGNAL_WORD], 0, word,
-                 start_time, end_time);
+  if (g_signal_has_handler_pending (
+          self, gst_deepgram_sink_signals[SIGNAL_WORD], 0, FALSE))
+    {
+      for (guint i = 0; i < words->len; i++)
+        {
+          DeepgramWord* word = &g_array_index (words, DeepgramWord, i);
+          if (word->text && *word->text)
+            {
+              g_signal_emit (
+                  self, gst_deepgram_sink_signals[SIGNAL_WORD], 0, word->text,
+                  gst_deepgram_sink_input_time (self, word->start, FALSE),
+                  gst_deepgram_sink_input_time (self, word->end, TRUE),
+                  channel);
+            }
+        }
+    }
+
+  if (g_signal_has_handler_pending (
+          self, gst_deepgram_sink_signals[SIGNAL_WORDS], 0, FALSE))
+    {
+      GVariantBuilder builder;
+
+      g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sddd)"));
+      for (guint i = 0; i < words->len; i++)
+        {
+          DeepgramWord* word = &g_array_index (words, DeepgramWord, i);
+          g_variant_builder_add (
+              &builder, "(sddd)", word->text ? word->text : "",
+              gst_deepgram_sink_input_time (self, word->start, FALSE),
+              gst_deepgram_sink_input_time (self, word->end, TRUE),
+              word->confidence);
+        }
+
+      GVariant* batch = g_variant_ref_sink (g_variant_builder_end (&builder));
+      g_signal_emit (self, gst_deepgram_sink_signals[SIGNAL_WORDS], 0, batch,
+                     is_final, channel);
+      g_variant_unref (batch);
+    }
 }
 
 static gboolean
 gst_deepgram_sink_plugin_init (GstPlugin* plugin)
 {
-  return gst_element_register (plugin, "deepgramsink", GST_RANK_NONE,
-                               GST_TYPE_DEEPGRAM_SINK);
+  if (!gst_element_register (plugin, "deepgramsink", GST_RANK_NONE,
+                             GST_TYPE_DEEPGRAM_SINK)
+      || !gst_element_register (plugin, "deepgramtranscribe", GST_RANK_NONE,
+                                GST_TYPE_DEEPGRAM_TRANSCRIBE))
+    return FALSE;
+
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  if (!gst_tracer_register (plugin, "deepgram-latency",
+                            GST_TYPE_DEEPGRAM_LATENCY_TRACER))
+    return FALSE;
+#endif
+
+  return TRUE;
 }
 
 #define PACKAGE "gst-deepgram"
@@ -0,0 +1,971 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstdeepgramtranscribe.h"
+
+#include <glib.h>
+#include <gst/gst.h>
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "deepgramws.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_deepgram_transcribe_debug);
+#define GST_CAT_DEFAULT gst_deepgram_transcribe_debug
+
+/* Maps a point of the Deepgram stream (bytes handed to DeepgramWS) to the
+ * running time of the audio there. A new anchor is added whenever the input
+ * is not contiguous, so gaps do not shift later transcripts. */
+typedef struct
+{
+  guint64      bytes;
+  GstClockTime running_time;
+} GstDeepgramTranscribeAnchor;
+
+struct _GstDeepgramTranscribe
+{
+  GstElement parent;
+
+  GstPad* sinkpad;
+  GstPad* srcpad;
+
+  gchar*        api_key;
+  gchar*        model;
+  gboolean      silent;
+  gchar*        endpoint;
+  GstStructure* query_params;
+  gboolean      interim_results;
+  guint64       drain_timeout;
+  guint64       max_queue_time;
+  gboolean      dedicated_thread;
+  guint64       latency;
+  DeepgramWS*   ws;
+
+  /* Negotiated output: application/x-json instead of text/x-raw. Written
+   * on the streaming thread and read on the worker, under lock. */
+  gboolean json;
+
+  /* Input segment and timeline, guarded by the object lock: written on the
+   * streaming thread, read on the connection's worker. */
+  GstSegment segment;
+  GArray*    anchors; /* GstDeepgramTranscribeAnchor */
+  guint64    pushed_bytes;
+
+  /* Words of the result being delivered, from "words" to "transcript";
+   * only touched on the worker. */
+  JsonArray* pending_words;
+
+  /* Buffers and serialized events on their way to the source pad task,
+   * which pushes them downstream so the worker never blocks on it. */
+  GMutex        lock;
+  GCond         cond;
+  GQueue        queue;
+  gboolean      flushing;
+  GstFlowReturn src_result;
+};
+
+/* The sink caps are fixed to S16LE mono 16 kHz, as for deepgramsink. */
+#define DEEPGRAM_TRANSCRIBE_BYTES_PER_SECOND (16000 * 2)
+
+/* Timestamps further than this from where the audio so far would put a
+ * buffer start a new anchor. */
+#define DEEPGRAM_TRANSCRIBE_TOLERANCE (20 * GST_MSECOND)
+
+#define DEFAULT_ENDPOINT         "wss://api.deepgram.com/v1/listen"
+#define DEFAULT_INTERIM_RESULTS  FALSE
+#define DEFAULT_DRAIN_TIMEOUT    (10 * GST_SECOND)
+#define DEFAULT_MAX_QUEUE_TIME   (5 * GST_SECOND)
+#define DEFAULT_DEDICATED_THREAD FALSE
+
+/* How long after its audio a transcript is expected downstream: Deepgram
+ * finalises an utterance after about a second of audio plus endpointing,
+ * and the result then has to come back over the network. */
+#define DEFAULT_LATENCY (3 * GST_SECOND)
+
+G_DEFINE_TYPE (GstDeepgramTranscribe, gst_deepgram_transcribe,
+               GST_TYPE_ELEMENT)
+
+enum
+{
+  PROP_0,
+  PROP_API_KEY,
+  PROP_MODEL,
+  PROP_SILENT,
+  PROP_ENDPOINT,
+  PROP_QUERY_PARAMS,
+  PROP_INTERIM_RESULTS,
+  PROP_DRAIN_TIMEOUT,
+  PROP_MAX_QUEUE_TIME,
+  PROP_DEDICATED_THREAD,
+  PROP_LATENCY
+};
+
+static GstStaticPadTemplate sink_template
+    = GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+                               GST_STATIC_CAPS ("audio/x-raw, "
+                                                "format = (string) S16LE, "
+                                                "rate = (int) 16000, "
+                                                "channels = (int) 1"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE (
+    "src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("text/x-raw, format = (string) utf8; "
+                     "application/x-json"));
+
+static void gst_deepgram_transcribe_finalize (GObject* object);
+static void gst_deepgram_transcribe_set_property (GObject*      object,
+                                                  guint         prop_id,
+                                                  const GValue* value,
+                                                  GParamSpec*   pspec);
+static void gst_deepgram_transcribe_get_property (GObject* object,
+                                                  guint    prop_id,
+                                                  GValue*  value,
+                                                  GParamSpec* pspec);
+static GstStateChangeReturn
+gst_deepgram_transcribe_change_state (GstElement*    element,
+                                      GstStateChange transition);
+static GstFlowReturn gst_deepgram_transcribe_chain (GstPad*    pad,
+                                                    GstObject* parent,
+                                                    GstBuffer* buffer);
+static gboolean gst_deepgram_transcribe_sink_event (GstPad*    pad,
+                                                    GstObject* parent,
+                                                    GstEvent*  event);
+static gboolean gst_deepgram_transcribe_src_query (GstPad*    pad,
+                                                   GstObject* parent,
+                                                   GstQuery*  query);
+static gboolean gst_deepgram_transcribe_src_activate_mode (GstPad*    pad,
+                                                           GstObject* parent,
+                                                           GstPadMode mode,
+                                                           gboolean   active);
+static void gst_deepgram_transcribe_on_deepgram_words (DeepgramWS* ws,
+                                                       GArray*     words,
+                                                       gboolean    is_final,
+                                                       guint       channel,
+                                                       gpointer    user_data);
+static void gst_deepgram_transcribe_on_deepgram_transcript (
+    DeepgramWS* ws, const gchar* text, gboolean is_final, gdouble start_time,
+    gdouble end_time, guint channel, gpointer user_data);
+
+static void
+gst_deepgram_transcribe_class_init (GstDeepgramTranscribeClass* klass)
+{
+  GObjectClass*    gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass* element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize     = gst_deepgram_transcribe_finalize;
+  gobject_class->set_property = gst_deepgram_transcribe_set_property;
+  gobject_class->get_property = gst_deepgram_transcribe_get_property;
+
+  g_object_class_install_property (
+      gobject_class, PROP_API_KEY,
+      g_param_spec_string ("deepgram-api-key", "Deepgram API Key",
+                           "API key for Deepgram real-time transcription", NULL,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MODEL,
+      g_param_spec_string ("model", "Deepgram Model",
+                           "Deepgram model (e.g., 'nova')", "general",
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "Silent",
+                            "Suppress console logging of transcripts", FALSE,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_ENDPOINT,
+      g_param_spec_string ("endpoint", "Endpoint",
+                           "Deepgram streaming endpoint URL (e.g. a local "
+                           "mock server)",
+                           DEFAULT_ENDPOINT,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_QUERY_PARAMS,
+      g_param_spec_boxed ("query-params", "Query Parameters",
+                          "Extra Deepgram query parameters, e.g. "
+                          "\"params,interim_results=true,smart_format=true\"",
+                          GST_TYPE_STRUCTURE,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_INTERIM_RESULTS,
+      g_param_spec_boolean ("interim-results", "Interim results",
+                            "Output interim results too, not only final ones "
+                            "(needs interim_results=true in query-params)",
+                            DEFAULT_INTERIM_RESULTS,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_DRAIN_TIMEOUT,
+      g_param_spec_uint64 ("drain-timeout", "Drain timeout (ns)",
+                           "On EOS, max. time to wait for the final "
+                           "transcripts before forwarding EOS (0 = don't "
+                           "wait)",
+                           0, G_MAXUINT64, DEFAULT_DRAIN_TIMEOUT,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max. queue time (ns)",
+                           "Max. amount of audio waiting to be sent to "
+                           "Deepgram before upstream is blocked (0 = "
+                           "unlimited)",
+                           0, G_MAXUINT64, DEFAULT_MAX_QUEUE_TIME,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_DEDICATED_THREAD,
+      g_param_spec_boolean ("dedicated-thread", "Dedicated thread",
+                            "Serve this stream's connection from a thread of "
+                            "its own instead of the shared worker pool",
+                            DEFAULT_DEDICATED_THREAD,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (
+      gobject_class, PROP_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency (ns)",
+                           "Delay between the audio and its transcript, "
+                           "added to the upstream latency so that live "
+                           "muxers and sinks wait for the transcripts",
+                           0, G_MAXUINT64, DEFAULT_LATENCY,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (
+      element_class, "DeepgramTranscribe", "Filter/Audio/Text",
+      "Transcribes raw PCM with Deepgram via WebSockets into timestamped "
+      "text buffers.",
+      "Max Golovanchuk <mexxik@gmail.com>");
+
+  gst_element_class_add_pad_template (
+      element_class, gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (
+      element_class, gst_static_pad_template_get (&src_template));
+
+  element_class->change_state
+      = GST_DEBUG_FUNCPTR (gst_deepgram_transcribe_change_state);
+
+  GST_DEBUG_CATEGORY_INIT (gst_deepgram_transcribe_debug, "deepgramtranscribe",
+                           0, "Deepgram transcription filter");
+}
+
+static void
+gst_deepgram_transcribe_init (GstDeepgramTranscribe* self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+                              GST_DEBUG_FUNCPTR (gst_deepgram_transcribe_chain));
+  gst_pad_set_event_function (
+      self->sinkpad, GST_DEBUG_FUNCPTR (gst_deepgram_transcribe_sink_event));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_activatemode_function (
+      self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_deepgram_transcribe_src_activate_mode));
+  gst_pad_set_query_function (
+      self->srcpad, GST_DEBUG_FUNCPTR (gst_deepgram_transcribe_src_query));
+  gst_pad_use_fixed_caps (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->api_key          = NULL;
+  self->model            = g_strdup ("general");
+  self->silent           = FALSE;
+  self->endpoint         = g_strdup (DEFAULT_ENDPOINT);
+  self->query_params     = NULL;
+  self->interim_results  = DEFAULT_INTERIM_RESULTS;
+  self->drain_timeout    = DEFAULT_DRAIN_TIMEOUT;
+  self->max_queue_time   = DEFAULT_MAX_QUEUE_TIME;
+  self->dedicated_thread = DEFAULT_DEDICATED_THREAD;
+  self->latency          = DEFAULT_LATENCY;
+  self->ws               = NULL;
+  self->json             = FALSE;
+
+  gst_segment_init (&self->segment, GST_FORMAT_TIME);
+  self->anchors
+      = g_array_new (FALSE, FALSE, sizeof (GstDeepgramTranscribeAnchor));
+  self->pushed_bytes  = 0;
+  self->pending_words = NULL;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  g_queue_init (&self->queue);
+  self->flushing   = TRUE;
+  self->src_result = GST_FLOW_FLUSHING;
+}
+
+static void
+gst_deepgram_transcribe_finalize (GObject* object)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (object);
+
+  g_free (self->api_key);
+  g_free (self->model);
+  g_free (self->endpoint);
+  g_clear_pointer (&self->query_params, gst_structure_free);
+  g_array_unref (self->anchors);
+  g_clear_pointer (&self->pending_words, json_array_unref);
+
+  g_queue_clear_full (&self->queue, (GDestroyNotify)gst_mini_object_unref);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (gst_deepgram_transcribe_parent_class)->finalize (object);
+}
+
+static void
+gst_deepgram_transcribe_set_property (GObject* object, guint prop_id,
+                                      const GValue* value, GParamSpec* pspec)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (object);
+
+  switch (prop_id)
+    {
+    case PROP_API_KEY:
+      g_free (self->api_key);
+      self->api_key = g_value_dup_string (value);
+      break;
+    case PROP_MODEL:
+      g_free (self->model);
+      self->model = g_value_dup_string (value);
+      break;
+    case PROP_SILENT:
+      self->silent = g_value_get_boolean (value);
+      break;
+    case PROP_ENDPOINT:
+      g_free (self->endpoint);
+      self->endpoint = g_value_dup_string (value);
+      break;
+    case PROP_QUERY_PARAMS:
+      g_clear_pointer (&self->query_params, gst_structure_free);
+      self->query_params = g_value_dup_boxed (value);
+      break;
+    case PROP_INTERIM_RESULTS:
+      self->interim_results = g_value_get_boolean (value);
+      break;
+    case PROP_DRAIN_TIMEOUT:
+      self->drain_timeout = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      self->max_queue_time = g_value_get_uint64 (value);
+      break;
+    case PROP_DEDICATED_THREAD:
+      self->dedicated_thread = g_value_get_boolean (value);
+      break;
+    case PROP_LATENCY:
+      GST_OBJECT_LOCK (self);
+      self->latency = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      gst_element_post_message (
+          GST_ELEMENT (self),
+          gst_message_new_latency (GST_OBJECT_CAST (self)));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gst_deepgram_transcribe_get_property (GObject* object, guint prop_id,
+                                      GValue* value, GParamSpec* pspec)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (object);
+
+  switch (prop_id)
+    {
+    case PROP_API_KEY:
+      g_value_set_string (value, self->api_key);
+      break;
+    case PROP_MODEL:
+      g_value_set_string (value, self->model);
+      break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, self->silent);
+      break;
+    case PROP_ENDPOINT:
+      g_value_set_string (value, self->endpoint);
+      break;
+    case PROP_QUERY_PARAMS:
+      g_value_set_boxed (value, self->query_params);
+      break;
+    case PROP_INTERIM_RESULTS:
+      g_value_set_boolean (value, self->interim_results);
+      break;
+    case PROP_DRAIN_TIMEOUT:
+      g_value_set_uint64 (value, self->drain_timeout);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_value_set_uint64 (value, self->max_queue_time);
+      break;
+    case PROP_DEDICATED_THREAD:
+      g_value_set_boolean (value, self->dedicated_thread);
+      break;
+    case PROP_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+/* Creates the DeepgramWS from the current properties and starts connecting;
+ * Deepgram's timeline restarts at 0 with every new connection. */
+static gboolean
+gst_deepgram_transcribe_open_ws (GstDeepgramTranscribe* self)
+{
+  if (!self->api_key || strlen (self->api_key) == 0)
+    {
+      GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+                         ("No Deepgram API key set"));
+      return FALSE;
+    }
+
+  self->ws = deepgram_ws_new ();
+  g_object_set (self->ws, "api-key", self->api_key, NULL);
+  g_object_set (self->ws, "model", self->model, NULL);
+  g_object_set (self->ws, "silent", TRUE, NULL);
+  g_object_set (self->ws, "endpoint", self->endpoint, NULL);
+  g_object_set (self->ws, "query-params", self->query_params, NULL);
+  g_object_set (self->ws, "leaky", DEEPGRAM_WS_LEAKY_NO, NULL);
+  g_object_set (self->ws, "max-queue-bytes",
+                gst_util_uint64_scale (self->max_queue_time,
+                                       DEEPGRAM_TRANSCRIBE_BYTES_PER_SECOND,
+                                       GST_SECOND),
+                NULL);
+  g_object_set (self->ws, "dedicated-thread", self->dedicated_thread, NULL);
+
+  g_signal_connect (self->ws, "words",
+                    G_CALLBACK (gst_deepgram_transcribe_on_deepgram_words),
+                    self);
+  g_signal_connect (
+      self->ws, "transcript",
+      G_CALLBACK (gst_deepgram_transcribe_on_deepgram_transcript), self);
+
+  GST_OBJECT_LOCK (self);
+  g_array_set_size (self->anchors, 0);
+  self->pushed_bytes = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!deepgram_ws_start (self->ws))
+    {
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, (NULL),
+                         ("Failed to start DeepgramWS"));
+      g_clear_object (&self->ws);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gst_deepgram_transcribe_close_ws (GstDeepgramTranscribe* self)
+{
+  if (self->ws)
+    {
+      deepgram_ws_stop (self->ws);
+      g_clear_object (&self->ws);
+    }
+  g_clear_pointer (&self->pending_words, json_array_unref);
+}
+
+static GstStateChangeReturn
+gst_deepgram_transcribe_change_state (GstElement*    element,
+                                      GstStateChange transition)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (element);
+  GstStateChangeReturn   ret;
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+    {
+      gst_segment_init (&self->segment, GST_FORMAT_TIME);
+      if (!gst_deepgram_transcribe_open_ws (self))
+        return GST_STATE_CHANGE_FAILURE;
+    }
+
+  /* Wake a chain call waiting for queue space, so the sink pad can be
+   * deactivated. */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->ws)
+    deepgram_ws_set_flushing (self->ws, TRUE);
+
+  ret = GST_ELEMENT_CLASS (gst_deepgram_transcribe_parent_class)
+            ->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY
+      || (transition == GST_STATE_CHANGE_READY_TO_PAUSED
+          && ret == GST_STATE_CHANGE_FAILURE))
+    {
+      gst_deepgram_transcribe_close_ws (self);
+    }
+
+  return ret;
+}
+
+/* Hands a buffer or serialized event to the source pad task; dropped while
+ * flushing. */
+static void
+gst_deepgram_transcribe_enqueue (GstDeepgramTranscribe* self,
+                                 GstMiniObject*         item)
+{
+  g_mutex_lock (&self->lock);
+  if (self->flushing)
+    {
+      g_mutex_unlock (&self->lock);
+      gst_mini_object_unref (item);
+      return;
+    }
+  g_queue_push_tail (&self->queue, item);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_deepgram_transcribe_set_flushing (GstDeepgramTranscribe* self,
+                                      gboolean               flushing)
+{
+  g_mutex_lock (&self->lock);
+  self->flushing   = flushing;
+  self->src_result = flushing ? GST_FLOW_FLUSHING : GST_FLOW_OK;
+  if (flushing)
+    g_queue_clear_full (&self->queue, (GDestroyNotify)gst_mini_object_unref);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_deepgram_transcribe_loop (gpointer user_data)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (user_data);
+
+  g_mutex_lock (&self->lock);
+  while (g_queue_is_empty (&self->queue) && !self->flushing)
+    g_cond_wait (&self->cond, &self->lock);
+  if (self->flushing)
+    {
+      g_mutex_unlock (&self->lock);
+      gst_pad_pause_task (self->srcpad);
+      return;
+    }
+  GstMiniObject* item = g_queue_pop_head (&self->queue);
+  g_mutex_unlock (&self->lock);
+
+  if (GST_IS_EVENT (item))
+    {
+      GstEvent* event  = GST_EVENT (item);
+      gboolean  is_eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+
+      gst_pad_push_event (self->srcpad, event);
+      if (is_eos)
+        {
+          g_mutex_lock (&self->lock);
+          self->src_result = GST_FLOW_EOS;
+          g_mutex_unlock (&self->lock);
+          gst_pad_pause_task (self->srcpad);
+        }
+      return;
+    }
+
+  GstFlowReturn ret = gst_pad_push (self->srcpad, GST_BUFFER (item));
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return;
+
+  /* Reported back upstream from the next chain call. */
+  g_mutex_lock (&self->lock);
+  if (!self->flushing)
+    self->src_result = ret;
+  g_mutex_unlock (&self->lock);
+
+  if (ret == GST_FLOW_EOS || ret < GST_FLOW_EOS)
+    {
+      if (ret != GST_FLOW_EOS)
+        GST_ELEMENT_FLOW_ERROR (self, ret);
+      gst_pad_push_event (self->srcpad, gst_event_new_eos ());
+    }
+  gst_pad_pause_task (self->srcpad);
+}
+
+static gboolean
+gst_deepgram_transcribe_src_activate_mode (GstPad* pad, GstObject* parent,
+                                           GstPadMode mode, gboolean active)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (parent);
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  if (active)
+    {
+      gst_deepgram_transcribe_set_flushing (self, FALSE);
+      return gst_pad_start_task (pad, gst_deepgram_transcribe_loop, self,
+                                 NULL);
+    }
+
+  gst_deepgram_transcribe_set_flushing (self, TRUE);
+  return gst_pad_stop_task (pad);
+}
+
+/* Transcripts are timestamped with the running time of their audio but
+ * leave seconds later, so downstream has to wait that much longer than for
+ * the audio; the output is live like a capture source's. */
+static gboolean
+gst_deepgram_transcribe_src_query (GstPad* pad, GstObject* parent,
+                                   GstQuery* query)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (parent);
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_LATENCY)
+    return gst_pad_query_default (pad, parent, query);
+
+  gboolean     live = FALSE;
+  GstClockTime min  = 0;
+  GstClockTime max  = GST_CLOCK_TIME_NONE;
+
+  if (gst_pad_peer_query (self->sinkpad, query))
+    gst_query_parse_latency (query, &live, &min, &max);
+
+  GST_OBJECT_LOCK (self);
+  GstClockTime latency = self->latency;
+  GST_OBJECT_UNLOCK (self);
+
+  min += latency;
+  if (GST_CLOCK_TIME_IS_VALID (max))
+    max += latency;
+
+  GST_DEBUG_OBJECT (self,
+                    "Latency: upstream live %d, reporting min %" GST_TIME_FORMAT
+                    " max %" GST_TIME_FORMAT,
+                    live, GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+  gst_query_set_latency (query, TRUE, min, max);
+  return TRUE;
+}
+
+/* Picks text or JSON output, whichever downstream prefers. */
+static GstCaps*
+gst_deepgram_transcribe_negotiate (GstDeepgramTranscribe* self)
+{
+  GstCaps* caps = gst_pad_get_allowed_caps (self->srcpad);
+
+  if (!caps || gst_caps_is_any (caps))
+    {
+      gst_clear_caps (&caps);
+      caps = gst_pad_get_pad_template_caps (self->srcpad);
+    }
+  if (gst_caps_is_empty (caps))
+    {
+      gst_caps_unref (caps);
+      return NULL;
+    }
+
+  caps = gst_caps_fixate (caps);
+  gboolean json = gst_structure_has_name (gst_caps_get_structure (caps, 0),
+                                          "application/x-json");
+
+  g_mutex_lock (&self->lock);
+  self->json = json;
+  g_mutex_unlock (&self->lock);
+
+  return caps;
+}
+
+static gboolean
+gst_deepgram_transcribe_sink_event (GstPad* pad, GstObject* parent,
+                                    GstEvent* event)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (parent);
+
+  switch (GST_EVENT_TYPE (event))
+    {
+    case GST_EVENT_CAPS:
+      {
+        GstCaps* caps = gst_deepgram_transcribe_negotiate (self);
+        gst_event_unref (event);
+        if (!caps)
+          return FALSE;
+
+        GST_DEBUG_OBJECT (self, "Output caps %" GST_PTR_FORMAT, caps);
+        gst_deepgram_transcribe_enqueue (
+            self, GST_MINI_OBJECT_CAST (gst_event_new_caps (caps)));
+        gst_caps_unref (caps);
+        return TRUE;
+      }
+    case GST_EVENT_SEGMENT:
+      {
+        const GstSegment* segment;
+
+        gst_event_parse_segment (event, &segment);
+        if (segment->format != GST_FORMAT_TIME)
+          {
+            GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+                               ("Only TIME segments are supported"));
+            gst_event_unref (event);
+            return FALSE;
+          }
+
+        GST_OBJECT_LOCK (self);
+        gst_segment_copy_into (segment, &self->segment);
+        GST_OBJECT_UNLOCK (self);
+
+        /* Transcripts keep the running time of the audio they come from, so
+         * the output carries the input segment. */
+        gst_deepgram_transcribe_enqueue (self, GST_MINI_OBJECT_CAST (event));
+        return TRUE;
+      }
+    case GST_EVENT_GAP:
+      /* Covered by the anchor of the next buffer. */
+      gst_event_unref (event);
+      return TRUE;
+    case GST_EVENT_EOS:
+      if (self->ws && self->drain_timeout > 0)
+        {
+          GST_INFO_OBJECT (self, "EOS, waiting for final transcripts");
+          if (!deepgram_ws_drain (self->ws, self->drain_timeout))
+            GST_WARNING_OBJECT (self,
+                                "Timed out waiting for final transcripts");
+        }
+      gst_deepgram_transcribe_enqueue (self, GST_MINI_OBJECT_CAST (event));
+      return TRUE;
+    case GST_EVENT_FLUSH_START:
+      if (self->ws)
+        deepgram_ws_set_flushing (self->ws, TRUE);
+      gst_deepgram_transcribe_set_flushing (self, TRUE);
+      gst_pad_push_event (self->srcpad, event);
+      gst_pad_pause_task (self->srcpad);
+      return TRUE;
+    case GST_EVENT_FLUSH_STOP:
+      {
+        /* The audio before the seek is gone; a fresh session is simpler
+         * than reconciling Deepgram's timeline with what was discarded. */
+        gst_deepgram_transcribe_close_ws (self);
+        gboolean ret = gst_deepgram_transcribe_open_ws (self);
+
+        gst_pad_push_event (self->srcpad, event);
+        gst_deepgram_transcribe_set_flushing (self, FALSE);
+        return gst_pad_start_task (self->srcpad, gst_deepgram_transcribe_loop,
+                                   self, NULL)
+               && ret;
+      }
+    default:
+      if (GST_EVENT_IS_SERIALIZED (event))
+        {
+          gst_deepgram_transcribe_enqueue (self, GST_MINI_OBJECT_CAST (event));
+          return TRUE;
+        }
+      return gst_pad_event_default (pad, parent, event);
+    }
+}
+
+static GstFlowReturn
+gst_deepgram_transcribe_chain (GstPad* pad, GstObject* parent,
+                               GstBuffer* buffer)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (parent);
+
+  g_mutex_lock (&self->lock);
+  GstFlowReturn src_result = self->src_result;
+  g_mutex_unlock (&self->lock);
+  if (src_result != GST_FLOW_OK)
+    {
+      gst_buffer_unref (buffer);
+      return src_result;
+    }
+
+  if (!self->ws)
+    {
+      gst_buffer_unref (buffer);
+      return GST_FLOW_ERROR;
+    }
+
+  GST_OBJECT_LOCK (self);
+  GstClockTime running_time = gst_segment_to_running_time (
+      &self->segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+
+  if (GST_CLOCK_TIME_IS_VALID (running_time))
+    {
+      gboolean anchor = self->anchors->len == 0
+                        || GST_BUFFER_FLAG_IS_SET (buffer,
+                                                   GST_BUFFER_FLAG_DISCONT);
+      if (!anchor)
+        {
+          GstDeepgramTranscribeAnchor* last = &g_array_index (
+              self->anchors, GstDeepgramTranscribeAnchor,
+              self->anchors->len - 1);
+          GstClockTime expected
+              = last->running_time
+                + gst_util_uint64_scale (self->pushed_bytes - last->bytes,
+                                         GST_SECOND,
+                                         DEEPGRAM_TRANSCRIBE_BYTES_PER_SECOND);
+          anchor = GST_CLOCK_DIFF (expected, running_time)
+                       > (GstClockTimeDiff)DEEPGRAM_TRANSCRIBE_TOLERANCE
+                   || GST_CLOCK_DIFF (running_time, expected)
+                          > (GstClockTimeDiff)DEEPGRAM_TRANSCRIBE_TOLERANCE;
+        }
+      if (anchor)
+        {
+          GstDeepgramTranscribeAnchor a = { self->pushed_bytes, running_time };
+          g_array_append_val (self->anchors, a);
+        }
+    }
+  self->pushed_bytes += gst_buffer_get_size (buffer);
+  GST_OBJECT_UNLOCK (self);
+
+  GstFlowReturn ret = deepgram_ws_push_buffer (self->ws, buffer);
+  gst_buffer_unref (buffer);
+  if (ret == GST_FLOW_ERROR)
+    {
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+                         ("Failed to map audio buffer"));
+    }
+
+  return ret;
+}
+
+/* Converts a time on Deepgram's timeline (seconds of audio since the
+ * connection opened) into a position in the output segment. Anchors before
+ * a final result are not needed again and are dropped. */
+static GstClockTime
+gst_deepgram_transcribe_to_position (GstDeepgramTranscribe* self,
+                                     gdouble seconds, gboolean prune)
+{
+  GstClockTime position = GST_CLOCK_TIME_NONE;
+  guint64      bytes
+      = (guint64)(MAX (seconds, 0.0) * DEEPGRAM_TRANSCRIBE_BYTES_PER_SECOND);
+
+  GST_OBJECT_LOCK (self);
+  if (self->anchors->len > 0)
+    {
+      guint i = 0;
+      while (i + 1 < self->anchors->len
+             && g_array_index (self->anchors, GstDeepgramTranscribeAnchor,
+                               i + 1)
+                        .bytes
+                    <= bytes)
+        i++;
+
+      GstDeepgramTranscribeAnchor* a
+          = &g_array_index (self->anchors, GstDeepgramTranscribeAnchor, i);
+      GstClockTime running_time = a->running_time;
+      if (bytes >= a->bytes)
+        running_time
+            += gst_util_uint64_scale (bytes - a->bytes, GST_SECOND,
+                                      DEEPGRAM_TRANSCRIBE_BYTES_PER_SECOND);
+
+      position = gst_segment_position_from_running_time (
+          &self->segment, GST_FORMAT_TIME, running_time);
+
+      if (prune && i > 0)
+        g_array_remove_range (self->anchors, 0, i);
+    }
+  GST_OBJECT_UNLOCK (self);
+
+  return position;
+}
+
+/* Called from the connection's worker thread, right before "transcript" for
+ * the same result. */
+static void
+gst_deepgram_transcribe_on_deepgram_words (DeepgramWS* ws, GArray* words,
+                                           gboolean is_final, guint channel,
+                                           gpointer user_data)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (user_data);
+
+  g_mutex_lock (&self->lock);
+  gboolean json = self->json;
+  g_mutex_unlock (&self->lock);
+
+  g_clear_pointer (&self->pending_words, json_array_unref);
+  if (!json || (!is_final && !self->interim_results))
+    return;
+
+  self->pending_words = json_array_sized_new (words->len);
+  for (guint i = 0; i < words->len; i++)
+    {
+      DeepgramWord* word = &g_array_index (words, DeepgramWord, i);
+      JsonObject*   obj  = json_object_new ();
+
+      json_object_set_string_member (obj, "word",
+                                     word->text ? word->text : "");
+      json_object_set_double_member (obj, "start", word->start);
+      json_object_set_double_member (obj, "end", word->end);
+      json_object_set_double_member (obj, "confidence", word->confidence);
+      json_array_add_object_element (self->pending_words, obj);
+    }
+}
+
+static GstBuffer*
+gst_deepgram_transcribe_new_json_buffer (GstDeepgramTranscribe* self,
+                                         const gchar* text, gboolean is_final,
+                                         gdouble start_time, gdouble end_time)
+{
+  JsonObject* obj = json_object_new ();
+
+  json_object_set_string_member (obj, "transcript", text);
+  json_object_set_boolean_member (obj, "is_final", is_final);
+  json_object_set_double_member (obj, "start", start_time);
+  json_object_set_double_member (obj, "end", end_time);
+  json_object_set_array_member (obj, "words",
+                                self->pending_words ? self->pending_words
+                                                    : json_array_new ());
+  self->pending_words = NULL;
+
+  JsonNode* root = json_node_new (JSON_NODE_OBJECT);
+  json_node_take_object (root, obj);
+  gchar* data = json_to_string (root, FALSE);
+  json_node_unref (root);
+
+  return gst_buffer_new_wrapped (data, strlen (data));
+}
+
+/* Called from the connection's worker thread. */
+static void
+gst_deepgram_transcribe_on_deepgram_transcript (DeepgramWS* ws,
+                                                const gchar* text,
+                                                gboolean is_final,
+                                                gdouble start_time,
+                                                gdouble end_time,
+                                                guint channel,
+                                                gpointer user_data)
+{
+  GstDeepgramTranscribe* self = GST_DEEPGRAM_TRANSCRIBE (user_data);
+
+  if (!is_final && !self->interim_results)
+    return;
+
+  g_mutex_lock (&self->lock);
+  gboolean json = self->json;
+  g_mutex_unlock (&self->lock);
+
+  if (!self->silent)
+    {
+      g_print ("[deepgramtranscribe] => %s: %s\n",
+               is_final ? "Final" : "Partial", text);
+    }
+
+  GstBuffer* buffer
+      = json ? gst_deepgram_transcribe_new_json_buffer (
+                         self, text, is_final, start_time, end_time)
+                   : gst_buffer_new_wrapped (g_strdup (text), strlen (text));
+
+  GstClockTime start
+      = gst_deepgram_transcribe_to_position (self, start_time, FALSE);
+  GstClockTime end
+      = gst_deepgram_transcribe_to_position (self, end_time, is_final);
+
+  GST_BUFFER_PTS (buffer) = start;
+  if (GST_CLOCK_TIME_IS_VALID (start) && GST_CLOCK_TIME_IS_VALID (end)
+      && end > start)
+    GST_BUFFER_DURATION (buffer) = end - start;
+  if (!is_final)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  GST_LOG_OBJECT (self, "%s transcript at %" GST_TIME_FORMAT ": %s",
+                  is_final ? "Final" : "Interim", GST_TIME_ARGS (start), text);
+
+  gst_deepgram_transcribe_enqueue (self, GST_MINI_OBJECT_CAST (buffer));
+}
@@ -0,0 +1,14 @@
+#ifndef __GST_DEEPGRAM_TRANSCRIBE_H__
+#define __GST_DEEPGRAM_TRANSCRIBE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_DEEPGRAM_TRANSCRIBE (gst_deepgram_transcribe_get_type())
+G_DECLARE_FINAL_TYPE (GstDeepgramTranscribe, gst_deepgram_transcribe, GST,
+                      DEEPGRAM_TRANSCRIBE, GstElement)
+
+G_END_DECLS
+
+#endif /* __GST_DEEPGRAM_TRANSCRIBE_H__ */